@@ -8,6 +8,7 @@
 #include "flow_graph.h"
 #include "utils/unreachable.h"
 #include "utils/mallocs.h"
+#include "utils/stack.h"
 
 
 static void raise_error(
@@ -326,9 +327,52 @@ static struct flow_graph_expr * check_assignable(
     return expr;
 }
 
+// значение с побочными эффектами вычисляется в левой части присваивания во временную переменную,
+// а повторное чтение в правой части берёт переменную; тип переменной назначает fill_expr_type
+static void bind_value(
+        struct flow_graph_subroutine * subroutine,
+        struct flow_graph_expr ** value,
+        struct flow_graph_expr ** read
+) {
+    if (flow_graph_expr_is_pure(*value)) {
+        return;
+    }
+
+    const struct position position = (*value)->position;
+    struct flow_graph_local * const temp = flow_graph_subroutine_add_temp(subroutine, NULL, position);
+
+    *value = flow_graph_expr_new_binary(
+            position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_local(position, temp),
+            *value
+    );
+
+    flow_graph_expr_delete(*read);
+    *read = flow_graph_expr_new_local(position, temp);
+}
+
+// составное присваивание и ++/-- разворачиваются в place = read op value, где read - второй разбор
+// левой части; массив и индексы с побочными эффектами должны вычисляться один раз
+static void bind_place(
+        struct flow_graph_subroutine * subroutine,
+        struct flow_graph_expr * place,
+        struct flow_graph_expr * read
+) {
+    if (!place || place->_type != FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+        return;
+    }
+
+    bind_value(subroutine, &place->indexer.value, &read->indexer.value);
+
+    for (size_t i = 0; i < place->indexer.indices.size; ++i) {
+        bind_value(subroutine, &place->indexer.indices.values[i], &read->indexer.indices.values[i]);
+    }
+}
+
 static struct flow_graph_expr * analyze_expr(
         const struct ast_analyze_context * context,
-        const struct flow_graph_subroutine * subroutine,
+        struct flow_graph_subroutine * subroutine,
         const struct ast_expr * expr,
         struct ast_analyze_error_list * errors
 ) {
@@ -395,12 +439,12 @@ static struct flow_graph_expr * analyze_expr(
             );
 
             if (assignment) {
-                return flow_graph_expr_new_binary(
-                        expr->position,
-                        FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
-                        check_assignable(subroutine, analyze_expr(context, subroutine, expr->binary.lhs, errors), errors),
-                        result
-                );
+                struct flow_graph_expr * const place =
+                        check_assignable(subroutine, analyze_expr(context, subroutine, expr->binary.lhs, errors), errors);
+
+                bind_place(subroutine, place, result->binary.lhs);
+
+                return flow_graph_expr_new_binary(expr->position, FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT, place, result);
             }
 
             return result;
@@ -418,36 +462,29 @@ static struct flow_graph_expr * analyze_expr(
                     );
 
                 case AST_EXPR_UNARY_OP_INC:
-                    return flow_graph_expr_new_binary(
-                            expr->position,
-                            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
-                            analyze_expr(context, subroutine, expr->unary.expr, errors),
-                            flow_graph_expr_new_binary(
-                                    expr->position,
-                                    FLOW_GRAPH_EXPR_BINARY_OP_PLUS,
-                                    analyze_expr(context, subroutine, expr->unary.expr, errors),
-                                    flow_graph_expr_new_literal(
-                                            expr->position,
-                                            flow_graph_literal_new_int(expr->position, 1)
-                                    )
-                            )
-                    );
+                case AST_EXPR_UNARY_OP_DEC: {
+                    struct flow_graph_expr * const place = analyze_expr(context, subroutine, expr->unary.expr, errors);
+                    struct flow_graph_expr * const read = analyze_expr(context, subroutine, expr->unary.expr, errors);
+
+                    bind_place(subroutine, place, read);
 
-                case AST_EXPR_UNARY_OP_DEC:
                     return flow_graph_expr_new_binary(
                             expr->position,
                             FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
-                            analyze_expr(context, subroutine, expr->unary.expr, errors),
+                            place,
                             flow_graph_expr_new_binary(
                                     expr->position,
-                                    FLOW_GRAPH_EXPR_BINARY_OP_MINUS,
-                                    analyze_expr(context, subroutine, expr->unary.expr, errors),
+                                    expr->unary.op == AST_EXPR_UNARY_OP_INC
+                                            ? FLOW_GRAPH_EXPR_BINARY_OP_PLUS
+                                            : FLOW_GRAPH_EXPR_BINARY_OP_MINUS,
+                                    read,
                                     flow_graph_expr_new_literal(
                                             expr->position,
                                             flow_graph_literal_new_int(expr->position, 1)
                                     )
                             )
                     );
+                }
             }
 
         case AST_EXPR_TYPE_BRACES:
@@ -711,29 +748,6 @@ static void remove_nops(struct flow_graph_node ** node_next) {
     }
 }
 
-static void assign_indexes(struct flow_graph_node * node, size_t * index) {
-    if (!node) {
-        return;
-    }
-
-    if (node->index) {
-        return;
-    }
-
-    node->index = ++(*index);
-
-    switch (node->_type) {
-        case FLOW_GRAPH_NODE_TYPE_EXPR:
-            assign_indexes(node->expr.next, index);
-            break;
-
-        case FLOW_GRAPH_NODE_TYPE_COND:
-            assign_indexes(node->cond.then_next, index);
-            assign_indexes(node->cond.else_next, index);
-            break;
-    }
-}
-
 static struct ast_type_reference * default_type(struct position position) {
     return ast_type_reference_new_builtin(position, AST_TYPE_REFERENCE_BUILTIN_TYPE_INT);
 }
@@ -776,16 +790,10 @@ static struct ast_type_reference * get_literal_type(const struct flow_graph_lite
     unreachable();
 }
 
-static void fill_types(const char * filename, struct flow_graph_expr * expr, struct ast_analyze_error_list * errors) {
-    if (!expr) {
-        return;
-    }
-
+// типы операндов к этому моменту уже заполнены, см. fill_types
+static void fill_expr_type(const char * filename, struct flow_graph_expr * expr, struct ast_analyze_error_list * errors) {
     switch (expr->_type) {
-        case FLOW_GRAPH_EXPR_TYPE_BINARY:
-            fill_types(filename, expr->binary.lhs, errors);
-            fill_types(filename, expr->binary.rhs, errors);
-
+        case FLOW_GRAPH_EXPR_TYPE_BINARY: {
             const bool boo = ast_type_reference_is_bool(expr->binary.lhs->type)
                     && ast_type_reference_is_bool(expr->binary.rhs->type);
             const bool num = ast_type_reference_is_numeric(expr->binary.lhs->type)
@@ -793,6 +801,14 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
 
             switch (expr->binary.op) {
                 case FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT:
+                    // временная переменная из bind_value получает тип значения, которое в неё вычисляется
+                    if (!expr->binary.lhs->type) {
+                        struct flow_graph_local * const temp = expr->binary.lhs->local.local;
+
+                        temp->type = ast_type_reference_clone(expr->binary.rhs->type);
+                        expr->binary.lhs->type = ast_type_reference_clone(temp->type);
+                    }
+
                     if (!ast_type_reference_is_subtype(expr->binary.rhs->type, expr->binary.lhs->type)) {
                         raise_error("value type must be subtype of variable type", filename, expr->position, errors);
                     }
@@ -843,10 +859,10 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
             }
 
             break;
+        }
 
         case FLOW_GRAPH_EXPR_TYPE_UNARY: {
             struct flow_graph_expr * const value = expr->unary.value;
-            fill_types(filename, value, errors);
 
             switch (expr->unary.op) {
                 case FLOW_GRAPH_EXPR_UNARY_OP_NOT:
@@ -879,8 +895,6 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
                 for (size_t i = 0; i < expr->call.args.size; ++i) {
                     struct flow_graph_expr * const arg = expr->call.args.values[i];
 
-                    fill_types(filename, arg, errors);
-
                     if (!ast_type_reference_is_subtype(arg->type, expr->call.subroutine->locals.values[i]->type)) {
                         raise_error("incorrect type of argument", filename, arg->position, errors);
                     }
@@ -891,8 +905,6 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
             break;
 
         case FLOW_GRAPH_EXPR_TYPE_INDEXER:
-            fill_types(filename, expr->indexer.value, errors);
-
             if (expr->indexer.value->type->_type != AST_TYPE_REFERENCE_TYPE_ARRAY) {
                 raise_error("cannot index non-array type", filename, expr->position, errors);
 
@@ -908,8 +920,6 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
             for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
                 struct flow_graph_expr * const index = expr->indexer.indices.values[i];
 
-                fill_types(filename, index, errors);
-
                 if (!ast_type_reference_is_numeric(index->type)) {
                     raise_error("index type must be numeric", filename, index->position, errors);
                 }
@@ -918,7 +928,7 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
             break;
 
         case FLOW_GRAPH_EXPR_TYPE_LOCAL:
-            assert(expr->local.local->type);
+            // без типа только временная переменная до присваивания, которое её определяет, см. bind_value
             expr->type = ast_type_reference_clone(expr->local.local->type);
             break;
 
@@ -928,6 +938,66 @@ static void fill_types(const char * filename, struct flow_graph_expr * expr, str
     }
 }
 
+static void push_operands(struct stack * stack, struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            stack_push(stack, expr->binary.lhs);
+            stack_push(stack, expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            stack_push(stack, expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            for (size_t i = 0; i < expr->call.args.size; ++i) {
+                stack_push(stack, expr->call.args.values[i]);
+            }
+
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            stack_push(stack, expr->indexer.value);
+
+            for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                stack_push(stack, expr->indexer.indices.values[i]);
+            }
+
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            break;
+    }
+}
+
+// операнды кладутся на стек слева направо и извлекаются справа налево, поэтому развёрнутый
+// порядок извлечения - обход в обратном порядке: сначала операнды слева направо, затем операция
+static void fill_types(const char * filename, struct flow_graph_expr * expr, struct ast_analyze_error_list * errors) {
+    struct stack stack = stack_init();
+    struct stack order = stack_init();
+
+    stack_push(&stack, expr);
+
+    while (stack.size > 0) {
+        struct flow_graph_expr * const value = stack_pop(&stack);
+
+        if (!value) {
+            continue;
+        }
+
+        stack_push(&order, value);
+        push_operands(&stack, value);
+    }
+
+    while (order.size > 0) {
+        fill_expr_type(filename, stack_pop(&order), errors);
+    }
+
+    stack_fini(&order);
+    stack_fini(&stack);
+}
+
 static void check_return_types(
         const struct flow_graph_subroutine * subroutine,
         const struct flow_graph_node * node,
@@ -994,25 +1064,6 @@ static struct flow_graph_subroutine * lookup_subroutine(
     return NULL;
 }
 
-static int node_cmp(const void * lhsp, const void * rhsp) {
-    const struct flow_graph_node * const lhs = *(struct flow_graph_node **) lhsp;
-    const struct flow_graph_node * const rhs = *(struct flow_graph_node **) rhsp;
-
-    if (lhs->index == 0) {
-        return (int) (rhs->index - lhs->index);
-    }
-
-    if (rhs->index == 0) {
-        return -(int) (lhs->index - rhs->index);
-    }
-
-    if (lhs->index < rhs->index) {
-        return -1;
-    }
-
-    return (int) (lhs->index - rhs->index);
-}
-
 void ast_analyze(
         const struct ast_analyze_source_list * sources,
         struct flow_graph_subroutine_list * subroutines,
@@ -1117,48 +1168,16 @@ void ast_analyze(
         }
     }
 
-    // проставляем номера вершинам в порядке вызова
+    // проставляем номера вершинам в порядке вызова и удаляем недостижимые вершины
 
     for (size_t i = 0; i < subroutines->size; ++i) {
-        const struct flow_graph_subroutine * const subroutine = subroutines->values[i];
-
-        if (subroutine->nodes.size == 0) {
-            continue;
-        }
-
-        size_t index = 0;
-        assign_indexes(subroutine->nodes.values[0], &index);
+        flow_graph_subroutine_renumber(subroutines->values[i]);
     }
 
     if (errors->size > 0) {
         goto end;
     }
 
-    // удаляем недостижимые вершины
-
-    for (size_t i = 0; i < subroutines->size; ++i) {
-        struct flow_graph_subroutine * const subroutine = subroutines->values[i];
-
-        if (!subroutine->nodes.size) {
-            continue;
-        }
-
-        qsort(subroutine->nodes.values, subroutine->nodes.size, sizeof(struct flow_graph_node *), node_cmp);
-
-        while (subroutine->nodes.size) {
-            const size_t j = subroutine->nodes.size - 1;
-
-            if (subroutine->nodes.values[j]->index) {
-                break;
-            }
-
-            flow_graph_node_delete(subroutine->nodes.values[j]);
-            subroutine->nodes.values[j] = NULL;
-
-            --subroutine->nodes.size;
-        }
-    }
-
     // заполнение выражений типами, проверка типов, проверка количества аргументов в вызовах функций и индексации
 
     for (size_t i = 0; i < subroutines->size; ++i) {
@@ -1199,6 +1218,12 @@ void ast_analyze(
         }
     }
 
+    // разбиваем графы на линейные участки
+
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        flow_graph_subroutine_build_blocks(subroutines->values[i]);
+    }
+
 end:
     ast_analyze_context_fini(&global_context);
 }
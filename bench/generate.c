@@ -0,0 +1,254 @@
+#include "generate.h"
+
+
+const char * const BENCH_SCENARIO_NAME[] = {
+        [BENCH_SCENARIO_FUNCTIONS] = "functions",
+        [BENCH_SCENARIO_EXPRESSIONS] = "expressions",
+        [BENCH_SCENARIO_STATEMENTS] = "statements",
+        [BENCH_SCENARIO_NESTING] = "nesting",
+        [BENCH_SCENARIO_LOCALS] = "locals",
+        [BENCH_SCENARIO_STRINGS] = "strings",
+};
+
+const size_t BENCH_SCENARIO_BASE_SIZE[] = {
+        [BENCH_SCENARIO_FUNCTIONS] = 250,
+        [BENCH_SCENARIO_EXPRESSIONS] = 500,
+        [BENCH_SCENARIO_STATEMENTS] = 1000,
+        [BENCH_SCENARIO_NESTING] = 50,
+        [BENCH_SCENARIO_LOCALS] = 250,
+        [BENCH_SCENARIO_STRINGS] = 16384,
+};
+
+static const char * const EXPR_OPS[] = { "+", "*", "-", "^", "|", "/", "%", "&" };
+
+#define EXPR_OPS_COUNT (sizeof(EXPR_OPS) / sizeof(EXPR_OPS[0]))
+
+static void generate_builtins(FILE * output) {
+    fputs("char read();\n", output);
+    fputs("write(char c);\n", output);
+    fputs("write_str(string str);\n", output);
+    fputs("int[] new_int_array(ulong size);\n", output);
+    fputs("ulong get_int_array_size(int[] array);\n", output);
+    fputs("\n", output);
+}
+
+// main возвращает int, поэтому последним выражением должен быть вызов с подходящим типом
+static void generate_main_end(FILE * output) {
+    fputs("    write_str(\"\\n\");\n}\n", output);
+}
+
+// операнд для цепочки выражений: литералы не больше 255, чтобы иметь тип byte
+// и быть подтипом ulong, делители не равны нулю
+static void generate_operand(size_t i, FILE * output) {
+    switch (i % 3) {
+        case 0:
+            fputs("a", output);
+            break;
+
+        case 1:
+            fputs("b", output);
+            break;
+
+        default:
+            fprintf(output, "%zu", 1 + i % 250);
+            break;
+    }
+}
+
+static void generate_functions(size_t size, FILE * output) {
+    for (size_t i = 0; i < size; ++i) {
+        fprintf(output, "ulong f_%zu(ulong a, ulong b) {\n", i);
+        fputs("    ulong c = a + b * 3;\n", output);
+        fputs("    if (c > 100) {\n", output);
+        fputs("        c = c / 2;\n", output);
+        fputs("    } else {\n", output);
+
+        if (i > 0) {
+            fprintf(output, "        c = c + f_%zu(a, %zu);\n", i - 1, i % 200);
+        } else {
+            fputs("        c = c + 1;\n", output);
+        }
+
+        fputs("    }\n", output);
+        fputs("    while (c > 50) {\n", output);
+        fputs("        c = c - 7;\n", output);
+        fputs("    }\n", output);
+        fputs("    c;\n", output);
+        fputs("}\n\n", output);
+    }
+
+    fprintf(output, "main() {\n    f_%zu(1, 2);\n", size ? size - 1 : 0);
+    generate_main_end(output);
+}
+
+static void generate_expressions(size_t size, FILE * output) {
+    fputs("ulong chain(ulong a, ulong b) {\n", output);
+    fputs("    ulong x = a", output);
+
+    for (size_t i = 0; i < size; ++i) {
+        if (i % 16 == 15) {
+            fputs("\n       ", output);
+        }
+
+        const char * const op = EXPR_OPS[i % EXPR_OPS_COUNT];
+
+        fprintf(output, " %s ", op);
+
+        if (op[0] == '/' || op[0] == '%') {
+            fprintf(output, "%zu", 1 + i % 250);
+        } else {
+            generate_operand(i, output);
+        }
+    }
+
+    fputs(";\n    x;\n}\n\n", output);
+    fputs("main() {\n    chain(3, 4);\n", output);
+    generate_main_end(output);
+}
+
+static void generate_statements(size_t size, FILE * output) {
+    fputs("ulong statements(ulong a, ulong b) {\n", output);
+    fputs("    ulong x = a;\n", output);
+
+    for (size_t i = 0; i < size; ++i) {
+        switch (i % 4) {
+            case 0:
+                fprintf(output, "    x = x + %zu;\n", i % 250);
+                break;
+
+            case 1:
+                fputs("    x = x * b;\n", output);
+                break;
+
+            case 2:
+                fprintf(output, "    x = x %% %zu;\n", 1 + i % 250);
+                break;
+
+            default:
+                fputs("    b = b + 1;\n", output);
+                break;
+        }
+    }
+
+    fputs("    x;\n}\n\n", output);
+    fputs("main() {\n    statements(3, 4);\n", output);
+    generate_main_end(output);
+}
+
+static void generate_indent(size_t depth, FILE * output) {
+    for (size_t i = 0; i <= depth; ++i) {
+        fputs("    ", output);
+    }
+}
+
+static void generate_nesting(size_t size, FILE * output) {
+    fputs("ulong nesting(ulong x) {\n", output);
+
+    for (size_t i = 0; i < size; ++i) {
+        generate_indent(i, output);
+
+        switch (i % 3) {
+            case 0:
+                fputs("if (x > 0) {\n", output);
+                break;
+
+            case 1:
+                fputs("while (x > 200) {\n", output);
+                break;
+
+            default:
+                fputs("{\n", output);
+                generate_indent(i + 1, output);
+                fprintf(output, "ulong y_%zu = x + 1;\n", i);
+                generate_indent(i + 1, output);
+                fprintf(output, "x = y_%zu;\n", i);
+                break;
+        }
+
+        generate_indent(i + 1, output);
+        fputs("x = x - 1;\n", output);
+    }
+
+    for (size_t i = size; i > 0; --i) {
+        generate_indent(i - 1, output);
+        fputs("}\n", output);
+    }
+
+    fputs("    x;\n}\n\n", output);
+    fputs("main() {\n    nesting(3);\n", output);
+    generate_main_end(output);
+}
+
+static void generate_locals(size_t size, FILE * output) {
+    fputs("ulong locals(ulong a) {\n", output);
+    fputs("    ulong v_0 = a;\n", output);
+
+    for (size_t i = 1; i < size; ++i) {
+        fprintf(output, "    ulong v_%zu = v_%zu + %zu;\n", i, i - 1, i % 250);
+    }
+
+    fprintf(output, "    v_%zu;\n}\n\n", size ? size - 1 : 0);
+    fputs("main() {\n    locals(3);\n", output);
+    generate_main_end(output);
+}
+
+static void generate_strings(size_t size, FILE * output) {
+    fputs("main() {\n", output);
+
+    // строка разбивается на литералы по 4 КиБ, чтобы были и длинные литералы, и много констант
+    const size_t chunk = 4096;
+
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        fputs("    write_str(\"", output);
+
+        for (size_t i = offset; i < size && i < offset + chunk; ++i) {
+            switch (i % 64) {
+                case 31:
+                    fputs("\\n", output);
+                    break;
+
+                case 63:
+                    fputs("\\\"", output);
+                    break;
+
+                default:
+                    fputc('a' + (int) (i % 26), output);
+                    break;
+            }
+        }
+
+        fputs("\");\n", output);
+    }
+
+    generate_main_end(output);
+}
+
+void bench_generate(enum bench_scenario scenario, size_t size, FILE * output) {
+    generate_builtins(output);
+
+    switch (scenario) {
+        case BENCH_SCENARIO_FUNCTIONS:
+            generate_functions(size, output);
+            break;
+
+        case BENCH_SCENARIO_EXPRESSIONS:
+            generate_expressions(size, output);
+            break;
+
+        case BENCH_SCENARIO_STATEMENTS:
+            generate_statements(size, output);
+            break;
+
+        case BENCH_SCENARIO_NESTING:
+            generate_nesting(size, output);
+            break;
+
+        case BENCH_SCENARIO_LOCALS:
+            generate_locals(size, output);
+            break;
+
+        case BENCH_SCENARIO_STRINGS:
+            generate_strings(size, output);
+            break;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+
+enum bench_scenario {
+
+    BENCH_SCENARIO_FUNCTIONS = 0,
+    BENCH_SCENARIO_EXPRESSIONS,
+    BENCH_SCENARIO_STATEMENTS,
+    BENCH_SCENARIO_NESTING,
+    BENCH_SCENARIO_LOCALS,
+    BENCH_SCENARIO_STRINGS,
+};
+
+#define BENCH_SCENARIOS_COUNT (BENCH_SCENARIO_STRINGS + 1)
+
+extern const char * const BENCH_SCENARIO_NAME[];
+
+// базовый размер сценария, который умножается на масштаб замера
+extern const size_t BENCH_SCENARIO_BASE_SIZE[];
+
+void bench_generate(enum bench_scenario scenario, size_t size, FILE * output);
@@ -8,6 +8,7 @@
 
 static const char * const OPCODE_NAME[] = {
         [CODEGEN_ASM_OP_OPCODE_CONST] = "const",
+        [CODEGEN_ASM_OP_OPCODE_DUP] = "dup",
         [CODEGEN_ASM_OP_OPCODE_LOAD] = "load",
         [CODEGEN_ASM_OP_OPCODE_STORE] = "store",
         [CODEGEN_ASM_OP_OPCODE_GET] = "get",
@@ -20,6 +21,8 @@ static const char * const OPCODE_NAME[] = {
         [CODEGEN_ASM_OP_OPCODE_MUL] = "mul",
         [CODEGEN_ASM_OP_OPCODE_DIV] = "div",
         [CODEGEN_ASM_OP_OPCODE_REM] = "rem",
+        [CODEGEN_ASM_OP_OPCODE_DIVMOD] = "divmod",
+        [CODEGEN_ASM_OP_OPCODE_MULHU] = "mulhu",
         [CODEGEN_ASM_OP_OPCODE_AND] = "andb",
         [CODEGEN_ASM_OP_OPCODE_OR] = "orb",
         [CODEGEN_ASM_OP_OPCODE_XOR] = "xorb",
@@ -30,6 +33,11 @@ static const char * const OPCODE_NAME[] = {
         [CODEGEN_ASM_OP_OPCODE_IFZ] = "ifz",
         [CODEGEN_ASM_OP_OPCODE_CALL] = "call",
         [CODEGEN_ASM_OP_OPCODE_RET] = "ret",
+        [CODEGEN_ASM_OP_OPCODE_JUMP] = "jump",
+        [CODEGEN_ASM_OP_OPCODE_ENTER] = "enter",
+        [CODEGEN_ASM_OP_OPCODE_LEAVE] = "leave",
+        [CODEGEN_ASM_OP_OPCODE_SLIDE] = "slide",
+        [CODEGEN_ASM_OP_OPCODE_PUT] = "put",
         [CODEGEN_ASM_OP_OPCODE_NOP] = "nop",
         [CODEGEN_ASM_OP_OPCODE_HLT] = "hlt",
         [CODEGEN_ASM_OP_OPCODE_IN] = "in",
@@ -105,9 +113,16 @@ void codegen_asm_print(struct codegen_asm value, FILE * file) {
                 case CODEGEN_ASM_OP_OPCODE_CONST:
                 case CODEGEN_ASM_OP_OPCODE_LOAD:
                 case CODEGEN_ASM_OP_OPCODE_STORE:
+                case CODEGEN_ASM_OP_OPCODE_ENTER:
+                case CODEGEN_ASM_OP_OPCODE_LEAVE:
+                case CODEGEN_ASM_OP_OPCODE_PUT:
                     fprintf(file, "%s %d", OPCODE_NAME[value.op.opcode], value.op.imm8);
                     break;
 
+                case CODEGEN_ASM_OP_OPCODE_SLIDE:
+                    fprintf(file, "%s %d, %d", OPCODE_NAME[value.op.opcode], value.op.slide.size, value.op.slide.offset);
+                    break;
+
                 case CODEGEN_ASM_OP_OPCODE_GET:
                 case CODEGEN_ASM_OP_OPCODE_SET:
                     fprintf(file, "%s %s", OPCODE_NAME[value.op.opcode], REG_NAME[value.op.reg]);
@@ -119,17 +134,21 @@ void codegen_asm_print(struct codegen_asm value, FILE * file) {
                     fprintf(file, "%s %d", OPCODE_NAME[value.op.opcode], value.op.imm2);
                     break;
 
+                case CODEGEN_ASM_OP_OPCODE_DUP:
                 case CODEGEN_ASM_OP_OPCODE_ADD:
                 case CODEGEN_ASM_OP_OPCODE_SUB:
                 case CODEGEN_ASM_OP_OPCODE_MUL:
                 case CODEGEN_ASM_OP_OPCODE_DIV:
                 case CODEGEN_ASM_OP_OPCODE_REM:
+                case CODEGEN_ASM_OP_OPCODE_DIVMOD:
+                case CODEGEN_ASM_OP_OPCODE_MULHU:
                 case CODEGEN_ASM_OP_OPCODE_AND:
                 case CODEGEN_ASM_OP_OPCODE_OR:
                 case CODEGEN_ASM_OP_OPCODE_XOR:
                 case CODEGEN_ASM_OP_OPCODE_SHL:
                 case CODEGEN_ASM_OP_OPCODE_SHR:
                 case CODEGEN_ASM_OP_OPCODE_RET:
+                case CODEGEN_ASM_OP_OPCODE_JUMP:
                 case CODEGEN_ASM_OP_OPCODE_IN:
                 case CODEGEN_ASM_OP_OPCODE_OUT:
                 case CODEGEN_ASM_OP_OPCODE_NOP:
@@ -182,9 +201,16 @@ struct codegen_asm codegen_asm_clone(struct codegen_asm value) {
                 case CODEGEN_ASM_OP_OPCODE_CONST:
                 case CODEGEN_ASM_OP_OPCODE_LOAD:
                 case CODEGEN_ASM_OP_OPCODE_STORE:
+                case CODEGEN_ASM_OP_OPCODE_ENTER:
+                case CODEGEN_ASM_OP_OPCODE_LEAVE:
+                case CODEGEN_ASM_OP_OPCODE_PUT:
                     result.op.imm8 = value.op.imm8;
                     break;
 
+                case CODEGEN_ASM_OP_OPCODE_SLIDE:
+                    result.op.slide = value.op.slide;
+                    break;
+
                 case CODEGEN_ASM_OP_OPCODE_GET:
                 case CODEGEN_ASM_OP_OPCODE_SET:
                     result.op.reg = value.op.reg;
@@ -196,17 +222,21 @@ struct codegen_asm codegen_asm_clone(struct codegen_asm value) {
                     result.op.imm2 = value.op.imm2;
                     break;
 
+                case CODEGEN_ASM_OP_OPCODE_DUP:
                 case CODEGEN_ASM_OP_OPCODE_ADD:
                 case CODEGEN_ASM_OP_OPCODE_SUB:
                 case CODEGEN_ASM_OP_OPCODE_MUL:
                 case CODEGEN_ASM_OP_OPCODE_DIV:
                 case CODEGEN_ASM_OP_OPCODE_REM:
+                case CODEGEN_ASM_OP_OPCODE_DIVMOD:
+                case CODEGEN_ASM_OP_OPCODE_MULHU:
                 case CODEGEN_ASM_OP_OPCODE_AND:
                 case CODEGEN_ASM_OP_OPCODE_OR:
                 case CODEGEN_ASM_OP_OPCODE_XOR:
                 case CODEGEN_ASM_OP_OPCODE_SHL:
                 case CODEGEN_ASM_OP_OPCODE_SHR:
                 case CODEGEN_ASM_OP_OPCODE_RET:
+                case CODEGEN_ASM_OP_OPCODE_JUMP:
                 case CODEGEN_ASM_OP_OPCODE_NOP:
                 case CODEGEN_ASM_OP_OPCODE_HLT:
                 case CODEGEN_ASM_OP_OPCODE_IN:
@@ -17,6 +17,7 @@ enum codegen_asm_type {
 enum codegen_asm_op_opcode {
 
     CODEGEN_ASM_OP_OPCODE_CONST = 0,
+    CODEGEN_ASM_OP_OPCODE_DUP,
     CODEGEN_ASM_OP_OPCODE_LOAD,
     CODEGEN_ASM_OP_OPCODE_STORE,
     CODEGEN_ASM_OP_OPCODE_GET,
@@ -29,6 +30,8 @@ enum codegen_asm_op_opcode {
     CODEGEN_ASM_OP_OPCODE_MUL,
     CODEGEN_ASM_OP_OPCODE_DIV,
     CODEGEN_ASM_OP_OPCODE_REM,
+    CODEGEN_ASM_OP_OPCODE_DIVMOD,
+    CODEGEN_ASM_OP_OPCODE_MULHU,
     CODEGEN_ASM_OP_OPCODE_AND,
     CODEGEN_ASM_OP_OPCODE_OR,
     CODEGEN_ASM_OP_OPCODE_XOR,
@@ -39,6 +42,11 @@ enum codegen_asm_op_opcode {
     CODEGEN_ASM_OP_OPCODE_IFZ,
     CODEGEN_ASM_OP_OPCODE_CALL,
     CODEGEN_ASM_OP_OPCODE_RET,
+    CODEGEN_ASM_OP_OPCODE_JUMP,
+    CODEGEN_ASM_OP_OPCODE_ENTER,
+    CODEGEN_ASM_OP_OPCODE_LEAVE,
+    CODEGEN_ASM_OP_OPCODE_SLIDE,
+    CODEGEN_ASM_OP_OPCODE_PUT,
     CODEGEN_ASM_OP_OPCODE_NOP,
     CODEGEN_ASM_OP_OPCODE_HLT,
     CODEGEN_ASM_OP_OPCODE_IN,
@@ -71,6 +79,12 @@ struct codegen_asm_op {
         char * label;
         enum codegen_asm_op_reg reg;
         enum codegen_asm_op_cmp cmp;
+
+        // slide: size байт с вершины стека переносятся на offset байт вверх
+        struct {
+            uint8_t size;
+            uint8_t offset;
+        } slide;
     };
 };
 
@@ -0,0 +1,109 @@
+#include "frames.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flow_graph/call_graph.h"
+#include "utils/mallocs.h"
+
+
+static int compare_frames(const void * lhs, const void * rhs) {
+    const struct codegen_frame * const lhs_frame = lhs;
+    const struct codegen_frame * const rhs_frame = rhs;
+
+    return lhs_frame->subroutine < rhs_frame->subroutine ? -1 : lhs_frame->subroutine > rhs_frame->subroutine;
+}
+
+struct codegen_frames codegen_frames_build(
+        const struct flow_graph_subroutine_list * subroutines,
+        struct codegen_slots * slots,
+        bool enabled
+) {
+    const size_t size = subroutines->size;
+
+    struct codegen_frames result = {
+        .size = size,
+        .values = mallocs(sizeof(struct codegen_frame) * (size ? size : 1)),
+        .area_size = 0,
+    };
+
+    for (size_t i = 0; i < size; ++i) {
+        result.values[i] = (struct codegen_frame) { .subroutine = subroutines->values[i], .slots = slots[i] };
+    }
+
+    if (enabled && size > 0) {
+        struct flow_graph_call_graph graph = flow_graph_call_graph_build(subroutines);
+        const size_t * const order = graph.order;
+        const size_t * const component_of = graph.component_of;
+        const bool * const recursive = graph.recursive;
+
+        // кадр кладётся выше кадров всех подпрограмм, из которых подпрограмму можно вызвать:
+        // компоненты обходятся от вызывающих к вызываемым, и конец кадра проталкивается по дугам
+        size_t * const bases = mallocs(sizeof(size_t) * size);
+        memset(bases, 0, sizeof(size_t) * size);
+
+        for (size_t end = size; end > 0;) {
+            size_t begin = end - 1;
+
+            while (begin > 0 && component_of[order[begin - 1]] == component_of[order[end - 1]]) {
+                --begin;
+            }
+
+            size_t base = 0;
+
+            for (size_t i = begin; i < end; ++i) {
+                base = bases[order[i]] > base ? bases[order[i]] : base;
+            }
+
+            for (size_t i = begin; i < end; ++i) {
+                const size_t v = order[i];
+                const bool is_static = subroutines->values[v]->defined && !recursive[v];
+                const size_t frame_end = base + (is_static ? slots[v].size : 0);
+
+                result.values[v].is_static = is_static;
+                result.values[v].offset = base;
+
+                if (frame_end > result.area_size) {
+                    result.area_size = frame_end;
+                }
+
+                for (size_t k = graph.offsets[v]; k < graph.offsets[v + 1]; ++k) {
+                    const size_t w = graph.values[k];
+
+                    if (component_of[w] != component_of[v] && frame_end > bases[w]) {
+                        bases[w] = frame_end;
+                    }
+                }
+            }
+
+            end = begin;
+        }
+
+        free(bases);
+        flow_graph_call_graph_fini(&graph);
+    }
+
+    qsort(result.values, size, sizeof(struct codegen_frame), compare_frames);
+    return result;
+}
+
+void codegen_frames_fini(struct codegen_frames * frames) {
+    for (size_t i = 0; i < frames->size; ++i) {
+        codegen_slots_fini(&frames->values[i].slots);
+    }
+
+    free(frames->values);
+}
+
+const struct codegen_frame * codegen_frames_get(
+        const struct codegen_frames * frames,
+        const struct flow_graph_subroutine * subroutine
+) {
+    const struct codegen_frame key = { .subroutine = subroutine };
+    return bsearch(&key, frames->values, frames->size, sizeof(struct codegen_frame), compare_frames);
+}
+
+bool codegen_frames_is_static(const struct codegen_frames * frames, const struct flow_graph_subroutine * subroutine) {
+    const struct codegen_frame * const frame = codegen_frames_get(frames, subroutine);
+    return frame && frame->is_static;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "flow_graph.h"
+#include "slots.h"
+
+
+// подпрограмма, которая не входит в цикл графа вызовов, не бывает активна дважды: её переменные лежат
+// по постоянным адресам в общей области кадров; кадры подпрограмм, которые не бывают активны
+// одновременно (ни одна не вызывает другую даже через посредников), накладываются друг на друга
+struct codegen_frame {
+
+    const struct flow_graph_subroutine * subroutine;
+    bool is_static;
+
+    // смещение кадра в области кадров
+    size_t offset;
+
+    // размещение переменных в кадре, на стеке или в области кадров
+    struct codegen_slots slots;
+};
+
+struct codegen_frames {
+
+    // по одному на подпрограмму, отсортированы по адресу подпрограммы для поиска
+    size_t size;
+    struct codegen_frame * values;
+
+    // размер области кадров
+    size_t area_size;
+};
+
+// slots[i] — размещение переменных подпрограммы subroutines->values[i], переходит во владение кадров;
+// если enabled ложно, кадры всех подпрограмм строятся на стеке
+struct codegen_frames codegen_frames_build(
+        const struct flow_graph_subroutine_list * subroutines,
+        struct codegen_slots * slots,
+        bool enabled
+);
+
+void codegen_frames_fini(struct codegen_frames * frames);
+
+// кадр подпрограммы или NULL для подпрограмм не из списка
+const struct codegen_frame * codegen_frames_get(
+        const struct codegen_frames * frames,
+        const struct flow_graph_subroutine * subroutine
+);
+
+// у подпрограммы постоянный кадр: вызывающая не резервирует ячейку результата, см. codegen_generate
+bool codegen_frames_is_static(const struct codegen_frames * frames, const struct flow_graph_subroutine * subroutine);
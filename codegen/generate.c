@@ -1,9 +1,13 @@
 #include "generate.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
+#include "frames.h"
+#include "layout.h"
+#include "switch.h"
 #include "utils/mallocs.h"
 #include "utils/unreachable.h"
 
@@ -22,10 +26,14 @@ static const char * const NODE_TYPE_NAME[] = {
 
 static const char * const LEAVE_LABEL = ".leave";
 static const char * const RETURN_VOID_LABEL = ".return_void";
-static const char * const NODE_LABEL_PREFIX = "node";
+static const char * const BLOCK_LABEL_PREFIX = "block";
+static const char * const FRAMES_LABEL = "frames";
 
 static const size_t POINTER_SIZE = 4;
 
+// переменные кадра больше этого размера резервируются сдвигом SP, а не нулями из инструкции const
+static const size_t RESERVE_ZEROS_MAX = 16;
+
 static const struct ast_type_reference * internal_int_type = NULL;
 
 const char * const codegen_header =
@@ -203,6 +211,43 @@ const char * const codegen_builtins =
         "chr:\n"
         "\tgoto ord\n";
 
+// встроенные подпрограммы, тело которых короче последовательности вызова, разворачиваются на месте:
+// аргументы кладутся как для вызова, а вместо call ставится инструкция op, если она есть; ord и chr
+// только меняют тип байта и не стоят ничего; ячейку результата вызывающая резервирует, только если
+// её резервировал бы вызов и тело не кладёт результат само, как write; тела в codegen_builtins остаются
+struct intrinsic {
+
+    const char * id;
+
+    bool has_op;
+    enum codegen_asm_op_opcode op;
+    uint8_t imm8;
+
+    bool result_slot;
+};
+
+static const struct intrinsic INTRINSICS[] = {
+    { .id = "read", .has_op = true, .op = CODEGEN_ASM_OP_OPCODE_IN },
+    { .id = "write", .has_op = true, .op = CODEGEN_ASM_OP_OPCODE_OUT, .result_slot = true },
+    { .id = "get_int_array_size", .has_op = true, .op = CODEGEN_ASM_OP_OPCODE_LOAD, .imm8 = 4 },
+    { .id = "ord" },
+    { .id = "chr" },
+};
+
+static const struct intrinsic * get_intrinsic(const struct flow_graph_subroutine * subroutine) {
+    if (subroutine->defined) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < sizeof(INTRINSICS) / sizeof(INTRINSICS[0]); ++i) {
+        if (strcmp(INTRINSICS[i].id, subroutine->id) == 0) {
+            return &INTRINSICS[i];
+        }
+    }
+
+    return NULL;
+}
+
 static char * generate_label(const char * prefix, size_t index) {
     const size_t size = strlen(prefix) + 30;
 
@@ -212,6 +257,17 @@ static char * generate_label(const char * prefix, size_t index) {
     return result;
 }
 
+// метка переменной с номером index в постоянном кадре: точки нет в идентификаторах,
+// поэтому метка не совпадает с именами подпрограмм и их локальными метками
+static char * generate_frame_label(const struct flow_graph_subroutine * subroutine, size_t index) {
+    const size_t size = strlen(FRAMES_LABEL) + strlen(subroutine->id) + 30;
+
+    char * result = mallocs(sizeof(char) * size);
+    snprintf(result, size, "%s.%s.%zu", FRAMES_LABEL, subroutine->id, index);
+
+    return result;
+}
+
 static struct space space_init(const char * prefix) {
     return (struct space) {
         .listing = codegen_asm_list_init(),
@@ -306,6 +362,21 @@ static void generate_const_int(uint64_t value, struct codegen_asm_list * code) {
     codegen_asm_list_append(code, ins);
 }
 
+// size нулевых байт на стек одной инструкцией
+static void generate_zeros(size_t size, struct codegen_asm_list * code) {
+    assert(size <= UINT8_MAX);
+
+    // const size
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CONST);
+    ins.op.imm8 = size;
+    codegen_asm_list_append(code, ins);
+
+    // db 0, ...
+    ins = codegen_asm_init_data(size, mallocs(size));
+    memset(ins.data.data, 0, size);
+    codegen_asm_list_append(code, ins);
+}
+
 static void generate_literal(
         const struct flow_graph_literal * literal,
         const struct ast_type_reference * type,
@@ -376,493 +447,1802 @@ static void generate_literal(
     }
 }
 
-static void generate_expr(
-        const struct flow_graph_subroutine * subroutine,
-        const struct flow_graph_expr * expr,
-        struct codegen_asm_list * code,
-        struct space * const_space
-);
+// адрес FP - offset: FP указывает на конец ячейки результата, переменные кадра лежат ниже неё
+static void generate_frame_address(size_t offset, struct codegen_asm_list * code) {
+    // get FP
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
+    ins.op.reg = CODEGEN_ASM_OP_REG_FP;
+    codegen_asm_list_append(code, ins);
 
-static struct codegen_asm_list generate_expr_for_op(
-        const struct flow_graph_subroutine * subroutine,
-        const struct flow_graph_expr * expr,
-        struct space * const_space
-) {
-    struct codegen_asm_list result = codegen_asm_list_init();
+    // const 4
+    // db offset
+    generate_const_int(offset, code);
+
+    // sub
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+}
 
-    generate_expr(subroutine, expr, &result, const_space);
+// SP += size или SP -= size
+static void generate_sp_shift(size_t size, enum codegen_asm_op_opcode opcode, struct codegen_asm_list * code) {
+    // get SP
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
+    ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+    codegen_asm_list_append(code, ins);
 
-    if (ast_type_reference_is_numeric(expr->type)) {
-        cast_to_type(expr->type, internal_int_type, &result);
-    }
+    // const 4
+    // db size
+    generate_const_int(size, code);
 
-    return result;
+    // add или sub
+    codegen_asm_list_append(code, codegen_asm_init_op(opcode));
+
+    // set SP
+    ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
+    ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+    codegen_asm_list_append(code, ins);
 }
 
-static void generate_expr(
+// адрес переменной постоянного кадра — метка, см. generate_frames
+static void generate_static_address(
         const struct flow_graph_subroutine * subroutine,
-        const struct flow_graph_expr * expr,
-        struct codegen_asm_list * code,
-        struct space * const_space
+        size_t index,
+        struct codegen_asm_list * code
 ) {
-    switch (expr->_type) {
-        case FLOW_GRAPH_EXPR_TYPE_BINARY: {
-            if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
-                struct codegen_asm_list access = codegen_asm_list_init();
-                size_t offset = 0, size = 0;
-
-                struct flow_graph_expr * const lhs = expr->binary.lhs;
+    // const POINTER_SIZE
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CONST);
+    ins.op.imm8 = POINTER_SIZE;
+    codegen_asm_list_append(code, ins);
 
-                switch (lhs->_type) {
-                    case FLOW_GRAPH_EXPR_TYPE_INDEXER: {
-                        assert(lhs->indexer.indices.size > 0);
+    // dd frames.id.index
+    codegen_asm_list_append(code, codegen_asm_init_label_data(generate_frame_label(subroutine, index)));
+}
 
-                        generate_expr(subroutine, lhs->indexer.value, &access, const_space);
+static void generate_local_address(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_local * local,
+        struct codegen_asm_list * code
+) {
+    const struct codegen_frame * const frame = codegen_frames_get(frames, subroutine);
 
-                        {
-                            generate_expr(subroutine, lhs->indexer.indices.values[0], &access, const_space);
-                            cast_to_type(lhs->indexer.indices.values[0]->type, internal_int_type, &access);
+    if (frame->is_static) {
+        generate_static_address(subroutine, local->index - 1, code);
+    } else {
+        generate_frame_address(get_type_size(subroutine->return_type) + frame->slots.offsets[local->index - 1], code);
+    }
+}
 
-                            size = lhs->indexer.indices.size == 1
-                                    ? get_type_size(lhs->type)
-                                    : POINTER_SIZE;
+// индекс-литерал не вычисляется на стеке: его смещение известно при генерации
+static bool is_literal_index(const struct flow_graph_expr * index) {
+    return index->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL
+           && index->literal.literal->_type == FLOW_GRAPH_LITERAL_TYPE_INT
+           && ast_type_reference_is_numeric(index->type);
+}
 
-                            // const 4
-                            // db elem_size
-                            generate_const_int(size, &access);
+// значение литерала на стеке после усечения до его типа и расширения до слова, см. generate_literal
+static uint32_t get_literal_index(const struct flow_graph_expr * index) {
+    const uint32_t value = (uint32_t) index->literal.literal->_int.value;
 
-                            // mul
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MUL));
+    switch (index->type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            return (uint8_t) value;
 
-                            // add
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            return (uint32_t) (int32_t) (int16_t) value;
 
-                            // const 4
-                            // db 4, 0, 0, 0
-                            generate_const_int(4, &access);
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return (uint16_t) value;
 
-                            // add
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
-                        }
+        default:
+            return value;
+    }
+}
 
-                        for (size_t i = 1; i < lhs->indexer.indices.size; ++i) {
-                            // load elem_size
-                            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
-                            ins.op.imm8 = size;
-                            codegen_asm_list_append(&access, ins);
+// адрес элемента массива по значению индекса на вершине стека или по индексу-литералу,
+// для всех индексов, кроме последнего, сразу читается указатель на следующее измерение
+static void generate_element(
+        const struct flow_graph_expr * indexer,
+        size_t i,
+        bool load,
+        struct codegen_asm_list * code
+) {
+    const struct flow_graph_expr * const index = indexer->indexer.indices.values[i];
 
-                            generate_expr(subroutine, lhs->indexer.indices.values[i], &access, const_space);
-                            cast_to_type(lhs->indexer.indices.values[i]->type, internal_int_type, &access);
+    const size_t elem_size = i == indexer->indexer.indices.size - 1
+            ? get_type_size(indexer->type)
+            : POINTER_SIZE;
 
-                            size = i == lhs->indexer.indices.size - 1
-                                    ? get_type_size(lhs->type)
-                                    : POINTER_SIZE;
+    if (is_literal_index(index)) {
+        // const 4
+        // db index * elem_size + 4
+        generate_const_int((uint32_t) (get_literal_index(index) * elem_size + 4), code);
+    } else {
+        // индекс уже на стеке словом, см. generate_word_task
 
-                            // const 4
-                            // db elem_size
-                            generate_const_int(size, &access);
+        // смещение index * elem_size сдвигом, байтовому элементу индекс и есть смещение
+        if (elem_size > 1) {
+            // const 4
+            // db log2(elem_size)
+            generate_const_int(elem_size == 2 ? 1 : 2, code);
 
-                            // mul
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MUL));
+            // shl
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHL));
+        }
 
-                            // add
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+        // add
+        codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
 
-                            // const 4
-                            // db 4, 0, 0, 0
-                            generate_const_int(4, &access);
+        // const 4
+        // db 4, 0, 0, 0
+        generate_const_int(4, code);
+    }
 
-                            // add
-                            codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
-                        }
+    // add
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
 
-                        break;
-                    }
+    if (load || i < indexer->indexer.indices.size - 1) {
+        // load elem_size
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+        ins.op.imm8 = elem_size;
+        codegen_asm_list_append(code, ins);
+    }
+}
 
-                    case FLOW_GRAPH_EXPR_TYPE_LOCAL: {
-                        for (size_t i = 0; i < subroutine->locals.size; ++i) {
-                            size = get_type_size(subroutine->locals.values[i]->type);
-                            offset += size;
+enum reduction_type {
+
+    REDUCTION_TYPE_NONE = 0,
+    // результат — другой операнд
+    REDUCTION_TYPE_IDENTITY,
+    // результат — ноль, другой операнд без побочных эффектов не вычисляется
+    REDUCTION_TYPE_ZERO,
+    REDUCTION_TYPE_SHL,
+    REDUCTION_TYPE_SHR,
+    REDUCTION_TYPE_AND,
+    // старшее слово произведения на value, сдвинутое вправо на shift
+    REDUCTION_TYPE_MULHU,
+};
 
-                            if (subroutine->locals.values[i] == lhs->local.local) {
-                                break;
-                            }
-                        }
+// операция с литералом, которую заменяет более дешёвая: operand — другой операнд,
+// value — величина сдвига, маска или множитель
+struct reduction {
 
-                        // get FP
-                        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-                        ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-                        codegen_asm_list_append(&access, ins);
+    enum reduction_type _type;
+    const struct flow_graph_expr * operand;
+    uint32_t value;
+    uint32_t shift;
+};
 
-                        // const 4
-                        // db offset
-                        generate_const_int(offset, &access);
+static uint32_t get_log2(uint32_t value) {
+    uint32_t result = 0;
 
-                        // sub
-                        codegen_asm_list_append(&access, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
-                        break;
-                    }
+    while (value > 1) {
+        value >>= 1;
+        ++result;
+    }
 
-                    default:
-                        unreachable();
-                }
+    return result;
+}
 
-                {
-                    struct codegen_asm_list tmp = codegen_asm_list_clone(access);
-                    codegen_asm_list_concat(code, &tmp);
-                }
+// множитель m = ceil(2^(32 + l) / divisor), с которым floor(x * m / 2^(32 + l)) = floor(x / divisor) для любого
+// слова x: погрешность m * divisor - 2^(32 + l) не больше 2^l; берётся наименьшее l, множитель должен
+// уместиться в слово, иначе деление остаётся делением
+static bool get_magic(uint32_t divisor, uint32_t * magic, uint32_t * shift) {
+    for (uint32_t l = 0; l < 32; ++l) {
+        const uint64_t power = (uint64_t) 1 << (32 + l);
+        const uint64_t m = power / divisor + (power % divisor != 0);
 
-                generate_expr(subroutine, expr->binary.rhs, code, const_space);
-                cast_to_type(expr->binary.rhs->type, lhs->type, code);
+        if (m > UINT32_MAX) {
+            return false;
+        }
 
-                // store size
-                struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_STORE);
-                ins.op.imm8 = size;
-                codegen_asm_list_append(code, ins);
+        if (m * divisor - power <= (uint64_t) 1 << l) {
+            *magic = (uint32_t) m;
+            *shift = l;
+            return true;
+        }
+    }
 
-                codegen_asm_list_concat(code, &access);
+    return false;
+}
 
-                // load size
-                ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
-                ins.op.imm8 = size;
-                codegen_asm_list_append(code, ins);
+// умножение на степень двойки — сдвиг влево, а div и rem виртуальной машины беззнаковые над словом,
+// поэтому деление и остаток по степени двойки — сдвиг вправо и маска при любом знаке операндов;
+// деление на другую константу — умножение на обратную с помощью mulhu; деление на ноль остаётся
+// делением, чтобы программа остановилась там же
+static struct reduction get_reduction(const struct flow_graph_expr * expr) {
+    const struct reduction none = { ._type = REDUCTION_TYPE_NONE };
 
-                return;
-            }
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || !ast_type_reference_is_numeric(expr->type)) {
+        return none;
+    }
 
-            struct codegen_asm_list lhs_code = generate_expr_for_op(subroutine, expr->binary.lhs, const_space);
-            struct codegen_asm_list rhs_code = generate_expr_for_op(subroutine, expr->binary.rhs, const_space);
+    const enum flow_graph_expr_binary_op op = expr->binary.op;
+    const struct flow_graph_expr * literal = expr->binary.rhs;
+    const struct flow_graph_expr * operand = expr->binary.lhs;
 
-            codegen_asm_list_concat(code, &lhs_code);
-            codegen_asm_list_concat(code, &rhs_code);
+    if (op == FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY && !is_literal_index(literal)) {
+        literal = expr->binary.lhs;
+        operand = expr->binary.rhs;
+    }
 
-            switch (expr->binary.op) {
-                case FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT:
-                    unreachable();
+    if ((op != FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY
+         && op != FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE
+         && op != FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER)
+        || !is_literal_index(literal)) {
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_PLUS:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
-                    break;
+        return none;
+    }
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_MINUS:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
-                    break;
+    const uint32_t value = get_literal_index(literal);
+    struct reduction result = { ._type = REDUCTION_TYPE_NONE, .operand = operand, .value = 0, .shift = 0 };
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MUL));
-                    break;
+    if (value == 0 || (value & (value - 1)) != 0) {
+        if (value == 0 && op == FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY && flow_graph_expr_is_pure(operand)) {
+            result._type = REDUCTION_TYPE_ZERO;
+        } else if (value != 0 && op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE && get_magic(value, &result.value, &result.shift)) {
+            result._type = REDUCTION_TYPE_MULHU;
+        }
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_DIV));
-                    break;
+        return result;
+    }
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_REM));
-                    break;
+    switch (op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY:
+            result._type = value == 1 ? REDUCTION_TYPE_IDENTITY : REDUCTION_TYPE_SHL;
+            result.value = get_log2(value);
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_AND:
-                case FLOW_GRAPH_EXPR_BINARY_OP_AND:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_AND));
-                    break;
+        case FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE:
+            result._type = value == 1 ? REDUCTION_TYPE_IDENTITY : REDUCTION_TYPE_SHR;
+            result.value = get_log2(value);
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_OR:
-                case FLOW_GRAPH_EXPR_BINARY_OP_OR:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_OR));
-                    break;
+        default:
+            if (value == 1 && flow_graph_expr_is_pure(operand)) {
+                result._type = REDUCTION_TYPE_ZERO;
+            } else if (value > 1) {
+                result._type = REDUCTION_TYPE_AND;
+                result.value = value - 1;
+            }
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_XOR:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_XOR));
-                    break;
+            break;
+    }
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_EQ: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_EQ;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+    return result;
+}
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_NE: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_NE;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+static void generate_reduction(const struct reduction * reduction, struct codegen_asm_list * code) {
+    switch (reduction->_type) {
+        case REDUCTION_TYPE_NONE:
+            unreachable();
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_LT: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_LT;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+        case REDUCTION_TYPE_IDENTITY:
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_LE: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_LE;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+        case REDUCTION_TYPE_ZERO:
+            // const 4
+            // db 0, 0, 0, 0
+            generate_const_int(0, code);
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_GT: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_GT;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+        case REDUCTION_TYPE_SHL:
+            generate_const_int(reduction->value, code);
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHL));
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_GE: {
-                    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
-                    ins.op.cmp = CODEGEN_ASM_OP_CMP_GE;
-                    codegen_asm_list_append(code, ins);
-                    break;
-                }
+        case REDUCTION_TYPE_SHR:
+            generate_const_int(reduction->value, code);
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHR));
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_LEFT_BITSHIFT:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHL));
-                    break;
+        case REDUCTION_TYPE_AND:
+            generate_const_int(reduction->value, code);
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_AND));
+            break;
 
-                case FLOW_GRAPH_EXPR_BINARY_OP_RIGHT_BITSHIFT:
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHR));
-                    break;
-            }
+        case REDUCTION_TYPE_MULHU:
+            generate_const_int(reduction->value, code);
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MULHU));
 
-            if (ast_type_reference_is_numeric(expr->type)) {
-                cast_to_type(internal_int_type, expr->type, code);
+            if (reduction->shift > 0) {
+                generate_const_int(reduction->shift, code);
+                codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHR));
             }
 
             break;
-        }
-
-        case FLOW_GRAPH_EXPR_TYPE_UNARY: {
-            struct codegen_asm_list value_code = generate_expr_for_op(subroutine, expr->unary.value, const_space);
+    }
+}
 
-            switch (expr->unary.op) {
-                case FLOW_GRAPH_EXPR_UNARY_OP_MINUS:
-                    // const 4
-                    // db 0, 0, 0, 0
-                    generate_const_int(0, code);
+static void generate_binary_instruction(enum flow_graph_expr_binary_op op, struct codegen_asm_list * code) {
+    switch (op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT:
+            unreachable();
 
-                    // value_code
-                    codegen_asm_list_concat(code, &value_code);
+        case FLOW_GRAPH_EXPR_BINARY_OP_PLUS:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+            break;
 
-                    // sub
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
-                    break;
+        case FLOW_GRAPH_EXPR_BINARY_OP_MINUS:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+            break;
 
-                case FLOW_GRAPH_EXPR_UNARY_OP_BITWISE_NOT:
-                case FLOW_GRAPH_EXPR_UNARY_OP_NOT:
-                    // value_code
-                    codegen_asm_list_concat(code, &value_code);
+        case FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MUL));
+            break;
 
-                    // const 4
-                    // db 0xff, 0xff, 0xff, 0xff
-                    generate_const_int(0xffffffff, code);
+        case FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_DIV));
+            break;
 
-                    // xor
-                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_XOR));
-                    break;
-            }
+        case FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_REM));
+            break;
 
-            if (ast_type_reference_is_numeric(expr->type)) {
-                cast_to_type(internal_int_type, expr->type, code);
-            }
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_AND:
+        case FLOW_GRAPH_EXPR_BINARY_OP_AND:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_AND));
+            break;
 
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_OR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_OR:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_OR));
             break;
-        }
 
-        case FLOW_GRAPH_EXPR_TYPE_CALL: {
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_XOR:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_XOR));
+            break;
 
-            // get SP
-            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-            ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+        case FLOW_GRAPH_EXPR_BINARY_OP_EQ: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_EQ;
             codegen_asm_list_append(code, ins);
+            break;
+        }
 
-            // const 4
-            // db sizeof(return_type)
-            generate_const_int(get_type_size(expr->call.subroutine->return_type), code);
+        case FLOW_GRAPH_EXPR_BINARY_OP_NE: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_NE;
+            codegen_asm_list_append(code, ins);
+            break;
+        }
 
-            // sub
-            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+        case FLOW_GRAPH_EXPR_BINARY_OP_LT: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_LT;
+            codegen_asm_list_append(code, ins);
+            break;
+        }
 
-            // set SP
-            ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-            ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+        case FLOW_GRAPH_EXPR_BINARY_OP_LE: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_LE;
             codegen_asm_list_append(code, ins);
+            break;
+        }
 
-            for (size_t i = 0; i < expr->call.args.size; ++i) {
-                generate_expr(subroutine, expr->call.args.values[i], code, const_space);
-                cast_to_type(expr->call.args.values[i]->type, expr->call.subroutine->locals.values[i]->type, code);
-            }
+        case FLOW_GRAPH_EXPR_BINARY_OP_GT: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_GT;
+            codegen_asm_list_append(code, ins);
+            break;
+        }
 
-            ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CALL);
-            ins.op.label = strdup(expr->call.subroutine->id);
+        case FLOW_GRAPH_EXPR_BINARY_OP_GE: {
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+            ins.op.cmp = CODEGEN_ASM_OP_CMP_GE;
             codegen_asm_list_append(code, ins);
             break;
         }
 
-        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
-            generate_expr(subroutine, expr->indexer.value, code, const_space);
+        case FLOW_GRAPH_EXPR_BINARY_OP_LEFT_BITSHIFT:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHL));
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_RIGHT_BITSHIFT:
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHR));
+            break;
+    }
+}
+
+// word — результат остаётся словом и не усекается до типа выражения, см. generate_word_task;
+// операнды уже на стеке, кроме тех, что отбрасывает get_reduction
+static void generate_binary_op(const struct flow_graph_expr * expr, bool word, struct codegen_asm_list * code) {
+    const struct reduction reduction = get_reduction(expr);
+
+    if (reduction._type != REDUCTION_TYPE_NONE) {
+        generate_reduction(&reduction, code);
+    } else {
+        generate_binary_instruction(expr->binary.op, code);
+    }
 
-            for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
-                generate_expr(subroutine, expr->indexer.indices.values[i], code, const_space);
-                cast_to_type(expr->indexer.indices.values[i]->type, internal_int_type, code);
+    if (!word && ast_type_reference_is_numeric(expr->type)) {
+        cast_to_type(internal_int_type, expr->type, code);
+    }
+}
 
-                const size_t elem_size = i == expr->indexer.indices.size - 1
-                        ? get_type_size(expr->type)
-                        : POINTER_SIZE;
+static void generate_unary_op(const struct flow_graph_expr * expr, bool word, struct codegen_asm_list * code) {
+    switch (expr->unary.op) {
+        case FLOW_GRAPH_EXPR_UNARY_OP_MINUS:
+            // sub
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+            break;
 
-                // const 4
-                // db elem_size
-                generate_const_int(elem_size, code);
+        case FLOW_GRAPH_EXPR_UNARY_OP_BITWISE_NOT:
+        case FLOW_GRAPH_EXPR_UNARY_OP_NOT:
+            // const 4
+            // db 0xff, 0xff, 0xff, 0xff
+            generate_const_int(0xffffffff, code);
 
-                // mul
-                codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_MUL));
+            // xor
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_XOR));
+            break;
+    }
 
-                // add
-                codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+    if (!word && ast_type_reference_is_numeric(expr->type)) {
+        cast_to_type(internal_int_type, expr->type, code);
+    }
+}
 
-                // const 4
-                // db 4, 0, 0, 0
-                generate_const_int(4, code);
+enum expr_task_type {
+
+    EXPR_TASK_TYPE_EXPR = 0,
+    EXPR_TASK_TYPE_OPERAND,
+    EXPR_TASK_TYPE_WORD,
+    EXPR_TASK_TYPE_BINARY,
+    EXPR_TASK_TYPE_UNARY,
+    EXPR_TASK_TYPE_ARG,
+    EXPR_TASK_TYPE_CALL,
+    EXPR_TASK_TYPE_ELEMENT,
+    EXPR_TASK_TYPE_ELEMENT_ADDRESS,
+    EXPR_TASK_TYPE_ASSIGN_ACCESS,
+    EXPR_TASK_TYPE_ASSIGN,
+};
 
-                // add
-                codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+// отложенный шаг генерации выражения: либо генерация подвыражения, либо код,
+// который выполняется после того, как операнды уже сгенерированы
+struct expr_task {
 
-                // load elem_size
-                struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
-                ins.op.imm8 = elem_size;
-                codegen_asm_list_append(code, ins);
-            }
+    enum expr_task_type _type;
+    const struct flow_graph_expr * expr;
+    size_t index;
 
-            break;
+    struct codegen_asm_list * code;
+    struct codegen_asm_list * access;
+};
 
-        case FLOW_GRAPH_EXPR_TYPE_LOCAL: {
-            size_t offset = 0, size = 0;
+struct expr_task_stack {
 
-            for (size_t i = 0; i < subroutine->locals.size; ++i) {
-                size = get_type_size(subroutine->locals.values[i]->type);
-                offset += size;
+    size_t size;
+    size_t capacity;
+    struct expr_task * values;
 
-                if (subroutine->locals.values[i] == expr->local.local) {
-                    break;
-                }
-            }
+    // чтение левой части присваивания, которое берёт адрес с вершины стека, см. is_read_modify_write
+    const struct flow_graph_expr * reload;
+};
 
-            // get FP
-            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-            ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-            codegen_asm_list_append(code, ins);
+static void expr_task_push(
+        struct expr_task_stack * stack,
+        enum expr_task_type type,
+        const struct flow_graph_expr * expr,
+        size_t index,
+        struct codegen_asm_list * code,
+        struct codegen_asm_list * access
+) {
+    if (stack->size >= stack->capacity) {
+        stack->capacity = stack->capacity ? stack->capacity * 2 : 16;
+        stack->values = reallocs(stack->values, sizeof(struct expr_task) * stack->capacity);
+    }
 
-            // const 4
-            // db offset
-            generate_const_int(offset, code);
+    stack->values[stack->size++] = (struct expr_task) {
+        ._type = type,
+        .expr = expr,
+        .index = index,
+        .code = code,
+        .access = access,
+    };
+}
 
-            // sub
-            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+// младшие байты результата зависят только от младших байт операндов того же числа
+static bool is_low_bytes_op(const struct flow_graph_expr * expr) {
+    if (!ast_type_reference_is_numeric(expr->type)) {
+        return false;
+    }
 
-            // load size
-            ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
-            ins.op.imm8 = size;
-            codegen_asm_list_append(code, ins);
-            break;
-        }
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_UNARY) {
+        return expr->unary.op == FLOW_GRAPH_EXPR_UNARY_OP_MINUS
+               || expr->unary.op == FLOW_GRAPH_EXPR_UNARY_OP_BITWISE_NOT;
+    }
 
-        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
-            generate_literal(expr->literal.literal, expr->type, code, const_space);
-            break;
+    switch (expr->binary.op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_PLUS:
+        case FLOW_GRAPH_EXPR_BINARY_OP_MINUS:
+        case FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY:
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_AND:
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_OR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_XOR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_LEFT_BITSHIFT:
+            return true;
+
+        default:
+            return false;
     }
 }
 
-static void generate_node_next(
-        const struct flow_graph_subroutine * subroutine,
-        enum codegen_asm_op_opcode opcode,
-        const struct flow_graph_node * node_next,
-        struct ast_type_reference * value_type,
-        struct codegen_asm_list * code
-) {
-    struct codegen_asm ins = codegen_asm_init_op(opcode);
+// точное значение операнда лежит в диапазоне типа
+static bool fits_type(const struct flow_graph_expr * operand, const struct ast_type_reference * type) {
+    if (!is_literal_index(operand)) {
+        return ast_type_reference_is_subtype(operand->type, type);
+    }
 
-    if (node_next) {
-        if (value_type) {
-            // get SP
-            struct codegen_asm ins1 = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-            ins1.op.reg = CODEGEN_ASM_OP_REG_SP;
-            codegen_asm_list_append(code, ins1);
+    const uint32_t value = get_literal_index(operand);
 
-            // const 4
-            // db sizeof(value_type)
-            generate_const_int(get_type_size(value_type), code);
+    switch (type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            return value <= UINT8_MAX;
 
-            // add
-            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            return (int32_t) value >= INT16_MIN && (int32_t) value <= INT16_MAX;
 
-            // set SP
-            ins1 = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-            ins1.op.reg = CODEGEN_ASM_OP_REG_SP;
-            codegen_asm_list_append(code, ins1);
-        }
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return value <= UINT16_MAX;
 
-        ins.op.label = generate_label(NODE_LABEL_PREFIX, node_next->index);
-    } else {
-        if (value_type) {
-            cast_to_type(value_type, subroutine->return_type, code);
-            ins.op.label = strdup(LEAVE_LABEL);
-        } else {
-            ins.op.label = strdup(RETURN_VOID_LABEL);
-        }
+        default:
+            return true;
     }
-
-    codegen_asm_list_append(code, ins);
 }
 
-static void generate_node(
-        const struct flow_graph_subroutine * subroutine,
-        const struct flow_graph_node * node,
-        struct codegen_asm_list * code,
-        struct space * const_space
-) {
-    {
-        char comment[1024];
-        snprintf(
-                comment,
-                1024,
-                "%zu: %s at %zu:%zu",
-                node->index,
-                NODE_TYPE_NAME[node->_type],
-                node->position.row,
-                node->position.column
-        );
-        codegen_asm_list_append(code, codegen_asm_init_comment(strdup(comment)));
+// из точных операндов операция получает значение в диапазоне своего типа, и усечение с расширением
+// обратно ничего не меняют: побитовые операции сохраняют расширение знаком или нулями, остаток
+// не больше делимого или делителя, а беззнаковые частное и сдвиг вправо не больше делимого;
+// div, rem и shr виртуальной машины беззнаковые
+static bool keeps_exact(const struct flow_graph_expr * expr) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || !ast_type_reference_is_numeric(expr->type)) {
+        return false;
     }
 
-    codegen_asm_list_append(code, codegen_asm_init_label(generate_label(NODE_LABEL_PREFIX, node->index)));
+    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+    const struct flow_graph_expr * const rhs = expr->binary.rhs;
 
-    switch (node->_type) {
-        case FLOW_GRAPH_NODE_TYPE_EXPR:
-            if (node->expr.expr) {
-                generate_expr(subroutine, node->expr.expr, code, const_space);
-            }
+    const bool is_unsigned = expr->type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE
+                             || expr->type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT;
 
-            generate_node_next(
-                    subroutine,
-                    CODEGEN_ASM_OP_OPCODE_GOTO,
-                    node->expr.next,
-                    node->expr.expr ? node->expr.expr->type : NULL,
-                    code
-            );
+    switch (expr->binary.op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_AND:
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_OR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_XOR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER:
+            return fits_type(lhs, expr->type) && fits_type(rhs, expr->type);
 
-            break;
+        case FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE:
+        case FLOW_GRAPH_EXPR_BINARY_OP_RIGHT_BITSHIFT:
+            return is_unsigned && fits_type(lhs, expr->type);
 
-        case FLOW_GRAPH_NODE_TYPE_COND:
-            generate_expr(subroutine, node->cond.cond, code, const_space);
-            generate_node_next(subroutine, CODEGEN_ASM_OP_OPCODE_IFZ, node->cond.else_next, NULL, code);
-            generate_node_next(subroutine, CODEGEN_ASM_OP_OPCODE_GOTO, node->cond.then_next, NULL, code);
-            break;
+        default:
+            return false;
     }
 }
 
-static struct codegen_asm_list generate_subroutine(const struct flow_graph_subroutine * subroutine) {
-    struct codegen_asm_list code = codegen_asm_list_init();
-    struct space const_space = space_init("const");
+// сколько младших байт операнда нужно, чтобы получить demand младших байт результата
+static size_t get_operand_demand(const struct flow_graph_expr * expr, size_t demand, bool rhs) {
+    if (!is_low_bytes_op(expr) || demand > get_type_size(expr->type)) {
+        return 4;
+    }
+
+    if (rhs && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_LEFT_BITSHIFT) {
+        return 4;
+    }
+
+    return demand;
+}
+
+// результат операции, усечённый до её типа, определяется младшими байтами слова в пределах типа
+static size_t get_result_demand(const struct flow_graph_expr * expr) {
+    return ast_type_reference_is_numeric(expr->type) ? get_type_size(expr->type) : 4;
+}
+
+// операция над словами; от результата нужно demand младших байт, word — результат остаётся словом
+static void push_op(
+        struct expr_task_stack * stack,
+        const struct flow_graph_expr * expr,
+        size_t demand,
+        bool word,
+        struct codegen_asm_list * code
+) {
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY) {
+        const struct reduction reduction = get_reduction(expr);
+        expr_task_push(stack, EXPR_TASK_TYPE_BINARY, expr, word, code, NULL);
+
+        // литерал заменённой операции не кладётся, а при нулевом результате — и другой операнд
+        if (reduction._type != REDUCTION_TYPE_NONE) {
+            if (reduction._type != REDUCTION_TYPE_ZERO) {
+                const bool rhs = reduction.operand == expr->binary.rhs;
+                expr_task_push(stack, EXPR_TASK_TYPE_WORD, reduction.operand, get_operand_demand(expr, demand, rhs), code, NULL);
+            }
+
+            return;
+        }
+
+        expr_task_push(stack, EXPR_TASK_TYPE_WORD, expr->binary.rhs, get_operand_demand(expr, demand, true), code, NULL);
+        expr_task_push(stack, EXPR_TASK_TYPE_WORD, expr->binary.lhs, get_operand_demand(expr, demand, false), code, NULL);
+        return;
+    }
+
+    if (expr->unary.op == FLOW_GRAPH_EXPR_UNARY_OP_MINUS) {
+        // const 4
+        // db 0, 0, 0, 0
+        generate_const_int(0, code);
+    }
+
+    expr_task_push(stack, EXPR_TASK_TYPE_UNARY, expr, word, code, NULL);
+    expr_task_push(stack, EXPR_TASK_TYPE_WORD, expr->unary.value, get_operand_demand(expr, demand, false), code, NULL);
+}
+
+// значение выражения словом, у которого верны младшие demand байт, а при demand == 4 — точное,
+// расширенное по типу выражения; операции, от которых нужны только младшие байты своего типа
+// или которые и так дают точное значение, не усекаются до типа, чтобы сразу расширяться обратно
+static void generate_word_task(
+        const struct flow_graph_expr * expr,
+        size_t demand,
+        struct codegen_asm_list * code,
+        struct expr_task_stack * stack
+) {
+    if (is_literal_index(expr)) {
+        // const 4
+        // db value
+        generate_const_int(get_literal_index(expr), code);
+        return;
+    }
+
+    const bool is_op = expr->_type == FLOW_GRAPH_EXPR_TYPE_UNARY
+                       || (expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+                           && expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT);
+
+    if (is_op && ast_type_reference_is_numeric(expr->type)
+        && (demand <= get_type_size(expr->type) || keeps_exact(expr))) {
+        push_op(stack, expr, demand, true, code);
+        return;
+    }
+
+    expr_task_push(stack, EXPR_TASK_TYPE_OPERAND, expr, 0, code, NULL);
+    expr_task_push(stack, EXPR_TASK_TYPE_EXPR, expr, 0, code, NULL);
+}
+
+// значение приводится к другому числовому типу через слово, от которого нужны только байты типа
+static bool is_converted(const struct flow_graph_expr * value, const struct ast_type_reference * type) {
+    return ast_type_reference_is_numeric(value->type)
+           && ast_type_reference_is_numeric(type)
+           && !ast_type_reference_equals(value->type, type);
+}
+
+static void push_value(
+        struct expr_task_stack * stack,
+        const struct flow_graph_expr * value,
+        const struct ast_type_reference * type,
+        struct codegen_asm_list * code
+) {
+    if (is_converted(value, type)) {
+        expr_task_push(stack, EXPR_TASK_TYPE_WORD, value, get_type_size(type), code, NULL);
+    } else {
+        expr_task_push(stack, EXPR_TASK_TYPE_EXPR, value, 0, code, NULL);
+    }
+}
+
+// значение, положенное push_value, к типу type
+static void cast_value(
+        const struct flow_graph_expr * value,
+        const struct ast_type_reference * type,
+        struct codegen_asm_list * code
+) {
+    cast_to_type(is_converted(value, type) ? internal_int_type : value->type, type, code);
+}
+
+// часть левой части присваивания и её повторное чтение: значение с побочными эффектами вычислено
+// в левой части во временную переменную, а чтение берёт её, см. bind_value в ast_analyze
+static bool is_same_value(const struct flow_graph_expr * value, const struct flow_graph_expr * read) {
+    if (flow_graph_expr_is_pure(value)) {
+        return flow_graph_expr_equals(value, read);
+    }
+
+    return value->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+            && value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+            && value->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL
+            && flow_graph_expr_equals(value->binary.lhs, read);
+}
+
+// присваивание lhs = lhs op value: адрес левой части вычисляется один раз, а её чтение копирует его
+// инструкцией dup и читает по копии; чтение идёт первым в правой части, как и без копии
+static bool is_read_modify_write(const struct flow_graph_expr * expr) {
+    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+    const struct flow_graph_expr * const value = expr->binary.rhs;
+
+    if (value->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const read = value->binary.lhs;
+
+    if (lhs->_type != FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+        return flow_graph_expr_equals(lhs, read);
+    }
+
+    if (read->_type != FLOW_GRAPH_EXPR_TYPE_INDEXER || read->indexer.indices.size != lhs->indexer.indices.size) {
+        return false;
+    }
+
+    if (!ast_type_reference_equals(lhs->type, read->type)
+            || !is_same_value(lhs->indexer.value, read->indexer.value)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < lhs->indexer.indices.size; ++i) {
+        if (!is_same_value(lhs->indexer.indices.values[i], read->indexer.indices.values[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// адрес для чтения результата присваивания копируется, а не вычисляется заново: у чтения-изменения-записи
+// копия всё равно нужна, а левую часть с побочными эффектами нельзя вычислять дважды
+static bool is_address_kept(const struct flow_graph_expr * expr) {
+    return is_read_modify_write(expr) || !flow_graph_expr_is_pure(expr->binary.lhs);
+}
+
+static void generate_assignment(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * expr,
+        bool discard,
+        struct codegen_asm_list * code,
+        struct expr_task_stack * stack
+) {
+    struct codegen_asm_list * const access = mallocs(sizeof(struct codegen_asm_list));
+    *access = codegen_asm_list_init();
+
+    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+    // адрес вычисляется в отдельный листинг, он нужен дважды: для записи и для чтения результата;
+    // если результат не нужен, записанное значение не перечитывается
+    expr_task_push(stack, EXPR_TASK_TYPE_ASSIGN, expr, discard, code, access);
+    push_value(stack, expr->binary.rhs, lhs->type, code);
+    expr_task_push(stack, EXPR_TASK_TYPE_ASSIGN_ACCESS, expr, discard, code, access);
+
+    if (is_read_modify_write(expr)) {
+        stack->reload = expr->binary.rhs->binary.lhs;
+    }
+
+    switch (lhs->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            assert(lhs->indexer.indices.size > 0);
+
+            for (size_t i = lhs->indexer.indices.size; i > 0; --i) {
+                expr_task_push(stack, EXPR_TASK_TYPE_ELEMENT_ADDRESS, lhs, i - 1, access, NULL);
+
+                if (!is_literal_index(lhs->indexer.indices.values[i - 1])) {
+                    expr_task_push(stack, EXPR_TASK_TYPE_WORD, lhs->indexer.indices.values[i - 1], 4, access, NULL);
+                }
+            }
+
+            expr_task_push(stack, EXPR_TASK_TYPE_EXPR, lhs->indexer.value, 0, access, NULL);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            generate_local_address(subroutine, frames, lhs->local.local, access);
+            break;
+
+        default:
+            unreachable();
+    }
+}
+
+static void generate_expr_task(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * expr,
+        bool discard,
+        struct codegen_asm_list * code,
+        struct space * const_space,
+        struct expr_task_stack * stack
+) {
+    if (expr == stack->reload) {
+        stack->reload = NULL;
+
+        // dup
+        codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_DUP));
+
+        // load size
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+        ins.op.imm8 = get_type_size(expr->type);
+        codegen_asm_list_append(code, ins);
+        return;
+    }
+
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                generate_assignment(subroutine, frames, expr, discard, code, stack);
+                break;
+            }
+
+            push_op(stack, expr, get_result_demand(expr), false, code);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            push_op(stack, expr, get_result_demand(expr), false, code);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL: {
+
+            const struct intrinsic * const intrinsic = get_intrinsic(expr->call.subroutine);
+
+            // ячейка результата; подпрограмма с постоянным кадром кладёт результат на стек сама
+            if (intrinsic ? intrinsic->result_slot : !codegen_frames_is_static(frames, expr->call.subroutine)) {
+                generate_zeros(get_type_size(expr->call.subroutine->return_type), code);
+            }
+
+            expr_task_push(stack, EXPR_TASK_TYPE_CALL, expr, 0, code, NULL);
+
+            for (size_t i = expr->call.args.size; i > 0; --i) {
+                expr_task_push(stack, EXPR_TASK_TYPE_ARG, expr, i - 1, code, NULL);
+                push_value(stack, expr->call.args.values[i - 1], expr->call.subroutine->locals.values[i - 1]->type, code);
+            }
+
+            break;
+        }
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            for (size_t i = expr->indexer.indices.size; i > 0; --i) {
+                expr_task_push(stack, EXPR_TASK_TYPE_ELEMENT, expr, i - 1, code, NULL);
+
+                if (!is_literal_index(expr->indexer.indices.values[i - 1])) {
+                    expr_task_push(stack, EXPR_TASK_TYPE_WORD, expr->indexer.indices.values[i - 1], 4, code, NULL);
+                }
+            }
+
+            expr_task_push(stack, EXPR_TASK_TYPE_EXPR, expr->indexer.value, 0, code, NULL);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL: {
+            generate_local_address(subroutine, frames, expr->local.local, code);
+
+            // load size
+            struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+            ins.op.imm8 = get_type_size(expr->local.local->type);
+            codegen_asm_list_append(code, ins);
+            break;
+        }
+
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            generate_literal(expr->literal.literal, expr->type, code, const_space);
+            break;
+    }
+}
+
+// выражения обходятся с явным стеком задач, поэтому глубина вложенности не ограничена стеком вызовов;
+// index задачи EXPR ненулевой только у корня, значение которого не нужно, у задачи WORD index — сколько
+// младших байт слова нужно, у BINARY и UNARY — результат остаётся словом
+static void generate_expr_root(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        enum expr_task_type root_type,
+        const struct flow_graph_expr * root,
+        size_t root_index,
+        struct codegen_asm_list * root_code,
+        struct space * const_space
+) {
+    struct expr_task_stack stack = { 0 };
+    expr_task_push(&stack, root_type, root, root_index, root_code, NULL);
+
+    while (stack.size > 0) {
+        const struct expr_task task = stack.values[--stack.size];
+        const struct flow_graph_expr * const expr = task.expr;
+        struct codegen_asm_list * const code = task.code;
+
+        switch (task._type) {
+            case EXPR_TASK_TYPE_EXPR:
+                generate_expr_task(subroutine, frames, expr, task.index, code, const_space, &stack);
+                break;
+
+            case EXPR_TASK_TYPE_OPERAND:
+                if (ast_type_reference_is_numeric(expr->type)) {
+                    cast_to_type(expr->type, internal_int_type, code);
+                }
+
+                break;
+
+            case EXPR_TASK_TYPE_WORD:
+                generate_word_task(expr, task.index, code, &stack);
+                break;
+
+            case EXPR_TASK_TYPE_BINARY:
+                generate_binary_op(expr, task.index, code);
+                break;
+
+            case EXPR_TASK_TYPE_UNARY:
+                generate_unary_op(expr, task.index, code);
+                break;
+
+            case EXPR_TASK_TYPE_ARG:
+                cast_value(
+                        expr->call.args.values[task.index],
+                        expr->call.subroutine->locals.values[task.index]->type,
+                        code
+                );
+
+                break;
+
+            case EXPR_TASK_TYPE_CALL: {
+                const struct intrinsic * const intrinsic = get_intrinsic(expr->call.subroutine);
+
+                if (intrinsic) {
+                    if (intrinsic->has_op) {
+                        struct codegen_asm ins = codegen_asm_init_op(intrinsic->op);
+                        ins.op.imm8 = intrinsic->imm8;
+                        codegen_asm_list_append(code, ins);
+                    }
+
+                    break;
+                }
+
+                struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CALL);
+                ins.op.label = strdup(expr->call.subroutine->id);
+                codegen_asm_list_append(code, ins);
+                break;
+            }
+
+            case EXPR_TASK_TYPE_ELEMENT:
+                generate_element(expr, task.index, true, code);
+                break;
+
+            case EXPR_TASK_TYPE_ELEMENT_ADDRESS:
+                generate_element(expr, task.index, false, code);
+                break;
+
+            case EXPR_TASK_TYPE_ASSIGN_ACCESS: {
+                struct codegen_asm_list tmp = codegen_asm_list_clone(*task.access);
+                codegen_asm_list_concat(code, &tmp);
+
+                // адрес для чтения результата остаётся под записываемым значением
+                if (!task.index && is_address_kept(expr)) {
+                    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_DUP));
+                }
+
+                break;
+            }
+
+            case EXPR_TASK_TYPE_ASSIGN: {
+                const struct flow_graph_expr * const lhs = expr->binary.lhs;
+                const size_t size = get_type_size(lhs->type);
+
+                cast_value(expr->binary.rhs, lhs->type, code);
+
+                // store size
+                struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_STORE);
+                ins.op.imm8 = size;
+                codegen_asm_list_append(code, ins);
+
+                if (task.index) {
+                    codegen_asm_list_fini(task.access);
+                    free(task.access);
+                    break;
+                }
+
+                // адрес уже лежит на стеке, см. EXPR_TASK_TYPE_ASSIGN_ACCESS
+                if (is_address_kept(expr)) {
+                    codegen_asm_list_fini(task.access);
+                } else {
+                    codegen_asm_list_concat(code, task.access);
+                }
+
+                free(task.access);
+
+                // load size
+                ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+                ins.op.imm8 = size;
+                codegen_asm_list_append(code, ins);
+                break;
+            }
+        }
+    }
+
+    free(stack.values);
+}
+
+static void generate_expr(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * expr,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    generate_expr_root(subroutine, frames, EXPR_TASK_TYPE_EXPR, expr, false, code, const_space);
+}
+
+// значение выражения, приведённое к типу type, см. push_value
+static void generate_value(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * value,
+        const struct ast_type_reference * type,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    if (is_converted(value, type)) {
+        generate_expr_root(subroutine, frames, EXPR_TASK_TYPE_WORD, value, get_type_size(type), code, const_space);
+    } else {
+        generate_expr(subroutine, frames, value, code, const_space);
+    }
+
+    cast_value(value, type, code);
+}
+
+// точное значение выражения, расширенное до слова
+static void generate_word(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * expr,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    generate_expr_root(subroutine, frames, EXPR_TASK_TYPE_WORD, expr, 4, code, const_space);
+}
+
+static void generate_node_comment(const struct flow_graph_node * node, struct codegen_asm_list * code) {
+    char comment[1024];
+    snprintf(
+            comment,
+            1024,
+            "%zu: %s at %zu:%zu",
+            node->index,
+            NODE_TYPE_NAME[node->_type],
+            node->position.row,
+            node->position.column
+    );
+    codegen_asm_list_append(code, codegen_asm_init_comment(strdup(comment)));
+}
+
+static void generate_drop(const struct ast_type_reference * value_type, struct codegen_asm_list * code) {
+    // get SP
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
+    ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+    codegen_asm_list_append(code, ins);
+
+    // const 4
+    // db sizeof(value_type)
+    generate_const_int(get_type_size(value_type), code);
+
+    // add
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+
+    // set SP
+    ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
+    ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+    codegen_asm_list_append(code, ins);
+}
+
+// значение выражения-оператора не нужно: присваивание его не перечитывает, остальное снимается со стека
+static void generate_statement(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * expr,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+        generate_expr_root(subroutine, frames, EXPR_TASK_TYPE_EXPR, expr, true, code, const_space);
+        return;
+    }
+
+    generate_expr(subroutine, frames, expr, code, const_space);
+    generate_drop(expr->type, code);
+}
+
+// присваивание переменной частного или остатка от деления переменных или литералов
+static bool is_division_assignment(const struct flow_graph_expr * expr) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+        || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+        || expr->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const value = expr->binary.rhs;
+
+    return value->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+           && (value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE
+               || value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER)
+           && ast_type_reference_is_numeric(value->type)
+           && (value->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL
+               || value->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL)
+           && (value->binary.rhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL
+               || value->binary.rhs->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL);
+}
+
+static bool is_operand_local(const struct flow_graph_expr * operand, const struct flow_graph_local * local) {
+    return operand->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && operand->local.local == local;
+}
+
+// соседние присваивания частного и остатка одних операндов, см. flow_graph_optimize_fuse_division;
+// первое не должно менять ни операнды, ни переменную второго, иначе порядок записей важен
+static bool is_divmod_pair(const struct flow_graph_expr * first, const struct flow_graph_expr * second) {
+    if (!is_division_assignment(first) || !is_division_assignment(second)) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const lhs = first->binary.rhs;
+    const struct flow_graph_expr * const rhs = second->binary.rhs;
+    const struct flow_graph_local * const local = first->binary.lhs->local.local;
+
+    return lhs->binary.op != rhs->binary.op
+           && ast_type_reference_equals(lhs->type, rhs->type)
+           && flow_graph_expr_equals(lhs->binary.lhs, rhs->binary.lhs)
+           && flow_graph_expr_equals(lhs->binary.rhs, rhs->binary.rhs)
+           && local != second->binary.lhs->local.local
+           && !is_operand_local(lhs->binary.lhs, local)
+           && !is_operand_local(lhs->binary.rhs, local);
+}
+
+// слово с вершины стека усекается до типа операции, приводится к типу переменной и записывается в неё
+static void generate_put_division(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * assignment,
+        struct codegen_asm_list * code
+) {
+    const struct flow_graph_expr * const lhs = assignment->binary.lhs;
+
+    cast_to_type(internal_int_type, assignment->binary.rhs->type, code);
+    cast_to_type(assignment->binary.rhs->type, lhs->type, code);
+
+    generate_local_address(subroutine, frames, lhs->local.local, code);
+
+    // put sizeof(local)
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_PUT);
+    ins.op.imm8 = get_type_size(lhs->type);
+    codegen_asm_list_append(code, ins);
+}
+
+// divmod оставляет остаток над частным, поэтому остаток записывается первым
+static void generate_divmod(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * first,
+        const struct flow_graph_expr * second,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    const struct flow_graph_expr * const division = first->binary.rhs;
+    const bool is_divide_first = division->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE;
+
+    generate_word(subroutine, frames, division->binary.lhs, code, const_space);
+    generate_word(subroutine, frames, division->binary.rhs, code, const_space);
+
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_DIVMOD));
+
+    generate_put_division(subroutine, frames, is_divide_first ? second : first, code);
+    generate_put_division(subroutine, frames, is_divide_first ? first : second, code);
+}
+
+// переход к блоку, NULL означает возврат без значения
+static void generate_jump(
+        enum codegen_asm_op_opcode opcode,
+        const struct flow_graph_block * next,
+        struct codegen_asm_list * code
+) {
+    struct codegen_asm ins = codegen_asm_init_op(opcode);
+
+    if (next) {
+        ins.op.label = generate_label(BLOCK_LABEL_PREFIX, next->index);
+    } else {
+        ins.op.label = strdup(RETURN_VOID_LABEL);
+    }
+
+    codegen_asm_list_append(code, ins);
+}
+
+// генерирует отрицание условия, если его можно получить бесплатно: сравнение заменяется
+// на противоположное, а у логического отрицания отбрасывается xor
+static bool generate_inverted_cond(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * cond,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    if (!codegen_layout_is_invertible(cond)) {
+        return false;
+    }
+
+    if (cond->_type == FLOW_GRAPH_EXPR_TYPE_UNARY) {
+        generate_expr(subroutine, frames, cond->unary.value, code, const_space);
+        return true;
+    }
+
+    enum codegen_asm_op_cmp cmp;
+
+    switch (cond->binary.op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_EQ:
+            cmp = CODEGEN_ASM_OP_CMP_NE;
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_NE:
+            cmp = CODEGEN_ASM_OP_CMP_EQ;
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_LT:
+            cmp = CODEGEN_ASM_OP_CMP_GE;
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_LE:
+            cmp = CODEGEN_ASM_OP_CMP_GT;
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_GT:
+            cmp = CODEGEN_ASM_OP_CMP_LE;
+            break;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_GE:
+            cmp = CODEGEN_ASM_OP_CMP_LT;
+            break;
+
+        default:
+            unreachable();
+    }
+
+    generate_word(subroutine, frames, cond->binary.lhs, code, const_space);
+    generate_word(subroutine, frames, cond->binary.rhs, code, const_space);
+
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+    ins.op.cmp = cmp;
+    codegen_asm_list_append(code, ins);
+
+    return true;
+}
+
+// суммарный размер переменных с номерами [begin, end) в кадре подпрограммы
+static size_t get_locals_size(const struct flow_graph_subroutine * subroutine, size_t begin, size_t end) {
+    size_t result = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+        result += get_type_size(subroutine->locals.values[i]->type);
+    }
+
+    return result;
+}
+
+// вызов, значение которого возвращается без приведения, может занять кадр вызывающей подпрограммы:
+// ячейки результата у них одного размера, а аргументы вместе с ячейкой переносит leave; из постоянного
+// кадра снимать нечего, а кадр на стеке не сменить постоянным: его вызывающая ждёт результат в ячейке
+static bool is_tail_call(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * value
+) {
+    if (value->_type != FLOW_GRAPH_EXPR_TYPE_CALL) {
+        return false;
+    }
+
+    const struct flow_graph_subroutine * const callee = value->call.subroutine;
+
+    // встроенные подпрограммы устроены по-своему, см. codegen_builtins
+    if (!callee->defined || !ast_type_reference_equals(value->type, subroutine->return_type)) {
+        return false;
+    }
+
+    if (codegen_frames_is_static(frames, subroutine)) {
+        return true;
+    }
+
+    return !codegen_frames_is_static(frames, callee)
+           && get_type_size(callee->return_type) + get_locals_size(callee, 0, callee->args_num) <= UINT8_MAX;
+}
+
+// хвостовой вызов: на стек кладутся ячейка результата и аргументы, как при обычном вызове, а leave
+// переносит их на место текущего кадра и снимает его; вызываемая подпрограмма строит свой кадр
+// на том же месте и возвращается сразу к вызывающей, адрес возврата которой остаётся на стеке адресов
+static void generate_tail_call(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_expr * call,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    const struct flow_graph_subroutine * const callee = call->call.subroutine;
+    const size_t result_size = get_type_size(callee->return_type);
+
+    if (!codegen_frames_is_static(frames, callee)) {
+        generate_zeros(result_size, code);
+    }
+
+    for (size_t i = 0; i < call->call.args.size; ++i) {
+        const struct flow_graph_expr * const arg = call->call.args.values[i];
+
+        generate_value(subroutine, frames, arg, callee->locals.values[i]->type, code, const_space);
+    }
+
+    struct codegen_asm ins;
+
+    if (!codegen_frames_is_static(frames, subroutine)) {
+        // leave sizeof(return_type) + args_size
+        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LEAVE);
+        ins.op.imm8 = result_size + get_locals_size(callee, 0, callee->args_num);
+        codegen_asm_list_append(code, ins);
+    }
+
+    // goto callee
+    ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GOTO);
+    ins.op.label = strdup(callee->id);
+    codegen_asm_list_append(code, ins);
+}
+
+// значение переменной, расширенное до слова, как его сравнивает generate_inverted_cond
+static void generate_local_word(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_local * local,
+        struct codegen_asm_list * code
+) {
+    generate_local_address(subroutine, frames, local, code);
+
+    // load sizeof(local)
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+    ins.op.imm8 = get_type_size(local->type);
+    codegen_asm_list_append(code, ins);
+
+    cast_to_type(local->type, internal_int_type, code);
+}
+
+// переход в default, если значение переменной по сравнению cmp с bound не попадает в таблицу
+static void generate_switch_bound(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct codegen_switch * value,
+        int32_t bound,
+        enum codegen_asm_op_cmp cmp,
+        struct codegen_asm_list * code
+) {
+    generate_local_word(subroutine, frames, value->local, code);
+    generate_const_int((uint32_t) bound, code);
+
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CMP);
+    ins.op.cmp = cmp;
+    codegen_asm_list_append(code, ins);
+
+    generate_jump(CODEGEN_ASM_OP_OPCODE_IFZ, value->default_next, code);
+}
+
+// таблица значений: по литералу каждого перехода, приведённому к типу результата подпрограммы
+static void generate_switch_values(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_switch * value,
+        struct space * const_space
+) {
+    const size_t entry_size = get_type_size(subroutine->return_type);
+    struct codegen_asm data = codegen_asm_init_data(value->size * entry_size, mallocs(value->size * entry_size));
+
+    for (size_t k = 0; k < value->size; ++k) {
+        const struct flow_graph_expr * const literal = value->targets[k]->terminator._return.value;
+
+        const uint32_t word = literal->literal.literal->_type == FLOW_GRAPH_LITERAL_TYPE_CHAR
+                ? (uint8_t) literal->literal.literal->_char.value
+                : get_literal_index(literal);
+
+        // на стеке значения лежат младшим байтом вперёд, приведение к меньшему типу отбрасывает старшие
+        for (size_t b = 0; b < entry_size; ++b) {
+            data.data.data[k * entry_size + b] = (unsigned char) (word >> (8 * b));
+        }
+    }
+
+    codegen_asm_list_append(&const_space->listing, data);
+}
+
+// цепочка сравнений одной переменной с литералами: значение переменной после проверки границ
+// выбирает из таблицы в пространстве констант адрес перехода или сразу значение результата
+static void generate_switch(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct codegen_switch * value,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    const struct ast_type_reference * const type = value->local->type;
+    const int32_t high = (int32_t) (value->low + (int64_t) value->size - 1);
+
+    // границы, за которые значение переменной не выходит, проверять не нужно
+    int64_t type_low = INT32_MIN;
+    int64_t type_high = INT32_MAX;
+
+    switch (type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            type_low = 0;
+            type_high = UINT8_MAX;
+            break;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            type_low = INT16_MIN;
+            type_high = INT16_MAX;
+            break;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            type_low = 0;
+            type_high = UINT16_MAX;
+            break;
+
+        default:
+            break;
+    }
+
+    if (type_low < value->low) {
+        generate_switch_bound(subroutine, frames, value, value->low, CODEGEN_ASM_OP_CMP_GE, code);
+    }
+
+    if (type_high > high) {
+        generate_switch_bound(subroutine, frames, value, high, CODEGEN_ASM_OP_CMP_LE, code);
+    }
+
+    // адрес элемента: table + (value - low) * entry_size
+
+    generate_local_word(subroutine, frames, value->local, code);
+
+    if (value->low != 0) {
+        generate_const_int((uint32_t) value->low, code);
+        codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
+    }
+
+    const size_t entry_size = value->is_values ? get_type_size(subroutine->return_type) : POINTER_SIZE;
+
+    if (entry_size > 1) {
+        // размер элемента — степень двойки, сдвиг дешевле умножения
+        generate_const_int(entry_size == 2 ? 1 : 2, code);
+        codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SHL));
+    }
+
+    const char * const label = space_new_label(const_space);
+
+    if (value->is_values) {
+        generate_switch_values(subroutine, value, const_space);
+    } else {
+        for (size_t k = 0; k < value->size; ++k) {
+            const struct flow_graph_block * const target = value->targets[k];
+
+            codegen_asm_list_append(&const_space->listing, codegen_asm_init_label_data(
+                    target ? generate_label(BLOCK_LABEL_PREFIX, target->index) : strdup(RETURN_VOID_LABEL)
+            ));
+        }
+    }
+
+    // const 4
+    struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_CONST);
+    ins.op.imm8 = POINTER_SIZE;
+    codegen_asm_list_append(code, ins);
+
+    // dd label
+    codegen_asm_list_append(code, codegen_asm_init_label_data(strdup(label)));
+
+    // add
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+
+    // load entry_size
+    ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LOAD);
+    ins.op.imm8 = entry_size;
+    codegen_asm_list_append(code, ins);
+
+    if (value->is_values) {
+        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GOTO);
+        ins.op.label = strdup(LEAVE_LABEL);
+        codegen_asm_list_append(code, ins);
+    } else {
+        codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_JUMP));
+    }
+}
+
+// following - блок, который идёт в листинге сразу после этого, в него можно не переходить явно;
+// за последним блоком идёт возврат без значения
+static void generate_block(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        const struct flow_graph_block * block,
+        const struct flow_graph_block * following,
+        const struct codegen_switch_list * switches,
+        struct codegen_asm_list * code,
+        struct space * const_space
+) {
+    codegen_asm_list_append(code, codegen_asm_init_label(generate_label(BLOCK_LABEL_PREFIX, block->index)));
+
+    for (size_t i = 0; i < block->size; ++i) {
+        const struct flow_graph_node * const node = block->nodes[i];
+
+        generate_node_comment(node, code);
+
+        if (i + 1 < block->size && is_divmod_pair(node->expr.expr, block->nodes[i + 1]->expr.expr)) {
+            generate_node_comment(block->nodes[i + 1], code);
+            generate_divmod(subroutine, frames, node->expr.expr, block->nodes[i + 1]->expr.expr, code, const_space);
+            ++i;
+            continue;
+        }
+
+        generate_statement(subroutine, frames, node->expr.expr, code, const_space);
+    }
+
+    const struct flow_graph_block_terminator * const terminator = &block->terminator;
+    const struct codegen_switch * const value = codegen_switch_list_get(switches, block);
+
+    if (value) {
+        generate_node_comment(terminator->node, code);
+        generate_switch(subroutine, frames, value, code, const_space);
+        return;
+    }
+
+    switch (terminator->_type) {
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP:
+            if (terminator->jump.next != following) {
+                generate_jump(CODEGEN_ASM_OP_OPCODE_GOTO, terminator->jump.next, code);
+            }
+
+            break;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND:
+            generate_node_comment(terminator->node, code);
+
+            // если следом идёт ветка else, условие инвертируется, и переход остаётся один
+            if (terminator->cond.then_next != following
+                    && terminator->cond.else_next == following
+                    && generate_inverted_cond(subroutine, frames, terminator->cond.cond, code, const_space)) {
+                generate_jump(CODEGEN_ASM_OP_OPCODE_IFZ, terminator->cond.then_next, code);
+                break;
+            }
+
+            generate_expr(subroutine, frames, terminator->cond.cond, code, const_space);
+            generate_jump(CODEGEN_ASM_OP_OPCODE_IFZ, terminator->cond.else_next, code);
+
+            if (terminator->cond.then_next != following) {
+                generate_jump(CODEGEN_ASM_OP_OPCODE_GOTO, terminator->cond.then_next, code);
+            }
+
+            break;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN:
+            generate_node_comment(terminator->node, code);
+
+            if (terminator->_return.value && is_tail_call(subroutine, frames, terminator->_return.value)) {
+                generate_tail_call(subroutine, frames, terminator->_return.value, code, const_space);
+            } else if (terminator->_return.value) {
+                generate_value(subroutine, frames, terminator->_return.value, subroutine->return_type, code, const_space);
+
+                struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GOTO);
+                ins.op.label = strdup(LEAVE_LABEL);
+                codegen_asm_list_append(code, ins);
+            } else if (following) {
+                generate_jump(CODEGEN_ASM_OP_OPCODE_GOTO, NULL, code);
+            }
+
+            break;
+    }
+}
+
+// пролог постоянного кадра: аргументы снимаются со стека в свои переменные, последний лежит ниже всех
+static void generate_static_prologue(const struct flow_graph_subroutine * subroutine, struct codegen_asm_list * code) {
+    const size_t args_size = get_locals_size(subroutine, 0, subroutine->args_num);
+
+    if (args_size == 0) {
+        return;
+    }
+
+    if (args_size <= UINT8_MAX) {
+        generate_static_address(subroutine, subroutine->args_num - 1, code);
+
+        // put args_size
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_PUT);
+        ins.op.imm8 = args_size;
+        codegen_asm_list_append(code, ins);
+        return;
+    }
+
+    for (size_t i = subroutine->args_num; i > 0; --i) {
+        generate_static_address(subroutine, i - 1, code);
+
+        // put sizeof(arg)
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_PUT);
+        ins.op.imm8 = get_type_size(subroutine->locals.values[i - 1]->type);
+        codegen_asm_list_append(code, ins);
+    }
+}
+
+// подпрограмме на стеке нужен кадр, если она вызывает другие: вызов снимает со стека аргументы, размер
+// которых знает только вызываемая, а хвостовой вызов снимает кадр инструкцией leave; в остальных
+// подпрограммах глубина стека вычислений известна после каждой инструкции, и переменные можно адресовать от SP
+static bool needs_frame(const struct codegen_asm_list * body) {
+    for (size_t i = 0; i < body->size; ++i) {
+        const struct codegen_asm * const item = &body->values[i];
+
+        if (item->_type == CODEGEN_ASM_TYPE_OP
+                && (item->op.opcode == CODEGEN_ASM_OP_OPCODE_CALL
+                    || item->op.opcode == CODEGEN_ASM_OP_OPCODE_SET
+                    || item->op.opcode == CODEGEN_ASM_OP_OPCODE_LEAVE)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// на сколько байт инструкция подпрограммы без кадра сдвигает вершину стека вниз
+static ptrdiff_t get_stack_effect(const struct codegen_asm_op * op) {
+    switch (op->opcode) {
+        case CODEGEN_ASM_OP_OPCODE_CONST:
+            return op->imm8;
+
+        case CODEGEN_ASM_OP_OPCODE_DUP:
+        case CODEGEN_ASM_OP_OPCODE_GET:
+            return 4;
+
+        case CODEGEN_ASM_OP_OPCODE_LOAD:
+            return (ptrdiff_t) op->imm8 - 4;
+
+        case CODEGEN_ASM_OP_OPCODE_STORE:
+        case CODEGEN_ASM_OP_OPCODE_PUT:
+            return -(ptrdiff_t) op->imm8 - 4;
+
+        case CODEGEN_ASM_OP_OPCODE_ZEXT:
+        case CODEGEN_ASM_OP_OPCODE_SEXT:
+            return 4 - (ptrdiff_t) op->imm2;
+
+        case CODEGEN_ASM_OP_OPCODE_TRUNC:
+            return (ptrdiff_t) op->imm2 - 4;
+
+        case CODEGEN_ASM_OP_OPCODE_ADD:
+        case CODEGEN_ASM_OP_OPCODE_SUB:
+        case CODEGEN_ASM_OP_OPCODE_MUL:
+        case CODEGEN_ASM_OP_OPCODE_DIV:
+        case CODEGEN_ASM_OP_OPCODE_REM:
+        case CODEGEN_ASM_OP_OPCODE_MULHU:
+        case CODEGEN_ASM_OP_OPCODE_AND:
+        case CODEGEN_ASM_OP_OPCODE_OR:
+        case CODEGEN_ASM_OP_OPCODE_XOR:
+        case CODEGEN_ASM_OP_OPCODE_SHL:
+        case CODEGEN_ASM_OP_OPCODE_SHR:
+        case CODEGEN_ASM_OP_OPCODE_CMP:
+        case CODEGEN_ASM_OP_OPCODE_IFZ:
+        case CODEGEN_ASM_OP_OPCODE_JUMP:
+            return -4;
+
+        case CODEGEN_ASM_OP_OPCODE_IN:
+            return 1;
+
+        case CODEGEN_ASM_OP_OPCODE_OUT:
+            return -1;
+
+        case CODEGEN_ASM_OP_OPCODE_DIVMOD:
+        case CODEGEN_ASM_OP_OPCODE_GOTO:
+        case CODEGEN_ASM_OP_OPCODE_NOP:
+            return 0;
+
+        case CODEGEN_ASM_OP_OPCODE_SET:
+        case CODEGEN_ASM_OP_OPCODE_CALL:
+        case CODEGEN_ASM_OP_OPCODE_RET:
+        case CODEGEN_ASM_OP_OPCODE_ENTER:
+        case CODEGEN_ASM_OP_OPCODE_LEAVE:
+        case CODEGEN_ASM_OP_OPCODE_SLIDE:
+        case CODEGEN_ASM_OP_OPCODE_HLT:
+            break;
+    }
+
+    unreachable();
+}
+
+// в подпрограмме без кадра адреса переменных `get fp; const offset; sub` из generate_frame_address
+// пересчитываются от SP: конец ячейки результата, куда указывал бы FP, лежит на extent байт выше SP
+// после пролога, а каждый блок начинается с пустым стеком вычислений
+static void rebase_frame_addresses(struct codegen_asm_list * body, size_t extent) {
+    size_t depth = 0;
+
+    for (size_t i = 0; i < body->size; ++i) {
+        struct codegen_asm * const item = &body->values[i];
+
+        if (item->_type == CODEGEN_ASM_TYPE_LABEL) {
+            depth = 0;
+            continue;
+        }
+
+        if (item->_type != CODEGEN_ASM_TYPE_OP) {
+            continue;
+        }
+
+        if (item->op.opcode == CODEGEN_ASM_OP_OPCODE_GET && item->op.reg == CODEGEN_ASM_OP_REG_FP) {
+            uint32_t * const offset = (uint32_t *) body->values[i + 2].data.data;
+            assert(body->values[i + 3].op.opcode == CODEGEN_ASM_OP_OPCODE_SUB);
+
+            item->op.reg = CODEGEN_ASM_OP_REG_SP;
+            *offset = (uint32_t) (depth + extent - *offset);
+            body->values[i + 3].op.opcode = CODEGEN_ASM_OP_OPCODE_ADD;
+        }
+
+        depth += get_stack_effect(&item->op);
+    }
+}
+
+// пролог: enter сохраняет FP на стеке адресов возврата и ставит его на конец ячейки результата
+// над аргументами, под аргументами резервируется место для остальных переменных; подпрограмма
+// без кадра только резервирует место
+static void generate_prologue(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        bool has_frame,
+        struct codegen_asm_list * code
+) {
+    if (codegen_frames_is_static(frames, subroutine)) {
+        generate_static_prologue(subroutine, code);
+        return;
+    }
+
+    const size_t frame_size =
+            get_type_size(subroutine->return_type) + get_locals_size(subroutine, 0, subroutine->args_num);
+    const size_t own_size =
+            codegen_frames_get(frames, subroutine)->slots.size - get_locals_size(subroutine, 0, subroutine->args_num);
+
+    if (has_frame) {
+        // enter sizeof(return_type) + args_size
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ENTER);
+        ins.op.imm8 = frame_size <= UINT8_MAX ? frame_size : 0;
+        codegen_asm_list_append(code, ins);
+
+        if (frame_size > UINT8_MAX) {
+            // FP = SP + frame_size
+            ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
+            ins.op.reg = CODEGEN_ASM_OP_REG_SP;
+            codegen_asm_list_append(code, ins);
+
+            generate_const_int(frame_size, code);
+            codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+
+            ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
+            ins.op.reg = CODEGEN_ASM_OP_REG_FP;
+            codegen_asm_list_append(code, ins);
+        }
+    }
+
+    // небольшой кадр резервируется одной инструкцией, начальные значения переменных не важны
+    if (own_size > RESERVE_ZEROS_MAX) {
+        generate_sp_shift(own_size, CODEGEN_ASM_OP_OPCODE_SUB, code);
+    } else if (own_size > 0) {
+        generate_zeros(own_size, code);
+    }
+}
+
+// эпилог: leave переносит значение в ячейку результата и снимает кадр вместе с аргументами,
+// как того ждут вызывающие, см. также codegen_builtins; ret возвращает управление;
+// подпрограмма без кадра так же переносит значение инструкцией slide, отсчитывая кадр от SP,
+// а подпрограмма с постоянным кадром оставляет значение на стеке вместо ячейки
+static void generate_epilogue(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames,
+        bool has_frame,
+        struct codegen_asm_list * code
+) {
+    if (has_frame) {
+        // leave sizeof(return_type)
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_LEAVE);
+        ins.op.imm8 = get_type_size(subroutine->return_type);
+        codegen_asm_list_append(code, ins);
+    } else if (!codegen_frames_is_static(frames, subroutine)) {
+        // slide sizeof(return_type), sizeof(return_type) + locals_size
+        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SLIDE);
+        ins.op.slide.size = get_type_size(subroutine->return_type);
+        ins.op.slide.offset = ins.op.slide.size + codegen_frames_get(frames, subroutine)->slots.size;
+        codegen_asm_list_append(code, ins);
+    }
+
+    // ret
+    codegen_asm_list_append(code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_RET));
+}
+
+static struct codegen_asm_list generate_subroutine(
+        const struct flow_graph_subroutine * subroutine,
+        const struct codegen_frames * frames
+) {
+    struct codegen_asm_list code = codegen_asm_list_init();
+    struct codegen_asm_list body = codegen_asm_list_init();
+    struct space const_space = space_init("const");
 
     {
         size_t size = strlen(subroutine->filename) + 30;
@@ -875,66 +2255,44 @@ static struct codegen_asm_list generate_subroutine(const struct flow_graph_subro
     codegen_asm_list_append(&const_space.listing, codegen_asm_init_comment(strdup("constants")));
 
     {
-        // prologue
-
-        size_t locals_size = 0;
-        for (size_t i = subroutine->args_num; i < subroutine->locals.size; ++i) {
-            locals_size += get_type_size(subroutine->locals.values[i]->type);
-        }
+        const struct flow_graph_block ** const order =
+                mallocs(sizeof(struct flow_graph_block *) * subroutine->blocks.size);
 
-        // get SP
-        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_SP;
-        codegen_asm_list_append(&code, ins);
+        bool * const skipped = mallocs(sizeof(bool) * subroutine->blocks.size);
+        struct codegen_switch_list switches = codegen_switch_find(subroutine, skipped);
 
-        // const 4
-        // db locals_size
-        generate_const_int(locals_size, &code);
-
-        // sub
-        codegen_asm_list_append(&code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SUB));
-
-        // set SP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_SP;
-        codegen_asm_list_append(&code, ins);
-
-        // get FP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-        codegen_asm_list_append(&code, ins);
+        codegen_layout(&subroutine->blocks, order);
 
-        // get SP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_SP;
-        codegen_asm_list_append(&code, ins);
+        // блоки, которые заменили таблицы, в листинг не попадают
+        size_t size = 0;
 
-        locals_size += POINTER_SIZE;
-        for (size_t i = 0; i < subroutine->args_num; ++i) {
-            locals_size += get_type_size(subroutine->locals.values[i]->type);
+        for (size_t i = 0; i < subroutine->blocks.size; ++i) {
+            if (!skipped[order[i]->index - 1]) {
+                order[size++] = order[i];
+            }
         }
 
-        // const 4
-        // db locals_size
-        generate_const_int(locals_size, &code);
+        for (size_t i = 0; i < size; ++i) {
+            const struct flow_graph_block * const following = i + 1 < size ? order[i + 1] : NULL;
+            generate_block(subroutine, frames, order[i], following, &switches, &body, &const_space);
+        }
 
-        // add
-        codegen_asm_list_append(&code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+        codegen_switch_list_fini(&switches);
+        free(skipped);
+        free(order);
+    }
 
-        // set FP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-        codegen_asm_list_append(&code, ins);
+    const struct codegen_frame * const frame = codegen_frames_get(frames, subroutine);
+    // от SP после пролога до конца ячейки результата
+    const size_t extent = get_type_size(subroutine->return_type) + frame->slots.size;
+    const bool has_frame = !frame->is_static && (extent > UINT8_MAX || needs_frame(&body));
 
-        // get FP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-        codegen_asm_list_append(&code, ins);
+    if (!frame->is_static && !has_frame) {
+        rebase_frame_addresses(&body, extent);
     }
 
-    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
-        generate_node(subroutine, subroutine->nodes.values[i], &code, &const_space);
-    }
+    generate_prologue(subroutine, frames, has_frame, &code);
+    codegen_asm_list_concat(&code, &body);
 
     if (ast_type_reference_is_numeric(subroutine->return_type)) {
         codegen_asm_list_append(&code, codegen_asm_init_label(strdup(RETURN_VOID_LABEL)));
@@ -947,51 +2305,118 @@ static struct codegen_asm_list generate_subroutine(const struct flow_graph_subro
     }
 
     codegen_asm_list_append(&code, codegen_asm_init_label(strdup(LEAVE_LABEL)));
+    generate_epilogue(subroutine, frames, has_frame, &code);
 
-    {
-        // epilogue
+    codegen_asm_list_concat(&code, &const_space.listing);
+    return code;
+}
 
-        // store sizeof(return_type)
-        struct codegen_asm ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_STORE);
-        ins.op.imm8 = get_type_size(subroutine->return_type);
-        codegen_asm_list_append(&code, ins);
+// переменная постоянного кадра: её метка и адрес в области кадров
+struct frame_label {
+
+    size_t address;
+    char * label;
+};
+
+static int compare_frame_labels(const void * lhs, const void * rhs) {
+    const struct frame_label * const lhs_label = lhs;
+    const struct frame_label * const rhs_label = rhs;
+
+    return lhs_label->address < rhs_label->address ? -1 : lhs_label->address > rhs_label->address;
+}
+
+// область кадров: нули с метками переменных постоянных кадров, метки наложенных кадров совпадают;
+// переменные лежат в кадре в том же порядке, что и на стеке, поэтому аргументы снимаются одной put
+static void generate_frames(
+        const struct flow_graph_subroutine_list * subroutines,
+        const struct codegen_frames * frames,
+        struct codegen_asm_list * code
+) {
+    if (frames->area_size == 0) {
+        return;
+    }
 
-        // set FP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_FP;
-        codegen_asm_list_append(&code, ins);
+    size_t labels_size = 0;
 
-        size_t locals_size = 0;
-        for (size_t i = 0; i < subroutine->locals.size; ++i) {
-            locals_size += get_type_size(subroutine->locals.values[i]->type);
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        if (codegen_frames_is_static(frames, subroutines->values[i])) {
+            labels_size += subroutines->values[i]->locals.size;
         }
+    }
 
-        // get SP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_GET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_SP;
-        codegen_asm_list_append(&code, ins);
+    struct frame_label * const labels = mallocs(sizeof(struct frame_label) * (labels_size ? labels_size : 1));
+    size_t size = 0;
 
-        // const 4
-        // db locals_size
-        generate_const_int(locals_size, &code);
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        const struct flow_graph_subroutine * const subroutine = subroutines->values[i];
+        const struct codegen_frame * const frame = codegen_frames_get(frames, subroutine);
 
-        // add
-        codegen_asm_list_append(&code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_ADD));
+        if (!frame->is_static) {
+            continue;
+        }
+
+        for (size_t j = 0; j < subroutine->locals.size; ++j) {
+            labels[size++] = (struct frame_label) {
+                .address = frame->offset + frame->slots.size - frame->slots.offsets[j],
+                .label = generate_frame_label(subroutine, j),
+            };
+        }
+    }
+
+    qsort(labels, size, sizeof(struct frame_label), compare_frame_labels);
+
+    codegen_asm_list_append(code, codegen_asm_init_comment(strdup(FRAMES_LABEL)));
+
+    size_t address = 0;
+
+    for (size_t i = 0; i <= size; ++i) {
+        const size_t next = i < size ? labels[i].address : frames->area_size;
+
+        if (next > address) {
+            // db 0, ...
+            struct codegen_asm ins = codegen_asm_init_data(next - address, mallocs(next - address));
+            memset(ins.data.data, 0, next - address);
+            codegen_asm_list_append(code, ins);
+
+            address = next;
+        }
+
+        if (i < size) {
+            codegen_asm_list_append(code, codegen_asm_init_label(labels[i].label));
+        }
+    }
 
-        // set SP
-        ins = codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_SET);
-        ins.op.reg = CODEGEN_ASM_OP_REG_SP;
-        codegen_asm_list_append(&code, ins);
+    free(labels);
+}
 
-        // ret
-        codegen_asm_list_append(&code, codegen_asm_init_op(CODEGEN_ASM_OP_OPCODE_RET));
+// переменные одного размера, времена жизни которых не пересекаются, делят место в кадре
+static struct codegen_slots generate_slots(const struct flow_graph_subroutine * subroutine) {
+    if (!subroutine->defined) {
+        return (struct codegen_slots) { .offsets = NULL, .size = 0 };
     }
 
-    codegen_asm_list_concat(&code, &const_space.listing);
-    return code;
+    size_t * const sizes = mallocs(sizeof(size_t) * (subroutine->locals.size ? subroutine->locals.size : 1));
+
+    for (size_t i = 0; i < subroutine->locals.size; ++i) {
+        sizes[i] = get_type_size(subroutine->locals.values[i]->type);
+    }
+
+    struct codegen_slots result = codegen_slots_build(subroutine, sizes);
+    free(sizes);
+
+    return result;
 }
 
-struct codegen_asm_list codegen_generate(struct flow_graph_subroutine_list subroutines) {
+struct codegen_options codegen_options_init(void) {
+    return (struct codegen_options) {
+        .static_frames = true,
+    };
+}
+
+struct codegen_asm_list codegen_generate(
+        struct flow_graph_subroutine_list subroutines,
+        const struct codegen_options * options
+) {
     if (!internal_int_type) {
         internal_int_type = ast_type_reference_new_builtin(
                 position_init(0, 0),
@@ -999,6 +2424,21 @@ struct codegen_asm_list codegen_generate(struct flow_graph_subroutine_list subro
         );
     }
 
+    struct codegen_frames frames;
+
+    {
+        struct codegen_slots * const slots =
+                mallocs(sizeof(struct codegen_slots) * (subroutines.size ? subroutines.size : 1));
+
+        for (size_t i = 0; i < subroutines.size; ++i) {
+            const struct flow_graph_subroutine * const subroutine = subroutines.values[i];
+            slots[i] = generate_slots(subroutine);
+        }
+
+        frames = codegen_frames_build(&subroutines, slots, options->static_frames);
+        free(slots);
+    }
+
     struct codegen_asm_list result = codegen_asm_list_init();
 
     for (size_t i = 0; i < subroutines.size; ++i) {
@@ -1008,9 +2448,12 @@ struct codegen_asm_list codegen_generate(struct flow_graph_subroutine_list subro
             continue;
         }
 
-        struct codegen_asm_list subroutine_code = generate_subroutine(subroutine);
+        struct codegen_asm_list subroutine_code = generate_subroutine(subroutine, &frames);
         codegen_asm_list_concat(&result, &subroutine_code);
     }
 
+    generate_frames(&subroutines, &frames, &result);
+    codegen_frames_fini(&frames);
+
     return result;
 }
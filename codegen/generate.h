@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "flow_graph.h"
 #include "asm.h"
 
@@ -8,4 +10,16 @@ extern const char * const codegen_header;
 extern const char * const codegen_footer;
 extern const char * const codegen_builtins;
 
-struct codegen_asm_list codegen_generate(struct flow_graph_subroutine_list subroutines);
+struct codegen_options {
+
+    // подпрограммы, которые не входят в цикл графа вызовов, получают кадры по постоянным адресам,
+    // см. codegen_frames_build
+    bool static_frames;
+};
+
+struct codegen_options codegen_options_init(void);
+
+struct codegen_asm_list codegen_generate(
+        struct flow_graph_subroutine_list subroutines,
+        const struct codegen_options * options
+);
@@ -0,0 +1,203 @@
+#include "layout.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+#define SUCCESSORS_MAX 2
+
+static size_t get_successors(const struct flow_graph_block * block, struct flow_graph_block ** successors) {
+    switch (block->terminator._type) {
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP:
+            successors[0] = block->terminator.jump.next;
+            return 1;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND:
+            successors[0] = block->terminator.cond.then_next;
+            successors[1] = block->terminator.cond.else_next;
+            return 2;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN:
+            return 0;
+    }
+
+    return 0;
+}
+
+// обратные дуги обхода в глубину: back_edges[(index - 1) * SUCCESSORS_MAX + k] для k-го преемника
+static void find_back_edges(const struct flow_graph_block_list * blocks, bool * back_edges) {
+    enum { UNVISITED = 0, ACTIVE, DONE };
+
+    unsigned char * const state = mallocs(sizeof(unsigned char) * blocks->size);
+    memset(state, UNVISITED, sizeof(unsigned char) * blocks->size);
+
+    size_t * const next_successor = mallocs(sizeof(size_t) * blocks->size);
+    memset(next_successor, 0, sizeof(size_t) * blocks->size);
+
+    struct stack stack = stack_init();
+
+    stack_push(&stack, blocks->values[0]);
+    state[0] = ACTIVE;
+
+    while (stack.size > 0) {
+        struct flow_graph_block * const block = stack.values[stack.size - 1];
+        const size_t i = block->index - 1;
+
+        struct flow_graph_block * successors[SUCCESSORS_MAX];
+        const size_t successors_size = get_successors(block, successors);
+
+        if (next_successor[i] >= successors_size) {
+            state[i] = DONE;
+            stack_pop(&stack);
+            continue;
+        }
+
+        const size_t k = next_successor[i]++;
+        struct flow_graph_block * const successor = successors[k];
+
+        if (!successor) {
+            continue;
+        }
+
+        switch (state[successor->index - 1]) {
+            case UNVISITED:
+                state[successor->index - 1] = ACTIVE;
+                stack_push(&stack, successor);
+                break;
+
+            case ACTIVE:
+                back_edges[i * SUCCESSORS_MAX + k] = true;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    free(next_successor);
+    free(state);
+}
+
+bool codegen_layout_is_invertible(const struct flow_graph_expr * cond) {
+    switch (cond->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            return cond->unary.op == FLOW_GRAPH_EXPR_UNARY_OP_NOT;
+
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            switch (cond->binary.op) {
+                case FLOW_GRAPH_EXPR_BINARY_OP_EQ:
+                case FLOW_GRAPH_EXPR_BINARY_OP_NE:
+                case FLOW_GRAPH_EXPR_BINARY_OP_LT:
+                case FLOW_GRAPH_EXPR_BINARY_OP_LE:
+                case FLOW_GRAPH_EXPR_BINARY_OP_GT:
+                case FLOW_GRAPH_EXPR_BINARY_OP_GE:
+                    return true;
+
+                default:
+                    return false;
+            }
+
+        default:
+            return false;
+    }
+}
+
+// заголовок цикла while проверяет условие до тела, такой цикл разворачивается: тело ставится
+// перед заголовком, и на каждой итерации выполняется один условный переход вместо двух;
+// это выгодно, только если условие можно бесплатно инвертировать
+static bool is_rotatable(const struct flow_graph_block * header, const bool * back_edges, const bool * placed) {
+    if (header->terminator._type != FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND
+            || !codegen_layout_is_invertible(header->terminator.cond.cond)) {
+        return false;
+    }
+
+    const struct flow_graph_block * const body = header->terminator.cond.then_next;
+
+    if (!body || body == header || body == header->terminator.cond.else_next || placed[body->index - 1]) {
+        return false;
+    }
+
+    // ветка then должна вести внутрь цикла, а не обратно
+    return !back_edges[(header->index - 1) * SUCCESSORS_MAX];
+}
+
+static const struct flow_graph_block * choose_next(
+        const struct flow_graph_block * block,
+        const bool * back_edges,
+        const bool * headers,
+        const bool * placed
+) {
+    struct flow_graph_block * successors[SUCCESSORS_MAX];
+    const size_t successors_size = get_successors(block, successors);
+
+    // предпочитаем первый непоставленный преемник: для условия это ветка then
+    for (size_t k = 0; k < successors_size; ++k) {
+        const struct flow_graph_block * const successor = successors[k];
+
+        if (!successor || placed[successor->index - 1]) {
+            continue;
+        }
+
+        const bool back_edge = back_edges[(block->index - 1) * SUCCESSORS_MAX + k];
+
+        if (!back_edge && headers[successor->index - 1] && is_rotatable(successor, back_edges, placed)) {
+            return successor->terminator.cond.then_next;
+        }
+
+        return successor;
+    }
+
+    return NULL;
+}
+
+void codegen_layout(const struct flow_graph_block_list * blocks, const struct flow_graph_block ** order) {
+    if (blocks->size == 0) {
+        return;
+    }
+
+    bool * const back_edges = mallocs(sizeof(bool) * blocks->size * SUCCESSORS_MAX);
+    memset(back_edges, 0, sizeof(bool) * blocks->size * SUCCESSORS_MAX);
+
+    bool * const headers = mallocs(sizeof(bool) * blocks->size);
+    memset(headers, 0, sizeof(bool) * blocks->size);
+
+    bool * const placed = mallocs(sizeof(bool) * blocks->size);
+    memset(placed, 0, sizeof(bool) * blocks->size);
+
+    find_back_edges(blocks, back_edges);
+
+    for (size_t i = 0; i < blocks->size; ++i) {
+        struct flow_graph_block * successors[SUCCESSORS_MAX];
+        const size_t successors_size = get_successors(blocks->values[i], successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            if (back_edges[i * SUCCESSORS_MAX + k]) {
+                headers[successors[k]->index - 1] = true;
+            }
+        }
+    }
+
+    // цепочки начинаются с первого непоставленного блока в исходном порядке,
+    // первым всегда идёт входной блок
+
+    size_t size = 0;
+
+    for (size_t i = 0; i < blocks->size; ++i) {
+        const struct flow_graph_block * block = blocks->values[i];
+
+        while (block && !placed[block->index - 1]) {
+            placed[block->index - 1] = true;
+            order[size++] = block;
+
+            block = choose_next(block, back_edges, headers, placed);
+        }
+    }
+
+    free(placed);
+    free(headers);
+    free(back_edges);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "flow_graph.h"
+
+
+// порядок блоков в листинге: блоки выстраиваются в цепочки так, чтобы как можно больше
+// переходов вели в следующий по порядку блок; order должен вмещать blocks->size элементов
+void codegen_layout(const struct flow_graph_block_list * blocks, const struct flow_graph_block ** order);
+
+// условие, отрицание которого ничего не стоит: сравнение или логическое отрицание
+bool codegen_layout_is_invertible(const struct flow_graph_expr * cond);
@@ -0,0 +1,226 @@
+#include "slots.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flow_graph_optimize/liveness.h"
+#include "utils/bitset.h"
+#include "utils/mallocs.h"
+
+
+// обращение к переменной внутри вершины
+struct access {
+
+    size_t local;
+    bool write;
+};
+
+// обращения одной вершины в порядке вычисления
+struct accesses {
+
+    size_t size;
+    size_t capacity;
+    struct access * values;
+};
+
+// пересекающиеся переменные парами номеров - 1 подряд
+struct pairs {
+
+    size_t size;
+    size_t capacity;
+    size_t * values;
+};
+
+// соседи переменной с номером i в графе пересечений лежат в values с offsets[i - 1] по offsets[i]
+struct interferences {
+
+    size_t * offsets;
+    size_t * values;
+};
+
+static void collect_access(struct flow_graph_expr * local, bool write, void * context) {
+    struct accesses * const accesses = context;
+
+    if (accesses->size >= accesses->capacity) {
+        accesses->capacity = accesses->capacity ? accesses->capacity * 2 : 16;
+        accesses->values = reallocs(accesses->values, sizeof(struct access) * accesses->capacity);
+    }
+
+    accesses->values[accesses->size++] = (struct access) { .local = local->local.local->index - 1, .write = write };
+}
+
+// запись в переменную пересекается со всеми живыми в этот момент переменными, даже если
+// записанное значение не читается: запись портит место
+static void add_write(struct pairs * pairs, size_t local, const struct bitset * live) {
+    for (size_t i = 0; i < live->size; ++i) {
+        if (i == local || !bitset_test(live, i)) {
+            continue;
+        }
+
+        if (pairs->size + 2 > pairs->capacity) {
+            pairs->capacity = pairs->capacity ? pairs->capacity * 2 : 16;
+            pairs->values = reallocs(pairs->values, sizeof(size_t) * pairs->capacity);
+        }
+
+        pairs->values[pairs->size++] = local;
+        pairs->values[pairs->size++] = i;
+    }
+}
+
+// обращения вершины просматриваются с конца от живых на выходе, как в анализе живости
+static void scan_node(
+        struct flow_graph_expr * expr,
+        const struct bitset * out,
+        struct bitset * live,
+        struct accesses * accesses,
+        struct pairs * pairs
+) {
+    accesses->size = 0;
+    flow_graph_expr_visit_locals(expr, collect_access, accesses);
+
+    bitset_copy(live, out);
+
+    for (size_t k = accesses->size; k > 0; --k) {
+        const struct access * const access = &accesses->values[k - 1];
+
+        if (access->write) {
+            add_write(pairs, access->local, live);
+            bitset_reset(live, access->local);
+        } else {
+            bitset_set(live, access->local);
+        }
+    }
+}
+
+static struct interferences build_interferences(const struct flow_graph_subroutine * subroutine) {
+    const size_t locals_size = subroutine->locals.size;
+    struct pairs pairs = { 0 };
+
+    if (subroutine->nodes.size > 0) {
+        struct flow_graph_dataflow_result liveness = flow_graph_liveness_build(subroutine);
+        struct bitset live = bitset_init(locals_size);
+        struct accesses accesses = { 0 };
+
+        for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+            struct flow_graph_expr * const expr = flow_graph_node_get_expr(subroutine->nodes.values[i]);
+
+            if (expr) {
+                scan_node(expr, &liveness.out[i], &live, &accesses, &pairs);
+            }
+        }
+
+        // аргументы записываются все сразу перед первой вершиной
+        bitset_copy(&live, &liveness.in[0]);
+
+        for (size_t i = 0; i < subroutine->args_num; ++i) {
+            bitset_set(&live, i);
+        }
+
+        for (size_t i = 0; i < subroutine->args_num; ++i) {
+            add_write(&pairs, i, &live);
+        }
+
+        free(accesses.values);
+        bitset_fini(&live);
+        flow_graph_dataflow_result_fini(&liveness);
+    }
+
+    struct interferences result = {
+        .offsets = mallocs(sizeof(size_t) * (locals_size + 1)),
+        .values = mallocs(sizeof(size_t) * (pairs.size ? pairs.size : 1)),
+    };
+
+    memset(result.offsets, 0, sizeof(size_t) * (locals_size + 1));
+
+    for (size_t k = 0; k < pairs.size; ++k) {
+        ++result.offsets[pairs.values[k] + 1];
+    }
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        result.offsets[i + 1] += result.offsets[i];
+    }
+
+    size_t * const filled = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memcpy(filled, result.offsets, sizeof(size_t) * locals_size);
+
+    for (size_t k = 0; k < pairs.size; k += 2) {
+        const size_t lhs = pairs.values[k];
+        const size_t rhs = pairs.values[k + 1];
+
+        result.values[filled[lhs]++] = rhs;
+        result.values[filled[rhs]++] = lhs;
+    }
+
+    free(filled);
+    free(pairs.values);
+
+    return result;
+}
+
+// переменные раскладываются по порядку жадно: каждая занимает первое место своего размера,
+// которое не занято пересекающимися с ней переменными, или новое место в конце кадра
+struct codegen_slots codegen_slots_build(const struct flow_graph_subroutine * subroutine, const size_t * sizes) {
+    const size_t locals_size = subroutine->locals.size;
+
+    struct codegen_slots result = {
+        .offsets = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1)),
+        .size = 0,
+    };
+
+    struct interferences interferences = build_interferences(subroutine);
+
+    // места по порядку: смещение и размер; у каждой переменной — номер её места
+    size_t * const slot_offsets = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    size_t * const slot_sizes = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    size_t * const slot_of = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    size_t slots_size = 0;
+
+    // отметки номером переменной + 1 для мест, занятых её соседями
+    size_t * const taken = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memset(taken, 0, sizeof(size_t) * locals_size);
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        size_t slot = slots_size;
+
+        // аргументы занимают свои места, каждый отдельное
+        if (i >= subroutine->args_num) {
+            for (size_t k = interferences.offsets[i]; k < interferences.offsets[i + 1]; ++k) {
+                const size_t neighbour = interferences.values[k];
+
+                if (neighbour < i) {
+                    taken[slot_of[neighbour]] = i + 1;
+                }
+            }
+
+            for (size_t s = 0; s < slots_size; ++s) {
+                if (slot_sizes[s] == sizes[i] && taken[s] != i + 1) {
+                    slot = s;
+                    break;
+                }
+            }
+        }
+
+        if (slot == slots_size) {
+            result.size += sizes[i];
+            slot_offsets[slots_size] = result.size;
+            slot_sizes[slots_size++] = sizes[i];
+        }
+
+        slot_of[i] = slot;
+        result.offsets[i] = slot_offsets[slot];
+    }
+
+    free(taken);
+    free(slot_of);
+    free(slot_sizes);
+    free(slot_offsets);
+    free(interferences.values);
+    free(interferences.offsets);
+
+    return result;
+}
+
+void codegen_slots_fini(struct codegen_slots * slots) {
+    free(slots->offsets);
+}
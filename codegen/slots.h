@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "flow_graph.h"
+
+
+// размещение переменных подпрограммы в кадре: переменные одного размера, времена жизни которых
+// не пересекаются, делят одно место; аргументы лежат по порядку в начале кадра, как их кладёт
+// вызывающая, а остальные переменные могут занимать и места аргументов, которые больше не нужны
+struct codegen_slots {
+
+    // offsets[i] — расстояние от начала кадра до переменной с номером i + 1 вместе с её размером:
+    // кадр растёт вниз, переменная лежит по адресу начала кадра - offsets[i]
+    size_t * offsets;
+
+    // размер кадра
+    size_t size;
+};
+
+// sizes[i] — размер переменной с номером i + 1; вершины должны быть пронумерованы по порядку
+struct codegen_slots codegen_slots_build(const struct flow_graph_subroutine * subroutine, const size_t * sizes);
+void codegen_slots_fini(struct codegen_slots * slots);
@@ -0,0 +1,365 @@
+#include "switch.h"
+
+#include <string.h>
+
+#include "utils/mallocs.h"
+
+
+// цепочка заменяется таблицей, только если в ней достаточно сравнений,
+// и таблица заполнена хотя бы наполовину
+#define SWITCH_CASES_MIN 5
+#define SWITCH_DENSITY_PERCENT 50
+
+struct switch_case {
+
+    int32_t key;
+    const struct flow_graph_block * target;
+};
+
+// значение литерала после усечения до его типа и расширения до слова, как его сравнивает кодогенерация
+static int32_t get_key(const struct flow_graph_expr * literal) {
+    const uint32_t value = (uint32_t) literal->literal.literal->_int.value;
+
+    switch (literal->type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            return (uint8_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            return (int16_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return (uint16_t) value;
+
+        default:
+            return (int32_t) value;
+    }
+}
+
+static bool is_int_literal(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL
+           && expr->literal.literal->_type == FLOW_GRAPH_LITERAL_TYPE_INT
+           && ast_type_reference_is_numeric(expr->type);
+}
+
+// блок заканчивается сравнением переменной числового типа с целым литералом
+static bool get_case(const struct flow_graph_block * block, const struct flow_graph_local ** local, int32_t * key) {
+    if (block->terminator._type != FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const cond = block->terminator.cond.cond;
+
+    if (cond->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || cond->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_EQ) {
+        return false;
+    }
+
+    const struct flow_graph_expr * variable = cond->binary.lhs;
+    const struct flow_graph_expr * literal = cond->binary.rhs;
+
+    if (is_int_literal(variable)) {
+        variable = cond->binary.rhs;
+        literal = cond->binary.lhs;
+    }
+
+    if (variable->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL
+            || !ast_type_reference_is_numeric(variable->type)
+            || !ast_type_reference_equals(variable->type, variable->local.local->type)
+            || !is_int_literal(literal)) {
+        return false;
+    }
+
+    *local = variable->local.local;
+    *key = get_key(literal);
+    return true;
+}
+
+// блок продолжает цепочку, если в него ведёт только ветка else предыдущего сравнения,
+// и кроме сравнения той же переменной в нём ничего нет
+static bool is_continuation(
+        const struct flow_graph_block * block,
+        const struct flow_graph_local * local,
+        const size_t * predecessors
+) {
+    const struct flow_graph_local * block_local;
+    int32_t key;
+
+    return block
+           && block->size == 0
+           && predecessors[block->index - 1] == 1
+           && get_case(block, &block_local, &key)
+           && block_local == local;
+}
+
+static void count_predecessors(const struct flow_graph_block_list * blocks, size_t * predecessors) {
+    memset(predecessors, 0, sizeof(size_t) * blocks->size);
+
+    for (size_t i = 0; i < blocks->size; ++i) {
+        const struct flow_graph_block_terminator * const terminator = &blocks->values[i]->terminator;
+
+        switch (terminator->_type) {
+            case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP:
+                if (terminator->jump.next) {
+                    ++predecessors[terminator->jump.next->index - 1];
+                }
+
+                break;
+
+            case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND:
+                if (terminator->cond.then_next) {
+                    ++predecessors[terminator->cond.then_next->index - 1];
+                }
+
+                if (terminator->cond.else_next) {
+                    ++predecessors[terminator->cond.else_next->index - 1];
+                }
+
+                break;
+
+            case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN:
+                break;
+        }
+    }
+}
+
+bool codegen_switch_is_literal_return(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_block * block
+) {
+    if (!block || block->size != 0 || block->terminator._type != FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const value = block->terminator._return.value;
+
+    if (!value || value->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL) {
+        return false;
+    }
+
+    switch (value->literal.literal->_type) {
+        case FLOW_GRAPH_LITERAL_TYPE_INT:
+            return ast_type_reference_is_numeric(value->type)
+                   && ast_type_reference_is_numeric(subroutine->return_type);
+
+        case FLOW_GRAPH_LITERAL_TYPE_CHAR:
+            return ast_type_reference_equals(value->type, subroutine->return_type);
+
+        default:
+            return false;
+    }
+}
+
+// строит таблицу по сравнениям цепочки в порядке проверки: из повторяющихся значений
+// срабатывает первое, пропуски ведут туда же, куда последняя ветка else
+static bool build_table(
+        struct codegen_switch * result,
+        const struct switch_case * cases,
+        size_t cases_size,
+        const struct flow_graph_block * default_next
+) {
+    if (cases_size < SWITCH_CASES_MIN) {
+        return false;
+    }
+
+    int64_t low = cases[0].key;
+    int64_t high = cases[0].key;
+
+    for (size_t i = 1; i < cases_size; ++i) {
+        low = cases[i].key < low ? cases[i].key : low;
+        high = cases[i].key > high ? cases[i].key : high;
+    }
+
+    const int64_t size = high - low + 1;
+
+    if (size * SWITCH_DENSITY_PERCENT > (int64_t) cases_size * 100) {
+        return false;
+    }
+
+    bool * const filled = mallocs(sizeof(bool) * size);
+    memset(filled, 0, sizeof(bool) * size);
+
+    const struct flow_graph_block ** const targets = mallocs(sizeof(struct flow_graph_block *) * size);
+    size_t filled_size = 0;
+
+    for (size_t i = 0; i < cases_size; ++i) {
+        const size_t k = cases[i].key - low;
+
+        if (!filled[k]) {
+            filled[k] = true;
+            targets[k] = cases[i].target;
+            ++filled_size;
+        }
+    }
+
+    if (filled_size < SWITCH_CASES_MIN || size * SWITCH_DENSITY_PERCENT > (int64_t) filled_size * 100) {
+        free(targets);
+        free(filled);
+        return false;
+    }
+
+    for (int64_t k = 0; k < size; ++k) {
+        if (!filled[k]) {
+            targets[k] = default_next;
+        }
+    }
+
+    free(filled);
+
+    result->low = (int32_t) low;
+    result->size = size;
+    result->targets = targets;
+    result->default_next = default_next;
+    return true;
+}
+
+static void append_switch(struct codegen_switch_list * list, struct codegen_switch value) {
+    if (list->size >= list->capacity) {
+        const size_t new_capacity = list->capacity * 2;
+        list->values = reallocs(list->values, sizeof(struct codegen_switch) * new_capacity);
+        list->capacity = new_capacity;
+    }
+
+    list->values[list->size++] = value;
+}
+
+static bool is_table_target(const struct codegen_switch * value, const struct flow_graph_block * block) {
+    for (size_t k = 0; k < value->size; ++k) {
+        if (value->targets[k] == block) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// блоки, которые не нужны после замены цепочки таблицей: продолжения цепочки и блоки, в которые
+// не ведёт ничего, кроме цепочки, если на них не ссылается таблица: повторные сравнения,
+// а для таблицы значений — и блоки, которые возвращают литерал
+static void mark_skipped(const struct codegen_switch * value, const size_t * predecessors, bool * skipped) {
+    for (const struct flow_graph_block * block = value->head->terminator.cond.else_next;
+            block != value->default_next;
+            block = block->terminator.cond.else_next) {
+        skipped[block->index - 1] = true;
+    }
+
+    for (const struct flow_graph_block * block = value->head;
+            block != value->default_next;
+            block = block->terminator.cond.else_next) {
+        const struct flow_graph_block * const target = block->terminator.cond.then_next;
+
+        if (!target || target == value->default_next || (!value->is_values && is_table_target(value, target))) {
+            continue;
+        }
+
+        size_t chain_edges = 0;
+
+        for (const struct flow_graph_block * other = value->head;
+                other != value->default_next;
+                other = other->terminator.cond.else_next) {
+            chain_edges += other->terminator.cond.then_next == target;
+        }
+
+        if (chain_edges == predecessors[target->index - 1]) {
+            skipped[target->index - 1] = true;
+        }
+    }
+}
+
+struct codegen_switch_list codegen_switch_find(const struct flow_graph_subroutine * subroutine, bool * skipped) {
+    const struct flow_graph_block_list * const blocks = &subroutine->blocks;
+
+    struct codegen_switch_list result = {
+            .size = 0,
+            .capacity = 1,
+            .values = mallocs(sizeof(struct codegen_switch)),
+    };
+
+    memset(skipped, 0, sizeof(bool) * blocks->size);
+
+    size_t * const predecessors = mallocs(sizeof(size_t) * blocks->size);
+    count_predecessors(blocks, predecessors);
+
+    // продолжения цепочек не могут быть их началом
+    bool * const continued = mallocs(sizeof(bool) * blocks->size);
+    memset(continued, 0, sizeof(bool) * blocks->size);
+
+    for (size_t i = 0; i < blocks->size; ++i) {
+        const struct flow_graph_local * local;
+        int32_t key;
+
+        if (get_case(blocks->values[i], &local, &key)) {
+            const struct flow_graph_block * const next = blocks->values[i]->terminator.cond.else_next;
+
+            if (is_continuation(next, local, predecessors)) {
+                continued[next->index - 1] = true;
+            }
+        }
+    }
+
+    struct switch_case * cases = mallocs(sizeof(struct switch_case) * blocks->size);
+
+    for (size_t i = 0; i < blocks->size; ++i) {
+        const struct flow_graph_block * const head = blocks->values[i];
+        const struct flow_graph_local * local;
+        int32_t key;
+
+        if (continued[i] || !get_case(head, &local, &key)) {
+            continue;
+        }
+
+        size_t cases_size = 0;
+        const struct flow_graph_block * block = head;
+
+        while (true) {
+            cases[cases_size++] = (struct switch_case) { .key = key, .target = block->terminator.cond.then_next };
+
+            if (!is_continuation(block->terminator.cond.else_next, local, predecessors)) {
+                break;
+            }
+
+            block = block->terminator.cond.else_next;
+            get_case(block, &local, &key);
+        }
+
+        struct codegen_switch value = { .head = head, .local = local };
+
+        if (!build_table(&value, cases, cases_size, block->terminator.cond.else_next)) {
+            continue;
+        }
+
+        value.is_values = true;
+
+        for (size_t k = 0; k < value.size; ++k) {
+            value.is_values &= codegen_switch_is_literal_return(subroutine, value.targets[k]);
+        }
+
+        mark_skipped(&value, predecessors, skipped);
+        append_switch(&result, value);
+    }
+
+    free(cases);
+    free(continued);
+    free(predecessors);
+
+    return result;
+}
+
+void codegen_switch_list_fini(struct codegen_switch_list * list) {
+    for (size_t i = 0; i < list->size; ++i) {
+        free(list->values[i].targets);
+    }
+
+    free(list->values);
+}
+
+const struct codegen_switch * codegen_switch_list_get(
+        const struct codegen_switch_list * list,
+        const struct flow_graph_block * head
+) {
+    for (size_t i = 0; i < list->size; ++i) {
+        if (list->values[i].head == head) {
+            return &list->values[i];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flow_graph.h"
+
+
+// цепочка if/else-if, которая сравнивает одну переменную с целыми литералами:
+// вместо сравнений по очереди значение переменной выбирает переход из таблицы
+struct codegen_switch {
+
+    // блок с первым сравнением; остальные блоки цепочки сравнений не содержат ничего другого
+    const struct flow_graph_block * head;
+    const struct flow_graph_local * local;
+
+    // переходы для значений low, low + 1, ..., low + size - 1 в том виде, в каком их сравнивает
+    // кодогенерация: после расширения до 32-битного слова; значения вне таблицы и пропуски
+    // ведут в default_next; NULL в переходах означает возврат без значения
+    int32_t low;
+    size_t size;
+    const struct flow_graph_block ** targets;
+    const struct flow_graph_block * default_next;
+
+    // все переходы таблицы (и default_next, если в ней есть пропуски) ведут в блоки, которые только
+    // возвращают литерал, см. codegen_switch_is_literal_return: таблица хранит сами значения
+    bool is_values;
+};
+
+struct codegen_switch_list {
+
+    size_t size;
+    size_t capacity;
+    struct codegen_switch * values;
+};
+
+// находит цепочки в блоках подпрограммы; skipped должен вмещать blocks.size элементов,
+// в skipped[index - 1] отмечаются блоки, которые после замены цепочек таблицами не нужны
+struct codegen_switch_list codegen_switch_find(const struct flow_graph_subroutine * subroutine, bool * skipped);
+void codegen_switch_list_fini(struct codegen_switch_list * list);
+
+// цепочка, которая начинается в блоке, или NULL
+const struct codegen_switch * codegen_switch_list_get(
+        const struct codegen_switch_list * list,
+        const struct flow_graph_block * head
+);
+
+// блок без вершин, который возвращает целый литерал из подпрограммы числового типа
+// или символьный литерал из подпрограммы, возвращающей char
+bool codegen_switch_is_literal_return(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_block * block
+);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "flow_graph/block.h"
 #include "flow_graph/expr.h"
 #include "flow_graph/local.h"
 #include "flow_graph/node.h"
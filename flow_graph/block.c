@@ -0,0 +1,211 @@
+#include "block.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/mallocs.h"
+
+
+struct flow_graph_block * flow_graph_block_new(size_t index, struct position position) {
+    struct flow_graph_block * const result = mallocs(sizeof(struct flow_graph_block));
+
+    result->index = index;
+    result->position = position;
+
+    result->size = 0;
+    result->capacity = 1;
+    result->nodes = mallocs(sizeof(struct flow_graph_node *));
+
+    result->terminator = (struct flow_graph_block_terminator) {
+        .node = NULL,
+        ._type = FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN,
+        ._return.value = NULL,
+    };
+
+    return result;
+}
+
+void flow_graph_block_append(struct flow_graph_block * block, struct flow_graph_node * node) {
+    if (block->size >= block->capacity) {
+        const size_t new_capacity = block->capacity * 2;
+        struct flow_graph_node ** const new_nodes =
+                reallocs(block->nodes, sizeof(struct flow_graph_node *) * new_capacity);
+
+        block->nodes = new_nodes;
+        block->capacity = new_capacity;
+    }
+
+    block->nodes[block->size] = node;
+    ++block->size;
+}
+
+void flow_graph_block_delete(struct flow_graph_block * block) {
+    if (!block) {
+        return;
+    }
+
+    free(block->nodes);
+    free(block);
+}
+
+struct flow_graph_block_list flow_graph_block_list_init(void) {
+    return (struct flow_graph_block_list) {
+        .size = 0,
+        .capacity = 1,
+        .values = mallocs(sizeof(struct flow_graph_block *)),
+    };
+}
+
+void flow_graph_block_list_append(struct flow_graph_block_list * list, struct flow_graph_block * value) {
+    if (list->size >= list->capacity) {
+        const size_t new_capacity = list->capacity * 2;
+        struct flow_graph_block ** const new_values =
+                reallocs(list->values, sizeof(struct flow_graph_block *) * new_capacity);
+
+        list->values = new_values;
+        list->capacity = new_capacity;
+    }
+
+    list->values[list->size] = value;
+    ++list->size;
+}
+
+void flow_graph_block_list_fini(struct flow_graph_block_list * list) {
+    for (size_t i = 0; i < list->size; ++i) {
+        flow_graph_block_delete(list->values[i]);
+    }
+
+    free(list->values);
+    *list = (struct flow_graph_block_list) { 0 };
+}
+
+static void count_predecessor(const struct flow_graph_node * node, size_t * predecessors) {
+    if (node) {
+        ++predecessors[node->index - 1];
+    }
+}
+
+static void mark_leader(const struct flow_graph_node * node, bool * leaders) {
+    if (node) {
+        leaders[node->index - 1] = true;
+    }
+}
+
+static struct flow_graph_block * block_of(const struct flow_graph_node * node, struct flow_graph_block ** blocks) {
+    return node ? blocks[node->index - 1] : NULL;
+}
+
+static void fill_block(
+        struct flow_graph_block * block,
+        struct flow_graph_node * node,
+        const bool * leaders,
+        struct flow_graph_block ** blocks
+) {
+    while (true) {
+        if (node->_type == FLOW_GRAPH_NODE_TYPE_COND) {
+            block->terminator = (struct flow_graph_block_terminator) {
+                .node = node,
+                ._type = FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND,
+                .cond = {
+                    .cond = node->cond.cond,
+                    .then_next = block_of(node->cond.then_next, blocks),
+                    .else_next = block_of(node->cond.else_next, blocks),
+                },
+            };
+
+            return;
+        }
+
+        struct flow_graph_node * const next = node->expr.next;
+
+        if (!next) {
+            block->terminator = (struct flow_graph_block_terminator) {
+                .node = node,
+                ._type = FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN,
+                ._return.value = node->expr.expr,
+            };
+
+            return;
+        }
+
+        if (node->expr.expr) {
+            flow_graph_block_append(block, node);
+        }
+
+        if (leaders[next->index - 1]) {
+            block->terminator = (struct flow_graph_block_terminator) {
+                .node = node,
+                ._type = FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP,
+                .jump.next = block_of(next, blocks),
+            };
+
+            return;
+        }
+
+        node = next;
+    }
+}
+
+struct flow_graph_block_list flow_graph_block_list_build(const struct flow_graph_node_list * nodes) {
+    struct flow_graph_block_list result = flow_graph_block_list_init();
+
+    if (nodes->size == 0) {
+        return result;
+    }
+
+    size_t * const predecessors = mallocs(sizeof(size_t) * nodes->size);
+    memset(predecessors, 0, sizeof(size_t) * nodes->size);
+
+    bool * const leaders = mallocs(sizeof(bool) * nodes->size);
+    memset(leaders, 0, sizeof(bool) * nodes->size);
+
+    struct flow_graph_block ** const blocks = mallocs(sizeof(struct flow_graph_block *) * nodes->size);
+    memset(blocks, 0, sizeof(struct flow_graph_block *) * nodes->size);
+
+    // блок начинается с первой вершины, с цели условного перехода
+    // и с любой вершины, в которую ведёт не ровно одна дуга
+
+    leaders[0] = true;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        const struct flow_graph_node * const node = nodes->values[i];
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                count_predecessor(node->expr.next, predecessors);
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                count_predecessor(node->cond.then_next, predecessors);
+                count_predecessor(node->cond.else_next, predecessors);
+
+                mark_leader(node->cond.then_next, leaders);
+                mark_leader(node->cond.else_next, leaders);
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        if (predecessors[i] != 1) {
+            leaders[i] = true;
+        }
+
+        if (leaders[i]) {
+            blocks[i] = flow_graph_block_new(result.size + 1, nodes->values[i]->position);
+            flow_graph_block_list_append(&result, blocks[i]);
+        }
+    }
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        if (blocks[i]) {
+            fill_block(blocks[i], nodes->values[i], leaders, blocks);
+        }
+    }
+
+    free(blocks);
+    free(leaders);
+    free(predecessors);
+
+    return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "node.h"
+
+
+enum flow_graph_block_terminator_type {
+
+    FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP = 0,
+    FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND,
+    FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN,
+};
+
+struct flow_graph_block;
+
+struct flow_graph_block_terminator_jump {
+
+    struct flow_graph_block * next;
+};
+
+// NULL в качестве перехода означает возврат без значения
+struct flow_graph_block_terminator_cond {
+
+    struct flow_graph_expr * cond;
+    struct flow_graph_block * then_next;
+    struct flow_graph_block * else_next;
+};
+
+// NULL в качестве значения означает возврат без значения
+struct flow_graph_block_terminator_return {
+
+    struct flow_graph_expr * value;
+};
+
+struct flow_graph_block_terminator {
+
+    // вершина, которой заканчивается блок
+    struct flow_graph_node * node;
+    enum flow_graph_block_terminator_type _type;
+
+    union {
+        struct flow_graph_block_terminator_jump jump;
+        struct flow_graph_block_terminator_cond cond;
+        struct flow_graph_block_terminator_return _return;
+    };
+};
+
+// линейный участок: вершины-выражения, которые выполняются подряд, и переход в конце;
+// вершинами блок не владеет, они принадлежат подпрограмме
+struct flow_graph_block {
+
+    size_t index;
+    struct position position;
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_node ** nodes;
+
+    struct flow_graph_block_terminator terminator;
+};
+
+struct flow_graph_block_list {
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_block ** values;
+};
+
+struct flow_graph_block * flow_graph_block_new(size_t index, struct position position);
+void flow_graph_block_append(struct flow_graph_block * block, struct flow_graph_node * node);
+void flow_graph_block_delete(struct flow_graph_block * block);
+
+struct flow_graph_block_list flow_graph_block_list_init(void);
+void flow_graph_block_list_append(struct flow_graph_block_list * list, struct flow_graph_block * value);
+void flow_graph_block_list_fini(struct flow_graph_block_list * list);
+
+// вершины должны быть пронумерованы по порядку, начиная с 1, и идти в списке в порядке номеров
+struct flow_graph_block_list flow_graph_block_list_build(const struct flow_graph_node_list * nodes);
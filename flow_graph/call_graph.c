@@ -0,0 +1,208 @@
+#include "call_graph.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+static int compare_positions(const void * lhs, const void * rhs) {
+    const struct flow_graph_call_graph_position * const lhs_entry = lhs;
+    const struct flow_graph_call_graph_position * const rhs_entry = rhs;
+
+    return lhs_entry->subroutine < rhs_entry->subroutine ? -1 : lhs_entry->subroutine > rhs_entry->subroutine;
+}
+
+static void build_edges(struct flow_graph_call_graph * graph, const struct flow_graph_subroutine_list * subroutines) {
+    struct stack stack = stack_init();
+    size_t capacity = 0;
+    size_t size = 0;
+
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        const struct flow_graph_subroutine * const subroutine = subroutines->values[i];
+        graph->offsets[i] = size;
+
+        if (!subroutine->defined) {
+            continue;
+        }
+
+        for (size_t j = 0; j < subroutine->nodes.size; ++j) {
+            struct flow_graph_expr * const root = flow_graph_node_get_expr(subroutine->nodes.values[j]);
+
+            if (root) {
+                stack_push(&stack, root);
+            }
+        }
+
+        while (stack.size > 0) {
+            struct flow_graph_expr * const expr = stack_pop(&stack);
+            flow_graph_expr_push_children(&stack, expr);
+
+            if (expr->_type != FLOW_GRAPH_EXPR_TYPE_CALL || !expr->call.subroutine->defined) {
+                continue;
+            }
+
+            if (size >= capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                graph->values = reallocs(graph->values, sizeof(size_t) * capacity);
+            }
+
+            graph->values[size++] = flow_graph_call_graph_get_position(graph, expr->call.subroutine);
+        }
+    }
+
+    graph->offsets[subroutines->size] = size;
+    stack_fini(&stack);
+}
+
+static void find_components(struct flow_graph_call_graph * graph) {
+    const size_t size = graph->size;
+
+    // номер посещения + 1, 0 — не посещена
+    size_t * const indexes = mallocs(sizeof(size_t) * (size ? size : 1));
+    size_t * const lowlinks = mallocs(sizeof(size_t) * (size ? size : 1));
+    bool * const on_stack = mallocs(sizeof(bool) * (size ? size : 1));
+
+    // стек компонент и стек обхода: вершина и следующая её дуга
+    size_t * const components = mallocs(sizeof(size_t) * (size ? size : 1));
+    size_t * const path = mallocs(sizeof(size_t) * (size ? size : 1));
+    size_t * const edges = mallocs(sizeof(size_t) * (size ? size : 1));
+
+    memset(indexes, 0, sizeof(size_t) * size);
+    memset(on_stack, 0, sizeof(bool) * size);
+    memset(graph->recursive, 0, sizeof(bool) * size);
+
+    size_t components_size = 0;
+    size_t components_count = 0;
+    size_t order_size = 0;
+    size_t counter = 0;
+
+    for (size_t root = 0; root < size; ++root) {
+        if (indexes[root]) {
+            continue;
+        }
+
+        size_t path_size = 0;
+
+        indexes[root] = lowlinks[root] = ++counter;
+        on_stack[root] = true;
+        components[components_size++] = root;
+        path[path_size] = root;
+        edges[path_size++] = graph->offsets[root];
+
+        while (path_size > 0) {
+            const size_t v = path[path_size - 1];
+
+            if (edges[path_size - 1] < graph->offsets[v + 1]) {
+                const size_t w = graph->values[edges[path_size - 1]++];
+
+                if (w == v) {
+                    graph->recursive[v] = true;
+                }
+
+                if (!indexes[w]) {
+                    indexes[w] = lowlinks[w] = ++counter;
+                    on_stack[w] = true;
+                    components[components_size++] = w;
+                    path[path_size] = w;
+                    edges[path_size++] = graph->offsets[w];
+                } else if (on_stack[w] && indexes[w] < lowlinks[v]) {
+                    lowlinks[v] = indexes[w];
+                }
+
+                continue;
+            }
+
+            --path_size;
+
+            if (path_size > 0 && lowlinks[v] < lowlinks[path[path_size - 1]]) {
+                lowlinks[path[path_size - 1]] = lowlinks[v];
+            }
+
+            if (lowlinks[v] != indexes[v]) {
+                continue;
+            }
+
+            const size_t first = order_size;
+            size_t w;
+
+            do {
+                w = components[--components_size];
+                on_stack[w] = false;
+                graph->component_of[w] = components_count;
+                graph->order[order_size++] = w;
+            } while (w != v);
+
+            ++components_count;
+
+            if (order_size - first > 1) {
+                for (size_t i = first; i < order_size; ++i) {
+                    graph->recursive[graph->order[i]] = true;
+                }
+            }
+        }
+    }
+
+    free(edges);
+    free(path);
+    free(components);
+    free(on_stack);
+    free(lowlinks);
+    free(indexes);
+}
+
+struct flow_graph_call_graph flow_graph_call_graph_build(const struct flow_graph_subroutine_list * subroutines) {
+    const size_t size = subroutines->size;
+
+    struct flow_graph_call_graph result = {
+        .size = size,
+        .positions = mallocs(sizeof(struct flow_graph_call_graph_position) * (size ? size : 1)),
+        .offsets = mallocs(sizeof(size_t) * (size + 1)),
+        .values = NULL,
+        .order = mallocs(sizeof(size_t) * (size ? size : 1)),
+        .component_of = mallocs(sizeof(size_t) * (size ? size : 1)),
+        .recursive = mallocs(sizeof(bool) * (size ? size : 1)),
+    };
+
+    for (size_t i = 0; i < size; ++i) {
+        result.positions[i] = (struct flow_graph_call_graph_position) {
+            .subroutine = subroutines->values[i],
+            .position = i,
+        };
+    }
+
+    if (size > 0) {
+        qsort(result.positions, size, sizeof(struct flow_graph_call_graph_position), compare_positions);
+    }
+
+    build_edges(&result, subroutines);
+    find_components(&result);
+
+    return result;
+}
+
+void flow_graph_call_graph_fini(struct flow_graph_call_graph * graph) {
+    free(graph->recursive);
+    free(graph->component_of);
+    free(graph->order);
+    free(graph->values);
+    free(graph->offsets);
+    free(graph->positions);
+}
+
+size_t flow_graph_call_graph_get_position(
+        const struct flow_graph_call_graph * graph,
+        const struct flow_graph_subroutine * subroutine
+) {
+    const struct flow_graph_call_graph_position key = { .subroutine = subroutine };
+    const struct flow_graph_call_graph_position * const entry = bsearch(
+            &key,
+            graph->positions,
+            graph->size,
+            sizeof(struct flow_graph_call_graph_position),
+            compare_positions
+    );
+
+    return entry->position;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "subroutine.h"
+
+
+// подпрограмма и её место в списке, отсортированы по адресу подпрограммы для поиска
+struct flow_graph_call_graph_position {
+
+    const struct flow_graph_subroutine * subroutine;
+    size_t position;
+};
+
+// граф вызовов в виде списков смежности по местам подпрограмм в списке: вызовы из подпрограммы v
+// лежат в values с offsets[v] по offsets[v + 1] не включительно, по дуге на каждый вызов; дуги ведут
+// только в определённые подпрограммы, встроенные ничего не вызывают
+//
+// компоненты сильной связности ищутся по Тарьяну без рекурсии: order — подпрограммы в порядке
+// завершения компонент, то есть вызываемые раньше вызывающих, component_of[v] — номер компоненты v
+// в том же порядке, recursive[v] — v входит в цикл графа вызовов, хотя бы из одной себя
+struct flow_graph_call_graph {
+
+    size_t size;
+    struct flow_graph_call_graph_position * positions;
+
+    size_t * offsets;
+    size_t * values;
+
+    size_t * order;
+    size_t * component_of;
+    bool * recursive;
+};
+
+struct flow_graph_call_graph flow_graph_call_graph_build(const struct flow_graph_subroutine_list * subroutines);
+void flow_graph_call_graph_fini(struct flow_graph_call_graph * graph);
+
+// место подпрограммы в списке, по которому граф был построен
+size_t flow_graph_call_graph_get_position(
+        const struct flow_graph_call_graph * graph,
+        const struct flow_graph_subroutine * subroutine
+);
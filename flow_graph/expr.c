@@ -1,6 +1,8 @@
 #include "expr.h"
 
+#include "flow_graph/local.h"
 #include "utils/mallocs.h"
+#include "utils/stack.h"
 
 
 struct flow_graph_expr * flow_graph_expr_new_binary(
@@ -101,6 +103,21 @@ struct flow_graph_expr * flow_graph_expr_new_literal(struct position position, s
     return result;
 }
 
+struct flow_graph_expr * flow_graph_expr_new_typed_local(struct position position, struct flow_graph_local * local) {
+    struct flow_graph_expr * const result = flow_graph_expr_new_local(position, local);
+
+    result->type = ast_type_reference_clone(local->type);
+    return result;
+}
+
+struct flow_graph_expr * flow_graph_expr_new_typed_int(struct position position, struct ast_type_reference * type, uint64_t value) {
+    struct flow_graph_expr * const result =
+            flow_graph_expr_new_literal(position, flow_graph_literal_new_int(position, value));
+
+    result->type = type;
+    return result;
+}
+
 void flow_graph_expr_delete(struct flow_graph_expr * expr) {
     if (!expr) {
         return;
@@ -138,6 +155,379 @@ void flow_graph_expr_delete(struct flow_graph_expr * expr) {
     free(expr);
 }
 
+void flow_graph_expr_push_children(struct stack * stack, struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            stack_push(stack, expr->binary.lhs);
+            stack_push(stack, expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            stack_push(stack, expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            for (size_t i = 0; i < expr->call.args.size; ++i) {
+                stack_push(stack, expr->call.args.values[i]);
+            }
+
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            stack_push(stack, expr->indexer.value);
+
+            for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                stack_push(stack, expr->indexer.indices.values[i]);
+            }
+
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            break;
+    }
+}
+
+static void clone_list(struct flow_graph_expr_list * result, const struct flow_graph_expr_list * list) {
+    for (size_t i = 0; i < list->size; ++i) {
+        flow_graph_expr_list_append(result, flow_graph_expr_clone(list->values[i]));
+    }
+}
+
+struct flow_graph_expr * flow_graph_expr_clone(const struct flow_graph_expr * expr) {
+    if (!expr) {
+        return NULL;
+    }
+
+    struct flow_graph_expr * const result = mallocs(sizeof(struct flow_graph_expr));
+    *result = *expr;
+
+    result->type = ast_type_reference_clone(expr->type);
+
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            result->binary.lhs = flow_graph_expr_clone(expr->binary.lhs);
+            result->binary.rhs = flow_graph_expr_clone(expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            result->unary.value = flow_graph_expr_clone(expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            result->call.args = flow_graph_expr_list_init();
+            clone_list(&result->call.args, &expr->call.args);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            result->indexer.value = flow_graph_expr_clone(expr->indexer.value);
+            result->indexer.indices = flow_graph_expr_list_init();
+            clone_list(&result->indexer.indices, &expr->indexer.indices);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            result->literal.literal = flow_graph_literal_clone(expr->literal.literal);
+            break;
+    }
+
+    return result;
+}
+
+static void push_pair(struct stack * stack, const struct flow_graph_expr * lhs, const struct flow_graph_expr * rhs) {
+    stack_push(stack, (void *) rhs);
+    stack_push(stack, (void *) lhs);
+}
+
+static void push_list_pairs(
+        struct stack * stack,
+        const struct flow_graph_expr_list * lhs,
+        const struct flow_graph_expr_list * rhs
+) {
+    for (size_t i = 0; i < lhs->size; ++i) {
+        push_pair(stack, lhs->values[i], rhs->values[i]);
+    }
+}
+
+// сравнение узлов без операндов, операнды кладутся в стек парами
+static bool equals_shallow(const struct flow_graph_expr * lhs, const struct flow_graph_expr * rhs, struct stack * stack) {
+    if (!lhs || !rhs) {
+        return lhs == rhs;
+    }
+
+    if (lhs->_type != rhs->_type || !ast_type_reference_equals(lhs->type, rhs->type)) {
+        return false;
+    }
+
+    switch (lhs->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            if (lhs->binary.op != rhs->binary.op) {
+                return false;
+            }
+
+            push_pair(stack, lhs->binary.lhs, rhs->binary.lhs);
+            push_pair(stack, lhs->binary.rhs, rhs->binary.rhs);
+            return true;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            if (lhs->unary.op != rhs->unary.op) {
+                return false;
+            }
+
+            push_pair(stack, lhs->unary.value, rhs->unary.value);
+            return true;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            if (lhs->call.subroutine != rhs->call.subroutine || lhs->call.args.size != rhs->call.args.size) {
+                return false;
+            }
+
+            push_list_pairs(stack, &lhs->call.args, &rhs->call.args);
+            return true;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            if (lhs->indexer.indices.size != rhs->indexer.indices.size) {
+                return false;
+            }
+
+            push_pair(stack, lhs->indexer.value, rhs->indexer.value);
+            push_list_pairs(stack, &lhs->indexer.indices, &rhs->indexer.indices);
+            return true;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            return lhs->local.local == rhs->local.local;
+
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            return flow_graph_literal_equals(lhs->literal.literal, rhs->literal.literal);
+    }
+
+    return false;
+}
+
+bool flow_graph_expr_equals(const struct flow_graph_expr * lhs, const struct flow_graph_expr * rhs) {
+    struct stack stack = stack_init();
+    bool result = true;
+
+    push_pair(&stack, lhs, rhs);
+
+    while (result && stack.size > 0) {
+        const struct flow_graph_expr * const lhs_expr = stack_pop(&stack);
+        const struct flow_graph_expr * const rhs_expr = stack_pop(&stack);
+
+        result = equals_shallow(lhs_expr, rhs_expr, &stack);
+    }
+
+    stack_fini(&stack);
+    return result;
+}
+
+static void push_list(struct stack * stack, const struct flow_graph_expr_list * list) {
+    for (size_t i = 0; i < list->size; ++i) {
+        stack_push(stack, list->values[i]);
+    }
+}
+
+size_t flow_graph_expr_hash(const struct flow_graph_expr * expr) {
+    struct stack stack = stack_init();
+    size_t result = 0;
+
+    stack_push(&stack, (void *) expr);
+
+    // типы в хеш не входят: равные по хешу выражения всё равно сравниваются целиком
+    while (stack.size > 0) {
+        const struct flow_graph_expr * const value = stack_pop(&stack);
+
+        if (!value) {
+            result = result * 31 + 1;
+            continue;
+        }
+
+        result = result * 31 + value->_type + 2;
+
+        switch (value->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                result = result * 31 + value->binary.op;
+                stack_push(&stack, value->binary.rhs);
+                stack_push(&stack, value->binary.lhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                result = result * 31 + value->unary.op;
+                stack_push(&stack, value->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                result = result * 31 + value->call.args.size;
+                push_list(&stack, &value->call.args);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                result = result * 31 + value->indexer.indices.size;
+                push_list(&stack, &value->indexer.indices);
+                stack_push(&stack, value->indexer.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+                result = result * 31 + value->local.local->index;
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                result = result * 31 + flow_graph_literal_hash(value->literal.literal);
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    return result;
+}
+
+bool flow_graph_expr_is_pure(const struct flow_graph_expr * expr) {
+    struct stack stack = stack_init();
+    bool result = true;
+
+    stack_push(&stack, (void *) expr);
+
+    while (result && stack.size > 0) {
+        const struct flow_graph_expr * const value = stack_pop(&stack);
+
+        if (!value) {
+            continue;
+        }
+
+        switch (value->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                if (value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    result = false;
+                    break;
+                }
+
+                stack_push(&stack, value->binary.rhs);
+                stack_push(&stack, value->binary.lhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(&stack, value->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                result = false;
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                push_list(&stack, &value->indexer.indices);
+                stack_push(&stack, value->indexer.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    return result;
+}
+
+struct access {
+
+    struct flow_graph_expr * expr;
+    // запись в переменную после вычисления правой части присваивания
+    bool write;
+};
+
+struct access_stack {
+
+    size_t size;
+    size_t capacity;
+    struct access * values;
+};
+
+static void access_push(struct access_stack * stack, struct flow_graph_expr * expr, bool write) {
+    if (!expr) {
+        return;
+    }
+
+    if (stack->size >= stack->capacity) {
+        stack->capacity = stack->capacity ? stack->capacity * 2 : 16;
+        stack->values = reallocs(stack->values, sizeof(struct access) * stack->capacity);
+    }
+
+    stack->values[stack->size++] = (struct access) { .expr = expr, .write = write };
+}
+
+static void access_push_list(struct access_stack * stack, const struct flow_graph_expr_list * list) {
+    for (size_t i = list->size; i > 0; --i) {
+        access_push(stack, list->values[i - 1], false);
+    }
+}
+
+void flow_graph_expr_visit_locals(
+        struct flow_graph_expr * expr,
+        void (* visit)(struct flow_graph_expr * local, bool write, void * context),
+        void * context
+) {
+    struct access_stack stack = { 0 };
+
+    // в стек кладётся в обратном порядке то, что вычисляется в прямом, как в кодогенерации:
+    // операнды слева направо, у присваивания сначала адрес, потом правая часть, потом запись
+    access_push(&stack, expr, false);
+
+    while (stack.size > 0) {
+        const struct access access = stack.values[--stack.size];
+        struct flow_graph_expr * const value = access.expr;
+
+        if (access.write) {
+            visit(value, true, context);
+            continue;
+        }
+
+        switch (value->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                if (value->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    struct flow_graph_expr * const lhs = value->binary.lhs;
+
+                    if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+                        access_push(&stack, lhs, true);
+                        access_push(&stack, value->binary.rhs, false);
+                    } else {
+                        access_push(&stack, value->binary.rhs, false);
+                        access_push(&stack, lhs, false);
+                    }
+
+                    break;
+                }
+
+                access_push(&stack, value->binary.rhs, false);
+                access_push(&stack, value->binary.lhs, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                access_push(&stack, value->unary.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                access_push_list(&stack, &value->call.args);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                access_push_list(&stack, &value->indexer.indices);
+                access_push(&stack, value->indexer.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+                visit(value, false, context);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    free(stack.values);
+}
+
 struct flow_graph_expr_list flow_graph_expr_list_init(void) {
     return (struct flow_graph_expr_list) {
         .size = 0,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "ast.h"
@@ -48,6 +49,7 @@ enum flow_graph_expr_unary_op {
 };
 
 struct flow_graph_expr;
+struct stack;
 
 struct flow_graph_expr_list {
 
@@ -123,7 +125,31 @@ struct flow_graph_expr * flow_graph_expr_new_call(struct position position, stru
 struct flow_graph_expr * flow_graph_expr_new_indexer(struct position position, struct flow_graph_expr * value);
 struct flow_graph_expr * flow_graph_expr_new_local(struct position position, struct flow_graph_local * local);
 struct flow_graph_expr * flow_graph_expr_new_literal(struct position position, struct flow_graph_literal * literal);
+// выражения, которые строят оптимизации, получают тип сразу: чтение переменной — её тип,
+// целый литерал — type, который переходит во владение выражения
+struct flow_graph_expr * flow_graph_expr_new_typed_local(struct position position, struct flow_graph_local * local);
+struct flow_graph_expr * flow_graph_expr_new_typed_int(struct position position, struct ast_type_reference * type, uint64_t value);
 void flow_graph_expr_delete(struct flow_graph_expr * expr);
+// глубокая копия вместе с типами и литералами; переменные и подпрограммы вызовов общие
+struct flow_graph_expr * flow_graph_expr_clone(const struct flow_graph_expr * expr);
+
+// структурное равенство без учёта позиций: совпадают виды, операции, переменные, литералы и типы
+bool flow_graph_expr_equals(const struct flow_graph_expr * lhs, const struct flow_graph_expr * rhs);
+// согласован с flow_graph_expr_equals: равные выражения имеют равные хеши
+size_t flow_graph_expr_hash(const struct flow_graph_expr * expr);
+// выражение без побочных эффектов: не содержит вызовов и присваиваний
+bool flow_graph_expr_is_pure(const struct flow_graph_expr * expr);
+
+// кладёт на стек непосредственные подвыражения, для обходов всего дерева без рекурсии
+void flow_graph_expr_push_children(struct stack * stack, struct flow_graph_expr * expr);
+
+// обход обращений к локальным переменным в порядке вычисления, как в кодогенерации; write истинно
+// для переменной в левой части присваивания, она посещается после вычисления правой части
+void flow_graph_expr_visit_locals(
+        struct flow_graph_expr * expr,
+        void (* visit)(struct flow_graph_expr * local, bool write, void * context),
+        void * context
+);
 
 struct flow_graph_expr_list flow_graph_expr_list_init(void);
 void flow_graph_expr_list_append(struct flow_graph_expr_list * list, struct flow_graph_expr * value);
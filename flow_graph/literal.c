@@ -1,6 +1,9 @@
 #include "literal.h"
 
+#include <string.h>
+
 #include "utils/mallocs.h"
+#include "utils/unreachable.h"
 
 
 struct flow_graph_literal * flow_graph_literal_new_bool(struct position position, bool value) {
@@ -61,3 +64,78 @@ void flow_graph_literal_delete(struct flow_graph_literal * value) {
 
     free(value);
 }
+
+struct flow_graph_literal * flow_graph_literal_clone(const struct flow_graph_literal * value) {
+    if (!value) {
+        return NULL;
+    }
+
+    struct flow_graph_literal * const result = mallocs(sizeof(struct flow_graph_literal));
+    *result = *value;
+
+    if (value->_type == FLOW_GRAPH_LITERAL_TYPE_STR) {
+        const size_t size = strlen(value->str.value) + 1;
+
+        result->str.value = mallocs(size);
+        memcpy(result->str.value, value->str.value, size);
+    }
+
+    return result;
+}
+
+bool flow_graph_literal_equals(const struct flow_graph_literal * lhs, const struct flow_graph_literal * rhs) {
+    if (!lhs || !rhs) {
+        return lhs == rhs;
+    }
+
+    if (lhs->_type != rhs->_type) {
+        return false;
+    }
+
+    switch (lhs->_type) {
+        case FLOW_GRAPH_LITERAL_TYPE_BOOL:
+            return lhs->_bool.value == rhs->_bool.value;
+
+        case FLOW_GRAPH_LITERAL_TYPE_STR:
+            return strcmp(lhs->str.value, rhs->str.value) == 0;
+
+        case FLOW_GRAPH_LITERAL_TYPE_CHAR:
+            return lhs->_char.value == rhs->_char.value;
+
+        case FLOW_GRAPH_LITERAL_TYPE_INT:
+            return lhs->_int.value == rhs->_int.value;
+    }
+
+    unreachable();
+}
+
+size_t flow_graph_literal_hash(const struct flow_graph_literal * value) {
+    if (!value) {
+        return 0;
+    }
+
+    size_t result = value->_type;
+
+    switch (value->_type) {
+        case FLOW_GRAPH_LITERAL_TYPE_BOOL:
+            result = result * 31 + value->_bool.value;
+            break;
+
+        case FLOW_GRAPH_LITERAL_TYPE_STR:
+            for (const char * c = value->str.value; *c; ++c) {
+                result = result * 31 + (unsigned char) *c;
+            }
+
+            break;
+
+        case FLOW_GRAPH_LITERAL_TYPE_CHAR:
+            result = result * 31 + (unsigned char) value->_char.value;
+            break;
+
+        case FLOW_GRAPH_LITERAL_TYPE_INT:
+            result = result * 31 + (size_t) value->_int.value;
+            break;
+    }
+
+    return result;
+}
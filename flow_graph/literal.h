@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "utils/position.h"
@@ -52,3 +53,8 @@ struct flow_graph_literal * flow_graph_literal_new_str(struct position position,
 struct flow_graph_literal * flow_graph_literal_new_char(struct position position, char value);
 struct flow_graph_literal * flow_graph_literal_new_int(struct position position, uint64_t value);
 void flow_graph_literal_delete(struct flow_graph_literal * value);
+struct flow_graph_literal * flow_graph_literal_clone(const struct flow_graph_literal * value);
+
+// сравнение значений без учёта позиций
+bool flow_graph_literal_equals(const struct flow_graph_literal * lhs, const struct flow_graph_literal * rhs);
+size_t flow_graph_literal_hash(const struct flow_graph_literal * value);
@@ -12,6 +12,8 @@ struct flow_graph_local * flow_graph_local_new(char * id, struct ast_type_refere
     result->index = 0;
     result->position = position;
 
+    result->origin = NULL;
+
     return result;
 }
 
@@ -11,6 +11,9 @@ struct flow_graph_local {
 
     size_t index;
     struct position position;
+
+    // исходная переменная для версии SSA-формы, NULL для переменных самой подпрограммы
+    struct flow_graph_local * origin;
 };
 
 struct flow_graph_local_list {
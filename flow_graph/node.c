@@ -11,6 +11,7 @@ struct flow_graph_node * flow_graph_node_new_expr(struct position position, stru
     result->index = 0;
     result->position = position;
     result->_type = FLOW_GRAPH_NODE_TYPE_EXPR;
+    result->phis = flow_graph_phi_list_init();
     result->expr.expr = expr;
     result->expr.next = NULL;
 
@@ -23,6 +24,7 @@ struct flow_graph_node * flow_graph_node_new_cond(struct position position, stru
     result->index = 0;
     result->position = position;
     result->_type = FLOW_GRAPH_NODE_TYPE_COND;
+    result->phis = flow_graph_phi_list_init();
     result->cond.cond = cond;
     result->cond.then_next = NULL;
     result->cond.else_next = NULL;
@@ -45,9 +47,60 @@ void flow_graph_node_delete(struct flow_graph_node * node) {
             break;
     }
 
+    flow_graph_phi_list_fini(&node->phis);
     free(node);
 }
 
+struct flow_graph_expr * flow_graph_node_get_expr(const struct flow_graph_node * node) {
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            return node->expr.expr;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            return node->cond.cond;
+    }
+
+    return NULL;
+}
+
+size_t flow_graph_node_get_successors(const struct flow_graph_node * node, struct flow_graph_node ** successors) {
+    size_t size = 0;
+
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            if (node->expr.next) {
+                successors[size++] = node->expr.next;
+            }
+
+            break;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            if (node->cond.then_next) {
+                successors[size++] = node->cond.then_next;
+            }
+
+            if (node->cond.else_next) {
+                successors[size++] = node->cond.else_next;
+            }
+
+            break;
+    }
+
+    return size;
+}
+
+bool flow_graph_node_is_exit(const struct flow_graph_node * node) {
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            return !node->expr.next;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            return !node->cond.then_next || !node->cond.else_next;
+    }
+
+    return false;
+}
+
 struct flow_graph_node_list flow_graph_node_list_init(void) {
     return (struct flow_graph_node_list) {
         .size = 0,
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "expr.h"
+#include "phi.h"
 #include "utils/position.h"
 
 
@@ -25,12 +27,17 @@ struct flow_graph_node_cond {
     struct flow_graph_node * else_next;
 };
 
+#define FLOW_GRAPH_NODE_SUCCESSORS_MAX 2
+
 struct flow_graph_node {
 
     size_t index;
     struct position position;
     enum flow_graph_node_type _type;
 
+    // непусты только в SSA-форме, см. flow_graph_optimize/ssa.h
+    struct flow_graph_phi_list phis;
+
     union {
         struct flow_graph_node_expr expr;
         struct flow_graph_node_cond cond;
@@ -48,6 +55,14 @@ struct flow_graph_node * flow_graph_node_new_expr(struct position position, stru
 struct flow_graph_node * flow_graph_node_new_cond(struct position position, struct flow_graph_expr * cond);
 void flow_graph_node_delete(struct flow_graph_node * node);
 
+// выражение вершины: вычисляемое выражение для EXPR, условие для COND; NULL для пустой вершины
+struct flow_graph_expr * flow_graph_node_get_expr(const struct flow_graph_node * node);
+
+// переходы в другие вершины в порядке then, else; NULL-переходы ведут на выход и не входят в результат
+size_t flow_graph_node_get_successors(const struct flow_graph_node * node, struct flow_graph_node ** successors);
+// есть ли у вершины переход на выход из подпрограммы
+bool flow_graph_node_is_exit(const struct flow_graph_node * node);
+
 struct flow_graph_node_list flow_graph_node_list_init(void);
 void flow_graph_node_list_append(struct flow_graph_node_list * list, struct flow_graph_node * value);
 void flow_graph_node_list_fini(struct flow_graph_node_list * list);
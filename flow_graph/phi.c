@@ -0,0 +1,75 @@
+#include "phi.h"
+
+#include "utils/mallocs.h"
+
+
+struct flow_graph_phi * flow_graph_phi_new(struct flow_graph_local * target) {
+    struct flow_graph_phi * const result = mallocs(sizeof(struct flow_graph_phi));
+
+    result->target = target;
+
+    result->size = 0;
+    result->capacity = 2;
+    result->args = mallocs(sizeof(struct flow_graph_phi_arg) * 2);
+
+    return result;
+}
+
+void flow_graph_phi_append(struct flow_graph_phi * phi, struct flow_graph_node * predecessor, struct flow_graph_local * value) {
+    if (phi->size >= phi->capacity) {
+        const size_t new_capacity = phi->capacity * 2;
+        struct flow_graph_phi_arg * const new_args =
+                reallocs(phi->args, sizeof(struct flow_graph_phi_arg) * new_capacity);
+
+        phi->args = new_args;
+        phi->capacity = new_capacity;
+    }
+
+    phi->args[phi->size] = (struct flow_graph_phi_arg) {
+        .predecessor = predecessor,
+        .value = value,
+    };
+
+    ++phi->size;
+}
+
+void flow_graph_phi_delete(struct flow_graph_phi * phi) {
+    if (!phi) {
+        return;
+    }
+
+    free(phi->args);
+    free(phi);
+}
+
+// у большинства вершин фи-функций нет, поэтому память выделяется при первом добавлении
+struct flow_graph_phi_list flow_graph_phi_list_init(void) {
+    return (struct flow_graph_phi_list) {
+        .size = 0,
+        .capacity = 0,
+        .values = NULL,
+    };
+}
+
+void flow_graph_phi_list_append(struct flow_graph_phi_list * list, struct flow_graph_phi * value) {
+    if (list->size >= list->capacity) {
+        const size_t new_capacity = list->capacity ? list->capacity * 2 : 1;
+        struct flow_graph_phi ** const new_values =
+                reallocs(list->values, sizeof(struct flow_graph_phi *) * new_capacity);
+
+        list->values = new_values;
+        list->capacity = new_capacity;
+    }
+
+    list->values[list->size] = value;
+    ++list->size;
+}
+
+void flow_graph_phi_list_fini(struct flow_graph_phi_list * list) {
+    for (size_t i = 0; i < list->size; ++i) {
+        flow_graph_phi_delete(list->values[i]);
+    }
+
+    free(list->values);
+    *list = (struct flow_graph_phi_list) { 0 };
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "local.h"
+
+
+struct flow_graph_node;
+
+// значение, которое фи-функция получает при переходе по дуге из предшественника
+struct flow_graph_phi_arg {
+
+    struct flow_graph_node * predecessor;
+    struct flow_graph_local * value;
+};
+
+// фи-функция в начале вершины SSA-формы: target получает значение аргумента той дуги,
+// по которой пришло управление; все фи-функции вершины выполняются одновременно
+struct flow_graph_phi {
+
+    struct flow_graph_local * target;
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_phi_arg * args;
+};
+
+// фи-функциями список владеет, переменными и вершинами — нет
+struct flow_graph_phi_list {
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_phi ** values;
+};
+
+struct flow_graph_phi * flow_graph_phi_new(struct flow_graph_local * target);
+void flow_graph_phi_append(struct flow_graph_phi * phi, struct flow_graph_node * predecessor, struct flow_graph_local * value);
+void flow_graph_phi_delete(struct flow_graph_phi * phi);
+
+struct flow_graph_phi_list flow_graph_phi_list_init(void);
+void flow_graph_phi_list_append(struct flow_graph_phi_list * list, struct flow_graph_phi * value);
+void flow_graph_phi_list_fini(struct flow_graph_phi_list * list);
@@ -0,0 +1,56 @@
+#include "predecessors.h"
+
+#include <string.h>
+
+#include "utils/mallocs.h"
+
+
+struct flow_graph_predecessors flow_graph_predecessors_build(const struct flow_graph_node_list * nodes) {
+    struct flow_graph_predecessors result = {
+        .offsets = mallocs(sizeof(size_t) * (nodes->size + 1)),
+        .values = NULL,
+    };
+
+    memset(result.offsets, 0, sizeof(size_t) * (nodes->size + 1));
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(nodes->values[i], successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            ++result.offsets[successors[k]->index];
+        }
+    }
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        result.offsets[i + 1] += result.offsets[i];
+    }
+
+    result.values = mallocs(sizeof(struct flow_graph_node *) * (result.offsets[nodes->size] + 1));
+
+    size_t * const filled = mallocs(sizeof(size_t) * (nodes->size ? nodes->size : 1));
+    memcpy(filled, result.offsets, sizeof(size_t) * nodes->size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(nodes->values[i], successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            result.values[filled[successors[k]->index - 1]++] = nodes->values[i];
+        }
+    }
+
+    free(filled);
+    return result;
+}
+
+void flow_graph_predecessors_fini(struct flow_graph_predecessors * predecessors) {
+    free(predecessors->values);
+    free(predecessors->offsets);
+
+    *predecessors = (struct flow_graph_predecessors) { 0 };
+}
+
+size_t flow_graph_predecessors_count(const struct flow_graph_predecessors * predecessors, const struct flow_graph_node * node) {
+    return predecessors->offsets[node->index] - predecessors->offsets[node->index - 1];
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "node.h"
+
+
+// предшественники всех вершин одним массивом: предшественники вершины с номером i лежат
+// в values с offsets[i - 1] по offsets[i] не включительно, в порядке номеров вершин;
+// условие, обе ветки которого ведут в одну вершину, встречается среди её предшественников дважды
+struct flow_graph_predecessors {
+
+    size_t * offsets;
+    struct flow_graph_node ** values;
+};
+
+// вершины должны быть пронумерованы по порядку, см. flow_graph_subroutine_renumber
+struct flow_graph_predecessors flow_graph_predecessors_build(const struct flow_graph_node_list * nodes);
+void flow_graph_predecessors_fini(struct flow_graph_predecessors * predecessors);
+
+// число предшественников вершины
+size_t flow_graph_predecessors_count(const struct flow_graph_predecessors * predecessors, const struct flow_graph_node * node);
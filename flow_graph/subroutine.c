@@ -1,6 +1,10 @@
 #include "subroutine.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #include "utils/mallocs.h"
+#include "utils/stack.h"
 
 
 struct flow_graph_subroutine * flow_graph_subroutine_new(char * id, char * filename, bool defined) {
@@ -15,6 +19,7 @@ struct flow_graph_subroutine * flow_graph_subroutine_new(char * id, char * filen
 
     result->locals = flow_graph_local_list_init();
     result->nodes = flow_graph_node_list_init();
+    result->blocks = flow_graph_block_list_init();
 
     return result;
 }
@@ -30,11 +35,99 @@ void flow_graph_subroutine_delete(struct flow_graph_subroutine * subroutine) {
     ast_type_reference_delete(subroutine->return_type);
 
     flow_graph_local_list_fini(&subroutine->locals);
+    flow_graph_block_list_fini(&subroutine->blocks);
     flow_graph_node_list_fini(&subroutine->nodes);
 
     free(subroutine);
 }
 
+struct flow_graph_local * flow_graph_subroutine_add_local(struct flow_graph_subroutine * subroutine, struct flow_graph_local * local) {
+    flow_graph_local_list_append(&subroutine->locals, local);
+    local->index = subroutine->locals.size;
+    return local;
+}
+
+struct flow_graph_local * flow_graph_subroutine_add_temp(
+        struct flow_graph_subroutine * subroutine,
+        struct ast_type_reference * type,
+        struct position position
+) {
+    char * const id = mallocs(26);
+    sprintf(id, "tmp.%zu", subroutine->locals.size + 1);
+
+    return flow_graph_subroutine_add_local(subroutine, flow_graph_local_new(id, type, position));
+}
+
+// нумерация в порядке обхода в глубину (сначала ветка then), явный стек вместо рекурсии
+static size_t assign_indexes(struct flow_graph_node * first_node) {
+    struct stack stack = stack_init();
+    size_t index = 0;
+
+    stack_push(&stack, first_node);
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&stack);
+
+        if (!node || node->index) {
+            continue;
+        }
+
+        node->index = ++index;
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                stack_push(&stack, node->expr.next);
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                stack_push(&stack, node->cond.else_next);
+                stack_push(&stack, node->cond.then_next);
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    return index;
+}
+
+void flow_graph_subroutine_renumber(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        nodes->values[i]->index = 0;
+    }
+
+    const size_t size = assign_indexes(nodes->values[0]);
+
+    // номера уникальны и идут подряд, поэтому вершины расставляются по ним без сортировки
+
+    struct flow_graph_node ** const values = mallocs(sizeof(struct flow_graph_node *) * nodes->capacity);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const node = nodes->values[i];
+
+        if (node->index) {
+            values[node->index - 1] = node;
+        } else {
+            flow_graph_node_delete(node);
+        }
+    }
+
+    free(nodes->values);
+
+    nodes->values = values;
+    nodes->size = size;
+}
+
+void flow_graph_subroutine_build_blocks(struct flow_graph_subroutine * subroutine) {
+    flow_graph_block_list_fini(&subroutine->blocks);
+    subroutine->blocks = flow_graph_block_list_build(&subroutine->nodes);
+}
+
 struct flow_graph_subroutine_list flow_graph_subroutine_list_init(void) {
     return (struct flow_graph_subroutine_list) {
         .size = 0,
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 
 #include "ast.h"
+#include "block.h"
 #include "local.h"
 #include "node.h"
 
@@ -19,6 +20,9 @@ struct flow_graph_subroutine {
 
     struct flow_graph_local_list locals;
     struct flow_graph_node_list nodes;
+
+    // строятся по вершинам после анализа, см. flow_graph_subroutine_build_blocks
+    struct flow_graph_block_list blocks;
 };
 
 struct flow_graph_subroutine_list {
@@ -31,6 +35,20 @@ struct flow_graph_subroutine_list {
 struct flow_graph_subroutine * flow_graph_subroutine_new(char * id, char * filename, bool defined);
 void flow_graph_subroutine_delete(struct flow_graph_subroutine * subroutine);
 
+// добавляет переменную в конец списка и выдаёт ей следующий номер
+struct flow_graph_local * flow_graph_subroutine_add_local(struct flow_graph_subroutine * subroutine, struct flow_graph_local * local);
+// добавляет временную переменную оптимизаций с именем tmp.N, type переходит во владение переменной;
+// точка в имени не встречается в идентификаторах, поэтому имя не совпадает с переменными программы
+struct flow_graph_local * flow_graph_subroutine_add_temp(
+        struct flow_graph_subroutine * subroutine,
+        struct ast_type_reference * type,
+        struct position position
+);
+
+// нумерует вершины в порядке обхода из первой, упорядочивает по номерам и удаляет недостижимые
+void flow_graph_subroutine_renumber(struct flow_graph_subroutine * subroutine);
+void flow_graph_subroutine_build_blocks(struct flow_graph_subroutine * subroutine);
+
 struct flow_graph_subroutine_list flow_graph_subroutine_list_init(void);
 void flow_graph_subroutine_list_append(struct flow_graph_subroutine_list * list, struct flow_graph_subroutine * value);
 void flow_graph_subroutine_list_fini(struct flow_graph_subroutine_list * list);
@@ -3,7 +3,10 @@
 #include <string.h>
 
 #include "ast_display.h"
+#include "flow_graph_optimize/liveness.h"
+#include "flow_graph_optimize/reaching.h"
 #include "utils/mallocs.h"
+#include "utils/stack.h"
 
 
 static const char * const EXPR_BINARY_OPS[] = {
@@ -283,17 +286,7 @@ static void print_node_index(struct flow_graph_node * node, FILE * output) {
     fprintf(output, "#%zu", node->index);
 }
 
-static void print_nodes(struct flow_graph_node * node, bool * visited, FILE * output) {
-    if (!node || node->index == 0) {
-        return;
-    }
-
-    if (visited[node->index - 1]) {
-        return;
-    }
-
-    visited[node->index - 1] = true;
-
+static void print_node(struct flow_graph_node * node, FILE * output) {
     switch (node->_type) {
         case FLOW_GRAPH_NODE_TYPE_EXPR:
             if (!node->expr.expr) {
@@ -309,8 +302,6 @@ static void print_nodes(struct flow_graph_node * node, bool * visited, FILE * ou
             fprintf(output, "    - next: ");
             print_node_index(node->expr.next, output);
             fprintf(output, "\n");
-
-            print_nodes(node->expr.next, visited, output);
             break;
 
         case FLOW_GRAPH_NODE_TYPE_COND:
@@ -326,13 +317,126 @@ static void print_nodes(struct flow_graph_node * node, bool * visited, FILE * ou
             fprintf(output, "    - else next: ");
             print_node_index(node->cond.else_next, output);
             fprintf(output, "\n");
+            break;
+    }
+}
+
+static void print_nodes(struct flow_graph_node * first_node, bool * visited, FILE * output) {
+    struct stack stack = stack_init();
+    stack_push(&stack, first_node);
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&stack);
+
+        if (!node || node->index == 0 || visited[node->index - 1]) {
+            continue;
+        }
+
+        visited[node->index - 1] = true;
+        print_node(node, output);
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                stack_push(&stack, node->expr.next);
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                stack_push(&stack, node->cond.else_next);
+                stack_push(&stack, node->cond.then_next);
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+}
+
+static void print_block_index(const struct flow_graph_block * block, FILE * output) {
+    if (!block) {
+        fprintf(output, "RETURN");
+        return;
+    }
+
+    fprintf(output, "B%zu", block->index);
+}
+
+static void print_block(const struct flow_graph_block * block, FILE * output) {
+    fprintf(output, "  - B%zu", block->index);
+    print_position_ln(block->position, output);
+
+    for (size_t i = 0; i < block->size; ++i) {
+        const struct flow_graph_node * const node = block->nodes[i];
+
+        fprintf(output, "    - #%zu EXPR", node->index);
+        print_position_ln(node->position, output);
+
+        print_expr(node->expr.expr, "expr", 6, output);
+    }
+
+    const struct flow_graph_block_terminator * const terminator = &block->terminator;
+
+    switch (terminator->_type) {
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_JUMP:
+            fprintf(output, "    - next: ");
+            print_block_index(terminator->jump.next, output);
+            fprintf(output, "\n");
+            break;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_COND:
+            fprintf(output, "    - #%zu COND", terminator->node->index);
+            print_position_ln(terminator->node->position, output);
+
+            print_expr(terminator->cond.cond, "cond", 6, output);
+
+            fprintf(output, "    - then next: ");
+            print_block_index(terminator->cond.then_next, output);
+            fprintf(output, "\n");
+
+            fprintf(output, "    - else next: ");
+            print_block_index(terminator->cond.else_next, output);
+            fprintf(output, "\n");
+            break;
+
+        case FLOW_GRAPH_BLOCK_TERMINATOR_TYPE_RETURN:
+            if (terminator->_return.value) {
+                fprintf(output, "    - #%zu RETURN", terminator->node->index);
+                print_position_ln(terminator->node->position, output);
+
+                print_expr(terminator->_return.value, "value", 6, output);
+            } else {
+                fprintf(output, "    - next: RETURN\n");
+            }
 
-            print_nodes(node->cond.then_next, visited, output);
-            print_nodes(node->cond.else_next, visited, output);
             break;
     }
 }
 
+static void print_phis(const struct flow_graph_node_list * nodes, FILE * output) {
+    bool found = false;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        const struct flow_graph_node * const node = nodes->values[i];
+
+        for (size_t j = 0; j < node->phis.size; ++j) {
+            const struct flow_graph_phi * const phi = node->phis.values[j];
+
+            if (!found) {
+                fprintf(output, "- Phi functions:\n");
+                found = true;
+            }
+
+            fprintf(output, "  - #%zu: #%zu %s = phi(", node->index, phi->target->index, phi->target->id);
+
+            for (size_t k = 0; k < phi->size; ++k) {
+                const struct flow_graph_phi_arg * const arg = &phi->args[k];
+
+                fprintf(output, "%s#%zu %s from #%zu", k > 0 ? ", " : "", arg->value->index, arg->value->id, arg->predecessor->index);
+            }
+
+            fprintf(output, ")\n");
+        }
+    }
+}
+
 void flow_graph_display(const struct flow_graph_subroutine * subroutine, FILE * output) {
     print_subroutine_id(subroutine, output);
 
@@ -348,7 +452,15 @@ void flow_graph_display(const struct flow_graph_subroutine * subroutine, FILE *
         }
     }
 
-    if (subroutine->nodes.size > 0) {
+    if (subroutine->blocks.size > 0) {
+        fprintf(output, "- Flow graph:\n");
+
+        for (size_t i = 0; i < subroutine->blocks.size; ++i) {
+            print_block(subroutine->blocks.values[i], output);
+        }
+    } else if (subroutine->nodes.size > 0) {
+        // блоки не строятся, если анализ завершился с ошибками
+
         bool * const visited = mallocs(sizeof(bool) * subroutine->nodes.size);
         memset(visited, 0, sizeof(bool) * subroutine->nodes.size);
 
@@ -357,4 +469,78 @@ void flow_graph_display(const struct flow_graph_subroutine * subroutine, FILE *
 
         free(visited);
     }
+
+    print_phis(&subroutine->nodes, output);
+}
+
+static void print_live_locals(
+        const char * label,
+        const struct flow_graph_subroutine * subroutine,
+        const struct bitset * live,
+        FILE * output
+) {
+    fprintf(output, "    - %s:", label);
+
+    const char * separator = " ";
+
+    for (size_t i = 0; i < subroutine->locals.size; ++i) {
+        if (bitset_test(live, i)) {
+            const struct flow_graph_local * const local = subroutine->locals.values[i];
+
+            fprintf(output, "%s#%zu %s", separator, local->index, local->id);
+            separator = ", ";
+        }
+    }
+
+    fprintf(output, "\n");
+}
+
+static void print_reaching(const struct flow_graph_reaching * reaching, const struct bitset * definitions, FILE * output) {
+    fprintf(output, "    - reaching:");
+
+    const char * separator = " ";
+
+    for (size_t k = 0; k < reaching->size; ++k) {
+        if (!bitset_test(definitions, k)) {
+            continue;
+        }
+
+        const struct flow_graph_definition * const definition = &reaching->definitions[k];
+
+        fprintf(output, "%s#%zu %s from ", separator, definition->local->index, definition->local->id);
+        separator = ", ";
+
+        if (definition->node) {
+            fprintf(output, "#%zu", definition->node->index);
+        } else {
+            fprintf(output, "arguments");
+        }
+    }
+
+    fprintf(output, "\n");
+}
+
+void flow_graph_display_dataflow(const struct flow_graph_subroutine * subroutine, FILE * output) {
+    if (subroutine->nodes.size == 0) {
+        return;
+    }
+
+    struct flow_graph_dataflow_result liveness = flow_graph_liveness_build(subroutine);
+    struct flow_graph_reaching reaching = flow_graph_reaching_build(subroutine);
+
+    fprintf(output, "- Dataflow:\n");
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        const struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        fprintf(output, "  - #%zu", node->index);
+        print_position_ln(node->position, output);
+
+        print_live_locals("live in", subroutine, &liveness.in[i], output);
+        print_live_locals("live out", subroutine, &liveness.out[i], output);
+        print_reaching(&reaching, &reaching.result.in[i], output);
+    }
+
+    flow_graph_reaching_fini(&reaching);
+    flow_graph_dataflow_result_fini(&liveness);
 }
@@ -6,3 +6,6 @@
 
 
 void flow_graph_display(const struct flow_graph_subroutine * subroutine, FILE * output);
+
+// результаты анализа потока данных для каждой вершины: живые переменные и достигающие определения
+void flow_graph_display_dataflow(const struct flow_graph_subroutine * subroutine, FILE * output);
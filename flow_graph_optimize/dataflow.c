@@ -0,0 +1,182 @@
+#include "dataflow.h"
+
+#include <stdbool.h>
+
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+static void meet(struct bitset * dst, const struct bitset * src, enum flow_graph_dataflow_meet op) {
+    switch (op) {
+        case FLOW_GRAPH_DATAFLOW_MEET_UNION:
+            bitset_union(dst, src);
+            break;
+
+        case FLOW_GRAPH_DATAFLOW_MEET_INTERSECTION:
+            bitset_intersect(dst, src);
+            break;
+    }
+}
+
+static void meet_init(struct bitset * value, enum flow_graph_dataflow_meet op) {
+    switch (op) {
+        case FLOW_GRAPH_DATAFLOW_MEET_UNION:
+            bitset_clear(value);
+            break;
+
+        case FLOW_GRAPH_DATAFLOW_MEET_INTERSECTION:
+            bitset_fill(value);
+            break;
+    }
+}
+
+static void push_node(struct stack * worklist, bool * queued, struct flow_graph_node * node) {
+    if (!queued[node->index - 1]) {
+        queued[node->index - 1] = true;
+        stack_push(worklist, node);
+    }
+}
+
+struct flow_graph_dataflow_result flow_graph_dataflow_solve(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_dataflow_problem * problem
+) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const bool forward = problem->direction == FLOW_GRAPH_DATAFLOW_DIRECTION_FORWARD;
+
+    struct flow_graph_dataflow_result result = {
+        .size = nodes->size,
+        .in = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+        .out = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+    };
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        result.in[i] = bitset_init(problem->bits);
+        result.out[i] = bitset_init(problem->bits);
+
+        meet_init(&result.in[i], problem->meet);
+        meet_init(&result.out[i], problem->meet);
+    }
+
+    if (nodes->size == 0) {
+        return result;
+    }
+
+    // входы и выходы передаточной функции в направлении анализа
+    struct bitset * const inputs = forward ? result.in : result.out;
+    struct bitset * const outputs = forward ? result.out : result.in;
+
+    struct bitset boundary = bitset_init(problem->bits);
+    if (problem->boundary) {
+        bitset_copy(&boundary, problem->boundary);
+    }
+
+    struct bitset output = bitset_init(problem->bits);
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+
+    bool * const queued = mallocs(sizeof(bool) * nodes->size);
+    struct stack worklist = stack_init();
+
+    // вершины снимаются со стека в порядке номеров для прямого анализа и в обратном для обратного
+    for (size_t i = 0; i < nodes->size; ++i) {
+        queued[i] = true;
+        stack_push(&worklist, nodes->values[forward ? nodes->size - i - 1 : i]);
+    }
+
+    while (worklist.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&worklist);
+        const size_t i = node->index - 1;
+
+        queued[i] = false;
+
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        struct bitset * const input = &inputs[i];
+        meet_init(input, problem->meet);
+
+        if (forward) {
+            if (i == 0) {
+                meet(input, &boundary, problem->meet);
+            }
+
+            for (size_t k = predecessors.offsets[i]; k < predecessors.offsets[i + 1]; ++k) {
+                meet(input, &outputs[predecessors.values[k]->index - 1], problem->meet);
+            }
+        } else {
+            if (flow_graph_node_is_exit(node)) {
+                meet(input, &boundary, problem->meet);
+            }
+
+            for (size_t k = 0; k < successors_size; ++k) {
+                meet(input, &outputs[successors[k]->index - 1], problem->meet);
+            }
+        }
+
+        problem->transfer(node, input, &output, problem->context);
+
+        if (bitset_equals(&output, &outputs[i])) {
+            continue;
+        }
+
+        bitset_copy(&outputs[i], &output);
+
+        if (forward) {
+            for (size_t k = 0; k < successors_size; ++k) {
+                push_node(&worklist, queued, successors[k]);
+            }
+        } else {
+            for (size_t k = predecessors.offsets[i]; k < predecessors.offsets[i + 1]; ++k) {
+                push_node(&worklist, queued, predecessors.values[k]);
+            }
+        }
+    }
+
+    stack_fini(&worklist);
+    free(queued);
+
+    flow_graph_predecessors_fini(&predecessors);
+    bitset_fini(&output);
+    bitset_fini(&boundary);
+
+    return result;
+}
+
+void flow_graph_dataflow_result_fini(struct flow_graph_dataflow_result * result) {
+    for (size_t i = 0; i < result->size; ++i) {
+        bitset_fini(&result->in[i]);
+        bitset_fini(&result->out[i]);
+    }
+
+    free(result->in);
+    free(result->out);
+
+    *result = (struct flow_graph_dataflow_result) { 0 };
+}
+
+struct accesses_context {
+
+    struct bitset * uses;
+    struct bitset * defs;
+};
+
+static void visit_access(struct flow_graph_expr * local, bool write, void * context) {
+    const struct accesses_context * const accesses = context;
+    const size_t i = local->local.local->index - 1;
+
+    if (write) {
+        bitset_set(accesses->defs, i);
+    } else if (!bitset_test(accesses->defs, i)) {
+        bitset_set(accesses->uses, i);
+    }
+}
+
+void flow_graph_dataflow_accesses(const struct flow_graph_expr * expr, struct bitset * uses, struct bitset * defs) {
+    struct accesses_context context = {
+        .uses = uses,
+        .defs = defs,
+    };
+
+    flow_graph_expr_visit_locals((struct flow_graph_expr *) expr, visit_access, &context);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "flow_graph.h"
+#include "utils/bitset.h"
+
+
+enum flow_graph_dataflow_direction {
+
+    FLOW_GRAPH_DATAFLOW_DIRECTION_FORWARD = 0,
+    FLOW_GRAPH_DATAFLOW_DIRECTION_BACKWARD,
+};
+
+enum flow_graph_dataflow_meet {
+
+    FLOW_GRAPH_DATAFLOW_MEET_UNION = 0,
+    FLOW_GRAPH_DATAFLOW_MEET_INTERSECTION,
+};
+
+// задача анализа потока данных над вершинами подпрограммы; значения — множества размера bits
+struct flow_graph_dataflow_problem {
+
+    enum flow_graph_dataflow_direction direction;
+    enum flow_graph_dataflow_meet meet;
+    size_t bits;
+
+    // значение на входе в подпрограмму для прямого анализа или на выходе из неё для обратного,
+    // NULL означает пустое множество
+    const struct bitset * boundary;
+
+    // значение после вершины в направлении анализа по значению перед ней
+    void (* transfer)(const struct flow_graph_node * node, const struct bitset * input, struct bitset * output, void * context);
+    void * context;
+};
+
+// значения перед вершиной и после неё в порядке исполнения, по номеру вершины - 1
+struct flow_graph_dataflow_result {
+
+    size_t size;
+    struct bitset * in;
+    struct bitset * out;
+};
+
+// решение итерациями по списку вершин до неподвижной точки;
+// вершины должны быть пронумерованы по порядку, см. flow_graph_subroutine_renumber
+struct flow_graph_dataflow_result flow_graph_dataflow_solve(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_dataflow_problem * problem
+);
+void flow_graph_dataflow_result_fini(struct flow_graph_dataflow_result * result);
+
+// локальные переменные, которые выражение читает до записи в них (uses), и переменные, в которые
+// оно пишет (defs), в порядке вычисления; бит переменной — её номер - 1, множества дополняются
+void flow_graph_dataflow_accesses(const struct flow_graph_expr * expr, struct bitset * uses, struct bitset * defs);
@@ -0,0 +1,684 @@
+#include "passes.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+
+
+// деление или остаток, операнды которого — переменные или литералы
+struct occurrence {
+
+    struct flow_graph_expr * expr;
+    size_t node;
+
+    // номер в порядке вычисления по всей подпрограмме
+    size_t seq;
+
+    // начало цепочки вершин и хеш операндов: пару образуют только вхождения с одинаковыми
+    size_t chain;
+    size_t key;
+
+    // до него в той же вершине уже вернулся вызов
+    bool after_call;
+
+    // уже в паре или точно в неё не войдёт
+    bool fused;
+};
+
+struct occurrences {
+
+    size_t size;
+    size_t capacity;
+    struct occurrence * values;
+};
+
+// чтение или запись переменной с номером local - 1 в момент seq
+struct access {
+
+    size_t local;
+    size_t seq;
+};
+
+struct accesses {
+
+    size_t size;
+    size_t capacity;
+    struct access * values;
+};
+
+// моменты обращений к переменной с номером i лежат в seqs с offsets[i - 1] по offsets[i]
+// не включительно, по возрастанию
+struct access_index {
+
+    size_t * offsets;
+    size_t * seqs;
+};
+
+struct walk_task {
+
+    struct flow_graph_expr * expr;
+    bool done;
+};
+
+struct walk_tasks {
+
+    size_t size;
+    size_t capacity;
+    struct walk_task * values;
+};
+
+struct walk {
+
+    struct occurrences occurrences;
+    struct accesses writes;
+    struct accesses reads;
+    struct walk_tasks tasks;
+
+    // номер первого выражения каждой вершины в порядке вычисления
+    size_t * starts;
+
+    size_t seq;
+    size_t last_call;
+};
+
+static void task_push(struct walk_tasks * tasks, struct flow_graph_expr * expr, bool done) {
+    if (tasks->size >= tasks->capacity) {
+        tasks->capacity = tasks->capacity ? tasks->capacity * 2 : 16;
+        tasks->values = reallocs(tasks->values, sizeof(struct walk_task) * tasks->capacity);
+    }
+
+    tasks->values[tasks->size++] = (struct walk_task) { .expr = expr, .done = done };
+}
+
+static void task_push_list(struct walk_tasks * tasks, const struct flow_graph_expr_list * list) {
+    for (size_t i = list->size; i > 0; --i) {
+        task_push(tasks, list->values[i - 1], false);
+    }
+}
+
+static bool is_simple_operand(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL || expr->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL;
+}
+
+// деление и остаток по степени двойки кодогенерация заменяет сдвигом и маской, их сводить в пару незачем;
+// литерал до 2^14 одинаков во всех своих типах
+static bool is_power_of_two(const struct flow_graph_expr * rhs) {
+    if (rhs->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL || rhs->literal.literal->_type != FLOW_GRAPH_LITERAL_TYPE_INT) {
+        return false;
+    }
+
+    const uint64_t value = rhs->literal.literal->_int.value;
+    return value > 0 && value <= INT16_MAX && (value & (value - 1)) == 0;
+}
+
+static bool is_division(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+           && (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE
+               || expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER)
+           && ast_type_reference_is_numeric(expr->type)
+           && is_simple_operand(expr->binary.lhs)
+           && is_simple_operand(expr->binary.rhs)
+           && !is_power_of_two(expr->binary.rhs);
+}
+
+static void access_push(struct accesses * accesses, const struct flow_graph_local * local, size_t seq) {
+    if (accesses->size >= accesses->capacity) {
+        accesses->capacity = accesses->capacity ? accesses->capacity * 2 : 16;
+        accesses->values = reallocs(accesses->values, sizeof(struct access) * accesses->capacity);
+    }
+
+    accesses->values[accesses->size++] = (struct access) { .local = local->index - 1, .seq = seq };
+}
+
+// левая часть присваивания переменной не обходится, поэтому каждая пройденная переменная — чтение
+static void finish_expr(struct walk * walk, struct flow_graph_expr * expr, size_t node) {
+    const size_t seq = walk->seq++;
+
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_CALL) {
+        walk->last_call = seq;
+        return;
+    }
+
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        access_push(&walk->reads, expr->local.local, seq);
+        return;
+    }
+
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+        && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+        && expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+
+        access_push(&walk->writes, expr->binary.lhs->local.local, seq);
+        return;
+    }
+
+    if (!is_division(expr)) {
+        return;
+    }
+
+    struct occurrences * const occurrences = &walk->occurrences;
+
+    if (occurrences->size >= occurrences->capacity) {
+        occurrences->capacity = occurrences->capacity ? occurrences->capacity * 2 : 16;
+        occurrences->values = reallocs(occurrences->values, sizeof(struct occurrence) * occurrences->capacity);
+    }
+
+    occurrences->values[occurrences->size++] = (struct occurrence) {
+        .expr = expr,
+        .node = node,
+        .seq = seq,
+        .after_call = walk->last_call != SIZE_MAX && walk->last_call >= walk->starts[node],
+        .fused = false,
+    };
+}
+
+// обход в порядке вычисления, как в кодогенерации: операнды слева направо, у присваивания сначала
+// адрес, потом правая часть, потом запись
+static void walk_expr(struct walk * walk, struct flow_graph_expr * root, size_t node) {
+    struct walk_tasks * const tasks = &walk->tasks;
+    task_push(tasks, root, false);
+
+    while (tasks->size > 0) {
+        const struct walk_task task = tasks->values[--tasks->size];
+        struct flow_graph_expr * const expr = task.expr;
+
+        if (task.done) {
+            finish_expr(walk, expr, node);
+            continue;
+        }
+
+        task_push(tasks, expr, true);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+                struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                task_push(tasks, expr->binary.rhs, false);
+
+                if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    task_push(tasks, lhs, false);
+                } else if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+                    task_push_list(tasks, &lhs->indexer.indices);
+                    task_push(tasks, lhs->indexer.value, false);
+                }
+
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                task_push(tasks, expr->unary.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                task_push_list(tasks, &expr->call.args);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                task_push_list(tasks, &expr->indexer.indices);
+                task_push(tasks, expr->indexer.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+}
+
+// обращения идут в порядке вычисления, поэтому у каждой переменной они уже упорядочены
+static struct access_index build_index(const struct accesses * accesses, size_t locals_size) {
+    struct access_index result = {
+        .offsets = mallocs(sizeof(size_t) * (locals_size + 1)),
+        .seqs = mallocs(sizeof(size_t) * (accesses->size ? accesses->size : 1)),
+    };
+
+    memset(result.offsets, 0, sizeof(size_t) * (locals_size + 1));
+
+    for (size_t i = 0; i < accesses->size; ++i) {
+        ++result.offsets[accesses->values[i].local + 1];
+    }
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        result.offsets[i + 1] += result.offsets[i];
+    }
+
+    size_t * const filled = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memcpy(filled, result.offsets, sizeof(size_t) * locals_size);
+
+    for (size_t i = 0; i < accesses->size; ++i) {
+        result.seqs[filled[accesses->values[i].local]++] = accesses->values[i].seq;
+    }
+
+    free(filled);
+    return result;
+}
+
+static void access_index_fini(struct access_index * index) {
+    free(index->seqs);
+    free(index->offsets);
+}
+
+// первое обращение к переменной не раньше seq
+static size_t lower_bound(const struct access_index * index, size_t local, size_t seq) {
+    size_t begin = index->offsets[local];
+    size_t end = index->offsets[local + 1];
+
+    while (begin < end) {
+        const size_t middle = begin + (end - begin) / 2;
+
+        if (index->seqs[middle] < seq) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    return begin;
+}
+
+// число обращений к переменной в моменты с from по to не включительно
+static size_t count_between(const struct access_index * index, const struct flow_graph_local * local, size_t from, size_t to) {
+    return lower_bound(index, local->index - 1, to) - lower_bound(index, local->index - 1, from);
+}
+
+static bool is_written_between(const struct access_index * writes, const struct flow_graph_expr * operand, size_t from, size_t to) {
+    return operand->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && count_between(writes, operand->local.local, from, to) > 0;
+}
+
+// делитель-литерал, отличный от нуля, не останавливает программу; литерал усекается до своего типа,
+// поэтому проверяются только младшие байты, которые остаются у самого узкого из его типов
+static bool is_safe_divisor(const struct flow_graph_expr * rhs) {
+    return rhs->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL
+           && rhs->literal.literal->_type == FLOW_GRAPH_LITERAL_TYPE_INT
+           && (uint16_t) rhs->literal.literal->_int.value != 0;
+}
+
+// пара вычисляется перед вершиной первого вхождения: операнды не должны меняться в вершине до него,
+// а деление на ноль не должно опередить вызов, который мог бы вывести что-то раньше
+static bool can_lead(const struct walk * walk, const struct access_index * writes, const struct occurrence * leader) {
+    const size_t start = walk->starts[leader->node];
+    const struct flow_graph_expr * const expr = leader->expr;
+
+    if (leader->after_call && !is_safe_divisor(expr->binary.rhs)) {
+        return false;
+    }
+
+    return !is_written_between(writes, expr->binary.lhs, start, leader->seq)
+           && !is_written_between(writes, expr->binary.rhs, start, leader->seq);
+}
+
+// значение пары, вычисленной перед вершиной первого вхождения, годится для второго из той же цепочки,
+// если операнды не пишутся от начала первой вершины до второго вхождения; дальше по цепочке они
+// тем более не годятся, поэтому просмотр вхождений на этом останавливается
+static bool can_follow(const struct walk * walk, const struct access_index * writes, const struct occurrence * leader, size_t seq) {
+    const size_t start = walk->starts[leader->node];
+
+    return !is_written_between(writes, leader->expr->binary.lhs, start, seq)
+           && !is_written_between(writes, leader->expr->binary.rhs, start, seq);
+}
+
+static bool is_partner(const struct occurrence * leader, const struct occurrence * other) {
+    return !other->fused
+           && other->key == leader->key
+           && ast_type_reference_equals(leader->expr->type, other->expr->type)
+           && flow_graph_expr_equals(leader->expr->binary.lhs, other->expr->binary.lhs)
+           && flow_graph_expr_equals(leader->expr->binary.rhs, other->expr->binary.rhs);
+}
+
+// temp = lhs op rhs по операндам образца
+static struct flow_graph_expr * new_assignment(
+        const struct flow_graph_expr * sample,
+        enum flow_graph_expr_binary_op op,
+        struct flow_graph_local * temp
+) {
+    struct flow_graph_expr * const value = flow_graph_expr_new_binary(
+            sample->position,
+            op,
+            flow_graph_expr_clone(sample->binary.lhs),
+            flow_graph_expr_clone(sample->binary.rhs)
+    );
+
+    value->type = ast_type_reference_clone(sample->type);
+
+    struct flow_graph_expr * const lhs = flow_graph_expr_new_typed_local(sample->position, temp);
+
+    struct flow_graph_expr * const result =
+            flow_graph_expr_new_binary(sample->position, FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT, lhs, value);
+
+    result->type = ast_type_reference_clone(temp->type);
+    return result;
+}
+
+// вершины с присваиваниями пары встают перед вершиной на её месте: содержимое вершины
+// переезжает в новую, поэтому переходы в неё из предшественников остаются верными
+static void insert_before(
+        struct flow_graph_subroutine * subroutine,
+        struct flow_graph_node * node,
+        struct flow_graph_expr * first_expr,
+        struct flow_graph_expr * second_expr
+) {
+    struct flow_graph_node * const moved = mallocs(sizeof(struct flow_graph_node));
+    *moved = *node;
+
+    struct flow_graph_node * const second = flow_graph_node_new_expr(node->position, second_expr);
+    second->expr.next = moved;
+
+    node->_type = FLOW_GRAPH_NODE_TYPE_EXPR;
+    node->phis = flow_graph_phi_list_init();
+    node->expr.expr = first_expr;
+    node->expr.next = second;
+
+    flow_graph_node_list_append(&subroutine->nodes, second);
+    flow_graph_node_list_append(&subroutine->nodes, moved);
+}
+
+static void use_temp(struct flow_graph_expr * expr, struct flow_graph_local * temp) {
+    flow_graph_expr_delete(expr->binary.lhs);
+    flow_graph_expr_delete(expr->binary.rhs);
+
+    expr->_type = FLOW_GRAPH_EXPR_TYPE_LOCAL;
+    expr->local.local = temp;
+}
+
+// вхождение — вся правая часть присваивания переменной, которым исчерпывается его вершина
+static struct flow_graph_expr * get_statement(const struct flow_graph_node * node, const struct flow_graph_expr * expr) {
+    struct flow_graph_expr * const root = flow_graph_node_get_expr(node);
+
+    if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || !node->expr.next || !root
+        || root->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+        || root->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+        || root->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL
+        || root->binary.rhs != expr) {
+
+        return NULL;
+    }
+
+    return root;
+}
+
+static bool is_operand_local(const struct flow_graph_expr * expr, const struct flow_graph_local * local) {
+    return (expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->binary.lhs->local.local == local)
+           || (expr->binary.rhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->binary.rhs->local.local == local);
+}
+
+// сколько раз переменная читается операндами вхождения
+static size_t count_operand_reads(const struct occurrence * occurrence, const struct flow_graph_local * local) {
+    const struct flow_graph_expr * const expr = occurrence->expr;
+
+    return (expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->binary.lhs->local.local == local)
+           + (expr->binary.rhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->binary.rhs->local.local == local);
+}
+
+// присваивание x = a op b второго вхождения можно перенести в пару перед вершиной первого: они в одной
+// цепочке, а между ними x не пишется и не читается нигде, кроме операндов самих вхождений
+static struct flow_graph_expr * get_movable_statement(
+        const struct walk * walk,
+        const struct access_index * writes,
+        const struct access_index * reads,
+        const struct flow_graph_node_list * nodes,
+        const struct occurrence * leader,
+        const struct occurrence * follower
+) {
+    if (follower->node == leader->node) {
+        return NULL;
+    }
+
+    struct flow_graph_expr * const statement = get_statement(nodes->values[follower->node], follower->expr);
+
+    if (!statement) {
+        return NULL;
+    }
+
+    const struct flow_graph_local * const local = statement->binary.lhs->local.local;
+    const size_t start = walk->starts[leader->node];
+
+    if (count_between(writes, local, start, follower->seq) > 0) {
+        return NULL;
+    }
+
+    // операнды обоих вхождений читаются внутри этого отрезка
+    const size_t operand_reads = count_operand_reads(leader, local) + count_operand_reads(follower, local);
+    return count_between(reads, local, start, follower->seq) == operand_reads ? statement : NULL;
+}
+
+// начало цепочки вершин, в которой лежит каждая вершина: цепочку продолжает единственный преемник
+// вершины-выражения, если в него нет других переходов; вершины цепочки пронумерованы подряд
+static size_t * build_chains(const struct flow_graph_node_list * nodes) {
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    size_t * const result = mallocs(sizeof(size_t) * nodes->size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        const struct flow_graph_node * const node = nodes->values[i];
+        result[i] = i;
+
+        if (i == 0) {
+            continue;
+        }
+
+        const struct flow_graph_node * const previous = nodes->values[i - 1];
+
+        if (previous->_type == FLOW_GRAPH_NODE_TYPE_EXPR
+            && previous->expr.next == node
+            && flow_graph_predecessors_count(&predecessors, node) == 1) {
+
+            result[i] = result[i - 1];
+        }
+    }
+
+    flow_graph_predecessors_fini(&predecessors);
+    return result;
+}
+
+static int compare_occurrences(const void * lhs, const void * rhs) {
+    const struct occurrence * const lhs_occurrence = lhs;
+    const struct occurrence * const rhs_occurrence = rhs;
+
+    if (lhs_occurrence->chain != rhs_occurrence->chain) {
+        return lhs_occurrence->chain < rhs_occurrence->chain ? -1 : 1;
+    }
+
+    if (lhs_occurrence->key != rhs_occurrence->key) {
+        return lhs_occurrence->key < rhs_occurrence->key ? -1 : 1;
+    }
+
+    return lhs_occurrence->seq < rhs_occurrence->seq ? -1 : lhs_occurrence->seq > rhs_occurrence->seq;
+}
+
+// вхождения с begin по end не включительно лежат в одной цепочке, у них одинаковый хеш операндов,
+// и идут они в порядке вычисления, поэтому вершина каждого доминирует над вершинами следующих
+static bool fuse_group(
+        struct flow_graph_subroutine * subroutine,
+        const struct walk * walk,
+        const struct access_index * writes,
+        const struct access_index * reads,
+        struct occurrence * values,
+        size_t begin,
+        size_t end
+) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    bool result = false;
+
+    for (size_t i = begin; i < end; ++i) {
+        struct occurrence * const leader = &values[i];
+
+        if (leader->fused || !can_lead(walk, writes, leader)) {
+            continue;
+        }
+
+        const enum flow_graph_expr_binary_op op = leader->expr->binary.op;
+        bool has_divide = false;
+        bool has_remainder = false;
+        size_t count = 0;
+        size_t last = i;
+
+        struct occurrence * follower = NULL;
+        struct flow_graph_expr * statement = NULL;
+
+        for (size_t j = i; j < end && can_follow(walk, writes, leader, values[j].seq); ++j) {
+            struct occurrence * const other = &values[j];
+            last = j + 1;
+
+            if (!is_partner(leader, other)) {
+                continue;
+            }
+
+            const bool is_divide = other->expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE;
+            has_divide = has_divide || is_divide;
+            has_remainder = has_remainder || !is_divide;
+            ++count;
+
+            if (!statement && other->expr->binary.op != op) {
+                statement = get_movable_statement(walk, writes, reads, nodes, leader, other);
+                follower = other;
+            }
+        }
+
+        // второе вхождение — целое присваивание x = a op b: пара пишет прямо в x, и его вершина пустеет,
+        // так что временная переменная нужна одна — для первого вхождения, а если и оно целое
+        // присваивание переменной, которая не служит операндом, то не нужна вовсе
+        if (statement) {
+            struct flow_graph_node * const node = nodes->values[leader->node];
+            struct flow_graph_expr * const first = get_statement(node, leader->expr);
+            nodes->values[follower->node]->expr.expr = NULL;
+
+            if (first && !is_operand_local(leader->expr, first->binary.lhs->local.local)) {
+                node->expr.expr = NULL;
+                insert_before(subroutine, node, first, statement);
+            } else {
+                struct flow_graph_local * const temp = flow_graph_subroutine_add_temp(
+                        subroutine,
+                        ast_type_reference_clone(leader->expr->type),
+                        leader->expr->position
+                );
+
+                insert_before(subroutine, node, new_assignment(leader->expr, op, temp), statement);
+                use_temp(leader->expr, temp);
+            }
+
+            leader->fused = true;
+            follower->fused = true;
+            result = true;
+            continue;
+        }
+
+        // вхождения одной операции не сольются и с последующими: те видят только часть просмотренных
+        if (!has_divide || !has_remainder) {
+            for (size_t j = i; j < last; ++j) {
+                values[j].fused = values[j].fused || is_partner(leader, &values[j]);
+            }
+
+            continue;
+        }
+
+        // иначе запись двух временных переменных и чтения из них стоят почти столько же, сколько
+        // второе деление, и слияние окупается, только если вхождений хотя бы три, а делитель
+        // не литерал: на литерал кодогенерация делит умножением на обратное
+        if (count < 3 || leader->expr->binary.rhs->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL) {
+            continue;
+        }
+
+        const struct position position = leader->expr->position;
+
+        struct flow_graph_local * const quotient =
+                flow_graph_subroutine_add_temp(subroutine, ast_type_reference_clone(leader->expr->type), position);
+        struct flow_graph_local * const remainder =
+                flow_graph_subroutine_add_temp(subroutine, ast_type_reference_clone(leader->expr->type), position);
+
+        insert_before(
+                subroutine,
+                nodes->values[leader->node],
+                new_assignment(leader->expr, FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE, quotient),
+                new_assignment(leader->expr, FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER, remainder)
+        );
+
+        // сам образец заменяется последним: по нему сравниваются остальные вхождения
+        for (size_t j = last; j > i; --j) {
+            struct occurrence * const other = &values[j - 1];
+
+            if (is_partner(leader, other)) {
+                const bool is_divide = other->expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE;
+                use_temp(other->expr, is_divide ? quotient : remainder);
+                other->fused = true;
+            }
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+bool flow_graph_optimize_fuse_division(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t nodes_size = nodes->size;
+
+    if (nodes_size == 0) {
+        return false;
+    }
+
+    struct walk walk = {
+        .starts = mallocs(sizeof(size_t) * nodes_size),
+        .seq = 0,
+        .last_call = SIZE_MAX,
+    };
+
+    for (size_t i = 0; i < nodes_size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(nodes->values[i]);
+        walk.starts[i] = walk.seq;
+
+        if (expr) {
+            walk_expr(&walk, expr, i);
+        }
+    }
+
+    free(walk.tasks.values);
+
+    bool result = false;
+
+    if (walk.occurrences.size > 1) {
+        const size_t locals_size = subroutine->locals.size;
+
+        struct access_index writes = build_index(&walk.writes, locals_size);
+        struct access_index reads = build_index(&walk.reads, locals_size);
+        size_t * const chains = build_chains(nodes);
+
+        struct occurrence * const values = walk.occurrences.values;
+        const size_t size = walk.occurrences.size;
+
+        for (size_t i = 0; i < size; ++i) {
+            const struct flow_graph_expr * const expr = values[i].expr;
+
+            values[i].chain = chains[values[i].node];
+            values[i].key = flow_graph_expr_hash(expr->binary.lhs) * 31 + flow_graph_expr_hash(expr->binary.rhs);
+        }
+
+        // вхождения с одинаковыми цепочкой и хешем операндов лежат подряд в порядке вычисления,
+        // и первое вхождение пары ищет второе только среди них
+        qsort(values, size, sizeof(struct occurrence), compare_occurrences);
+
+        for (size_t begin = 0, end; begin < size; begin = end) {
+            for (end = begin + 1; end < size && values[end].chain == values[begin].chain && values[end].key == values[begin].key; ++end) {
+            }
+
+            result = fuse_group(subroutine, &walk, &writes, &reads, values, begin, end) || result;
+        }
+
+        free(chains);
+        access_index_fini(&reads);
+        access_index_fini(&writes);
+    }
+
+    free(walk.reads.values);
+    free(walk.writes.values);
+    free(walk.occurrences.values);
+    free(walk.starts);
+
+    if (result) {
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    return result;
+}
@@ -0,0 +1,288 @@
+#include "dominators.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+#define UNDEFINED SIZE_MAX
+
+// номера вершин в обратном порядке обхода в глубину: postorder[i] — место вершины i в порядке
+// выхода, order — вершины в обратном порядке выхода, вход первым
+static void number_postorder(const struct flow_graph_node_list * nodes, size_t * postorder, size_t * order) {
+    size_t * const next_successor = mallocs(sizeof(size_t) * nodes->size);
+    memset(next_successor, 0, sizeof(size_t) * nodes->size);
+
+    bool * const visited = mallocs(sizeof(bool) * nodes->size);
+    memset(visited, 0, sizeof(bool) * nodes->size);
+
+    struct stack stack = stack_init();
+    size_t time = 0;
+
+    stack_push(&stack, nodes->values[0]);
+    visited[0] = true;
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack.values[stack.size - 1];
+        const size_t i = node->index - 1;
+
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        if (next_successor[i] >= successors_size) {
+            postorder[i] = time;
+            order[nodes->size - ++time] = i;
+
+            stack_pop(&stack);
+            continue;
+        }
+
+        struct flow_graph_node * const successor = successors[next_successor[i]++];
+
+        if (!visited[successor->index - 1]) {
+            visited[successor->index - 1] = true;
+            stack_push(&stack, successor);
+        }
+    }
+
+    stack_fini(&stack);
+    free(visited);
+    free(next_successor);
+}
+
+static size_t intersect(size_t lhs, size_t rhs, const size_t * idoms, const size_t * postorder) {
+    while (lhs != rhs) {
+        while (postorder[lhs] < postorder[rhs]) {
+            lhs = idoms[lhs];
+        }
+
+        while (postorder[rhs] < postorder[lhs]) {
+            rhs = idoms[rhs];
+        }
+    }
+
+    return lhs;
+}
+
+// итеративный алгоритм Купера, Харви и Кеннеди: непосредственные доминаторы уточняются
+// в обратном порядке выхода, пока не перестанут меняться; idoms входа указывает на него самого
+static void find_idoms(
+        const struct flow_graph_node_list * nodes,
+        const struct flow_graph_predecessors * predecessors,
+        size_t * idoms
+) {
+    size_t * const postorder = mallocs(sizeof(size_t) * nodes->size);
+    size_t * const order = mallocs(sizeof(size_t) * nodes->size);
+
+    number_postorder(nodes, postorder, order);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        idoms[i] = UNDEFINED;
+    }
+
+    idoms[0] = 0;
+
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (size_t k = 1; k < nodes->size; ++k) {
+            const size_t i = order[k];
+            size_t idom = UNDEFINED;
+
+            for (size_t j = predecessors->offsets[i]; j < predecessors->offsets[i + 1]; ++j) {
+                const size_t predecessor = predecessors->values[j]->index - 1;
+
+                if (idoms[predecessor] == UNDEFINED) {
+                    continue;
+                }
+
+                idom = idom == UNDEFINED ? predecessor : intersect(predecessor, idom, idoms, postorder);
+            }
+
+            if (idoms[i] != idom) {
+                idoms[i] = idom;
+                changed = true;
+            }
+        }
+    }
+
+    free(order);
+    free(postorder);
+}
+
+static void number_tree(struct flow_graph_dominators * dominators, struct flow_graph_node * root) {
+    size_t * const next_child = mallocs(sizeof(size_t) * dominators->size);
+    memcpy(next_child, dominators->children_offsets, sizeof(size_t) * dominators->size);
+
+    struct stack stack = stack_init();
+    size_t time = 0;
+
+    stack_push(&stack, root);
+    dominators->enter[root->index - 1] = time++;
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack.values[stack.size - 1];
+        const size_t i = node->index - 1;
+
+        if (next_child[i] >= dominators->children_offsets[i + 1]) {
+            dominators->leave[i] = time++;
+            stack_pop(&stack);
+            continue;
+        }
+
+        struct flow_graph_node * const child = dominators->children[next_child[i]++];
+
+        dominators->enter[child->index - 1] = time++;
+        stack_push(&stack, child);
+    }
+
+    stack_fini(&stack);
+    free(next_child);
+}
+
+// пары (вершина, элемент её списка) раскладываются по вершинам с сохранением порядка
+static void build_lists(
+        size_t size,
+        const size_t * owners,
+        struct flow_graph_node * const * values,
+        size_t pairs_size,
+        size_t ** offsets,
+        struct flow_graph_node *** lists
+) {
+    *offsets = mallocs(sizeof(size_t) * (size + 1));
+    *lists = mallocs(sizeof(struct flow_graph_node *) * (pairs_size ? pairs_size : 1));
+
+    memset(*offsets, 0, sizeof(size_t) * (size + 1));
+
+    for (size_t k = 0; k < pairs_size; ++k) {
+        ++(*offsets)[owners[k] + 1];
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+        (*offsets)[i + 1] += (*offsets)[i];
+    }
+
+    size_t * const filled = mallocs(sizeof(size_t) * (size ? size : 1));
+    memcpy(filled, *offsets, sizeof(size_t) * size);
+
+    for (size_t k = 0; k < pairs_size; ++k) {
+        (*lists)[filled[owners[k]]++] = values[k];
+    }
+
+    free(filled);
+}
+
+struct pairs {
+
+    size_t size;
+    size_t capacity;
+    size_t * owners;
+    struct flow_graph_node ** values;
+};
+
+static void pairs_append(struct pairs * pairs, size_t owner, struct flow_graph_node * value) {
+    if (pairs->size >= pairs->capacity) {
+        pairs->capacity = pairs->capacity ? pairs->capacity * 2 : 16;
+        pairs->owners = reallocs(pairs->owners, sizeof(size_t) * pairs->capacity);
+        pairs->values = reallocs(pairs->values, sizeof(struct flow_graph_node *) * pairs->capacity);
+    }
+
+    pairs->owners[pairs->size] = owner;
+    pairs->values[pairs->size] = value;
+    ++pairs->size;
+}
+
+struct flow_graph_dominators flow_graph_dominators_build(const struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t size = nodes->size ? nodes->size : 1;
+
+    struct flow_graph_dominators result = {
+        .size = nodes->size,
+        .idoms = mallocs(sizeof(struct flow_graph_node *) * size),
+        .enter = mallocs(sizeof(size_t) * size),
+        .leave = mallocs(sizeof(size_t) * size),
+    };
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    size_t * const idoms = mallocs(sizeof(size_t) * size);
+
+    if (nodes->size > 0) {
+        find_idoms(nodes, &predecessors, idoms);
+    }
+
+    struct pairs pairs = { 0 };
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        result.idoms[i] = i == 0 ? NULL : nodes->values[idoms[i]];
+
+        if (i > 0) {
+            pairs_append(&pairs, idoms[i], nodes->values[i]);
+        }
+    }
+
+    build_lists(nodes->size, pairs.owners, pairs.values, pairs.size, &result.children_offsets, &result.children);
+    pairs.size = 0;
+
+    // вершина попадает в границу каждой вершины на пути по дереву от предшественника
+    // до её непосредственного доминатора, не включая его; вершины обрабатываются по порядку,
+    // поэтому повтор в границе может быть только последним добавленным
+    size_t * const last = mallocs(sizeof(size_t) * size);
+    memset(last, 0, sizeof(size_t) * size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        if (predecessors.offsets[i + 1] - predecessors.offsets[i] < 2) {
+            continue;
+        }
+
+        for (size_t j = predecessors.offsets[i]; j < predecessors.offsets[i + 1]; ++j) {
+            for (size_t runner = predecessors.values[j]->index - 1; runner != idoms[i]; runner = idoms[runner]) {
+                if (last[runner] == i + 1) {
+                    break;
+                }
+
+                last[runner] = i + 1;
+                pairs_append(&pairs, runner, nodes->values[i]);
+            }
+        }
+    }
+
+    build_lists(nodes->size, pairs.owners, pairs.values, pairs.size, &result.frontier_offsets, &result.frontiers);
+
+    if (nodes->size > 0) {
+        number_tree(&result, nodes->values[0]);
+    }
+
+    free(last);
+    free(pairs.owners);
+    free(pairs.values);
+    free(idoms);
+    flow_graph_predecessors_fini(&predecessors);
+
+    return result;
+}
+
+void flow_graph_dominators_fini(struct flow_graph_dominators * dominators) {
+    free(dominators->idoms);
+    free(dominators->children_offsets);
+    free(dominators->children);
+    free(dominators->frontier_offsets);
+    free(dominators->frontiers);
+    free(dominators->enter);
+    free(dominators->leave);
+
+    *dominators = (struct flow_graph_dominators) { 0 };
+}
+
+bool flow_graph_dominators_dominates(
+        const struct flow_graph_dominators * dominators,
+        const struct flow_graph_node * a,
+        const struct flow_graph_node * b
+) {
+    const size_t i = a->index - 1;
+    const size_t j = b->index - 1;
+
+    return dominators->enter[i] <= dominators->enter[j] && dominators->leave[j] <= dominators->leave[i];
+}
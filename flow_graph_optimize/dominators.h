@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "flow_graph.h"
+
+
+// дерево доминаторов: вершина a доминирует над b, если любой путь от входа в b проходит через a;
+// массивы индексируются номером вершины - 1
+struct flow_graph_dominators {
+
+    size_t size;
+
+    // непосредственный доминатор, NULL для входа
+    struct flow_graph_node ** idoms;
+    // дети в дереве доминаторов в порядке номеров: дети вершины с номером i лежат в children
+    // с children_offsets[i - 1] по children_offsets[i] не включительно
+    size_t * children_offsets;
+    struct flow_graph_node ** children;
+
+    // граница доминирования: вершины, над которыми вершина не доминирует строго, но доминирует
+    // над одним из их предшественников; хранится так же, как дети
+    size_t * frontier_offsets;
+    struct flow_graph_node ** frontiers;
+
+    // время входа и выхода при обходе дерева в глубину, по ним доминирование проверяется за константу
+    size_t * enter;
+    size_t * leave;
+};
+
+// вершины должны быть пронумерованы по порядку, см. flow_graph_subroutine_renumber
+struct flow_graph_dominators flow_graph_dominators_build(const struct flow_graph_subroutine * subroutine);
+void flow_graph_dominators_fini(struct flow_graph_dominators * dominators);
+
+// доминирует ли a над b; вершина доминирует сама над собой
+bool flow_graph_dominators_dominates(
+        const struct flow_graph_dominators * dominators,
+        const struct flow_graph_node * a,
+        const struct flow_graph_node * b
+);
@@ -0,0 +1,66 @@
+#include "passes.h"
+
+#include "liveness.h"
+
+
+static bool is_local_assignment(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+           && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+           && expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL;
+}
+
+// присваивание на верхнем уровне выражения выполняется последним, поэтому запись не нужна,
+// если переменная не живая после вершины; от присваивания остаётся правая часть
+static struct flow_graph_expr * eliminate_dead_stores(struct flow_graph_expr * expr, const struct bitset * live_out) {
+    while (is_local_assignment(expr) && !bitset_test(live_out, expr->binary.lhs->local.local->index - 1)) {
+        struct flow_graph_expr * const rhs = expr->binary.rhs;
+
+        expr->binary.rhs = NULL;
+        flow_graph_expr_delete(expr);
+
+        expr = rhs;
+    }
+
+    return expr;
+}
+
+static bool eliminate_round(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_dataflow_result liveness = flow_graph_liveness_build_strong(subroutine);
+    bool result = false;
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        // вершина без следующей возвращает значение выражения, его нельзя ни сократить, ни выбросить
+        if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || !node->expr.expr || !node->expr.next) {
+            continue;
+        }
+
+        struct flow_graph_expr * expr = eliminate_dead_stores(node->expr.expr, &liveness.out[i]);
+
+        if (flow_graph_expr_is_pure(expr)) {
+            flow_graph_expr_delete(expr);
+            expr = NULL;
+        }
+
+        if (expr != node->expr.expr) {
+            node->expr.expr = expr;
+            result = true;
+        }
+    }
+
+    flow_graph_dataflow_result_fini(&liveness);
+    return result;
+}
+
+bool flow_graph_optimize_eliminate(struct flow_graph_subroutine * subroutine) {
+    bool result = false;
+
+    // удалённая запись может сделать мёртвыми записи, значения которых она читала,
+    // поэтому живость пересчитывается, пока что-то удаляется
+    while (eliminate_round(subroutine)) {
+        result = true;
+    }
+
+    return result;
+}
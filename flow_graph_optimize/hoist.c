@@ -0,0 +1,822 @@
+#include "passes.h"
+
+#include <string.h>
+
+#include "dominators.h"
+#include "loops.h"
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// может ли вершина тела вычислить опасное выражение, см. is_safe
+enum safety {
+
+    SAFETY_UNKNOWN = 0,
+    SAFETY_SAFE,
+    SAFETY_UNSAFE,
+};
+
+// вынесенное вычисление: присваивание временной переменной, которое встанет перед заголовком
+struct hoisted {
+
+    size_t hash;
+    struct flow_graph_expr * assignment;
+};
+
+struct hoist_result {
+
+    bool movable;
+    bool reads;
+    // начало выражений в pending, которые вынесутся, если родитель останется в цикле
+    size_t pending;
+};
+
+struct hoist_task {
+
+    struct flow_graph_expr * expr;
+    bool done;
+};
+
+struct hoisting {
+
+    struct flow_graph_subroutine * subroutine;
+    const struct flow_graph_dominators * dominators;
+    const struct flow_graph_predecessors * predecessors;
+
+    const struct flow_graph_loop * loop;
+    size_t stamp;
+
+    // число вершин до выноса, по нему выделены массивы ниже
+    size_t nodes_size;
+
+    // вершины тела отмечены номером текущего цикла + 1
+    size_t * marks;
+    // вызовы и записи в массивы — наблюдаемые побочные эффекты вершины
+    bool * effects;
+    // до вершины от заголовка нельзя дойти через вершины с побочными эффектами
+    bool * clean;
+    enum safety * safety;
+
+    // переменные, в которые пишет тело, отмечены номером текущего цикла + 1
+    size_t written_size;
+    size_t * written;
+
+    bool has_call;
+    size_t stores_size;
+    size_t stores_capacity;
+    const struct ast_type_reference ** stores;
+
+    // вершины тела с переходом наружу или на выход из подпрограммы
+    size_t exits_size;
+    size_t exits_capacity;
+    struct flow_graph_node ** exits;
+
+    // копия условия заголовка для проверки перед вынесенными вычислениями, если заголовок — выход
+    struct flow_graph_expr * guard;
+    bool guarded;
+
+    // текущая вершина тела
+    struct flow_graph_node * node;
+
+    size_t hoisted_size;
+    size_t hoisted_capacity;
+    struct hoisted * hoisted;
+
+    struct stack pending;
+
+    size_t tasks_size;
+    size_t tasks_capacity;
+    struct hoist_task * tasks;
+
+    size_t results_size;
+    size_t results_capacity;
+    struct hoist_result * results;
+};
+
+// вершины, добавленные перед уже пройденными циклами, в массивах не учтены и телу не принадлежат
+static bool in_body(const struct hoisting * hoisting, const struct flow_graph_node * node) {
+    return node
+           && node->index > 0
+           && node->index <= hoisting->nodes_size
+           && hoisting->marks[node->index - 1] == hoisting->stamp;
+}
+
+static void task_push(struct hoisting * hoisting, struct flow_graph_expr * expr, bool done) {
+    if (hoisting->tasks_size >= hoisting->tasks_capacity) {
+        hoisting->tasks_capacity = hoisting->tasks_capacity ? hoisting->tasks_capacity * 2 : 16;
+        hoisting->tasks = reallocs(hoisting->tasks, sizeof(struct hoist_task) * hoisting->tasks_capacity);
+    }
+
+    hoisting->tasks[hoisting->tasks_size++] = (struct hoist_task) {
+        .expr = expr,
+        .done = done,
+    };
+}
+
+static void task_push_list(struct hoisting * hoisting, const struct flow_graph_expr_list * list) {
+    for (size_t i = list->size; i > 0; --i) {
+        task_push(hoisting, list->values[i - 1], false);
+    }
+}
+
+static void result_push(struct hoisting * hoisting, struct hoist_result result) {
+    if (hoisting->results_size >= hoisting->results_capacity) {
+        hoisting->results_capacity = hoisting->results_capacity ? hoisting->results_capacity * 2 : 16;
+        hoisting->results = reallocs(hoisting->results, sizeof(struct hoist_result) * hoisting->results_capacity);
+    }
+
+    hoisting->results[hoisting->results_size++] = result;
+}
+
+static void store_append(struct hoisting * hoisting, const struct ast_type_reference * type) {
+    if (hoisting->stores_size >= hoisting->stores_capacity) {
+        hoisting->stores_capacity = hoisting->stores_capacity ? hoisting->stores_capacity * 2 : 4;
+        hoisting->stores =
+                reallocs(hoisting->stores, sizeof(struct ast_type_reference *) * hoisting->stores_capacity);
+    }
+
+    hoisting->stores[hoisting->stores_size++] = type;
+}
+
+static void exit_append(struct hoisting * hoisting, struct flow_graph_node * node) {
+    if (hoisting->exits_size >= hoisting->exits_capacity) {
+        hoisting->exits_capacity = hoisting->exits_capacity ? hoisting->exits_capacity * 2 : 4;
+        hoisting->exits = reallocs(hoisting->exits, sizeof(struct flow_graph_node *) * hoisting->exits_capacity);
+    }
+
+    hoisting->exits[hoisting->exits_size++] = node;
+}
+
+static void hoisted_append(struct hoisting * hoisting, size_t hash, struct flow_graph_expr * assignment) {
+    if (hoisting->hoisted_size >= hoisting->hoisted_capacity) {
+        hoisting->hoisted_capacity = hoisting->hoisted_capacity ? hoisting->hoisted_capacity * 2 : 4;
+        hoisting->hoisted = reallocs(hoisting->hoisted, sizeof(struct hoisted) * hoisting->hoisted_capacity);
+    }
+
+    hoisting->hoisted[hoisting->hoisted_size++] = (struct hoisted) {
+        .hash = hash,
+        .assignment = assignment,
+    };
+}
+
+// чтение элемента массива не меняется в цикле, если в теле нет вызовов и записей в элементы того же типа:
+// массивы разных типов не пересекаются
+static bool is_memory_invariant(const struct hoisting * hoisting, const struct ast_type_reference * type) {
+    if (hoisting->has_call) {
+        return false;
+    }
+
+    for (size_t i = 0; i < hoisting->stores_size; ++i) {
+        if (ast_type_reference_equals(hoisting->stores[i], type)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// деление и остаток ловушка останавливает при нулевом делителе, чтение элемента — при плохом адресе
+static bool is_trapping(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+            const struct flow_graph_expr * const rhs = expr->binary.rhs;
+
+            if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE
+                    && expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER) {
+                return false;
+            }
+
+            return rhs->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL
+                   || rhs->literal.literal->_type != FLOW_GRAPH_LITERAL_TYPE_INT
+                   || rhs->literal.literal->_int.value == 0;
+        }
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// опасное выражение выносится, только если при входе в цикл оно вычислилось бы и так, причём раньше
+// любых наблюдаемых побочных эффектов: вершина доминирует над концами обратных дуг и выходами,
+// а если выход — сам заголовок, вынесенные вычисления защищаются копией его условия
+static bool is_safe(struct hoisting * hoisting, struct flow_graph_node * node) {
+    const size_t i = node->index - 1;
+
+    if (hoisting->safety[i] != SAFETY_UNKNOWN) {
+        return hoisting->safety[i] == SAFETY_SAFE;
+    }
+
+    const struct flow_graph_loop * const loop = hoisting->loop;
+    bool result = !hoisting->effects[i] && hoisting->clean[i];
+    bool guarded = false;
+
+    if (result && node != loop->header) {
+        for (size_t k = 0; result && k < loop->latches_size; ++k) {
+            result = flow_graph_dominators_dominates(hoisting->dominators, node, loop->latches[k]);
+        }
+
+        for (size_t k = 0; result && k < hoisting->exits_size; ++k) {
+            if (hoisting->exits[k] == loop->header) {
+                guarded = true;
+                result = hoisting->guard != NULL;
+            } else {
+                result = flow_graph_dominators_dominates(hoisting->dominators, node, hoisting->exits[k]);
+            }
+        }
+    }
+
+    hoisting->safety[i] = result ? SAFETY_SAFE : SAFETY_UNSAFE;
+    hoisting->guarded = hoisting->guarded || (result && guarded);
+
+    return result;
+}
+
+static void delete_operands(struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            flow_graph_expr_delete(expr->binary.lhs);
+            flow_graph_expr_delete(expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            flow_graph_expr_delete(expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            flow_graph_expr_list_fini(&expr->call.args);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            flow_graph_expr_delete(expr->indexer.value);
+            flow_graph_expr_list_fini(&expr->indexer.indices);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            break;
+    }
+}
+
+// выражение заменяется на месте чтением временной переменной, а его прежнее содержимое переезжает
+// в присваивание перед циклом; одинаковые выражения одного цикла делят одну переменную
+static struct flow_graph_local * find_hoisted(
+        const struct hoisting * hoisting,
+        const struct flow_graph_expr * expr,
+        size_t hash
+) {
+    for (size_t i = 0; i < hoisting->hoisted_size; ++i) {
+        const struct flow_graph_expr * const assignment = hoisting->hoisted[i].assignment;
+
+        if (hoisting->hoisted[i].hash == hash && flow_graph_expr_equals(assignment->binary.rhs, expr)) {
+            return assignment->binary.lhs->local.local;
+        }
+    }
+
+    return NULL;
+}
+
+// опасное выражение, которое уже вычисляется перед циклом, можно брать оттуда из любой вершины тела
+static bool is_hoisted(const struct hoisting * hoisting, const struct flow_graph_expr * expr) {
+    return hoisting->hoisted_size > 0 && find_hoisted(hoisting, expr, flow_graph_expr_hash(expr));
+}
+
+static void hoist(struct hoisting * hoisting, struct flow_graph_expr * expr) {
+    const size_t hash = flow_graph_expr_hash(expr);
+    struct flow_graph_local * temp = find_hoisted(hoisting, expr, hash);
+
+    if (temp) {
+        delete_operands(expr);
+    } else {
+        temp = flow_graph_subroutine_add_temp(hoisting->subroutine, ast_type_reference_clone(expr->type), expr->position);
+
+        struct flow_graph_expr * const moved = mallocs(sizeof(struct flow_graph_expr));
+        *moved = *expr;
+        moved->type = ast_type_reference_clone(expr->type);
+
+        struct flow_graph_expr * const lhs = flow_graph_expr_new_typed_local(expr->position, temp);
+
+        struct flow_graph_expr * const assignment =
+                flow_graph_expr_new_binary(expr->position, FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT, lhs, moved);
+        assignment->type = ast_type_reference_clone(temp->type);
+
+        hoisted_append(hoisting, hash, assignment);
+    }
+
+    expr->_type = FLOW_GRAPH_EXPR_TYPE_LOCAL;
+    expr->local.local = temp;
+}
+
+static void hoist_pending(struct hoisting * hoisting, size_t offset) {
+    for (size_t i = offset; i < hoisting->pending.size; ++i) {
+        hoist(hoisting, hoisting->pending.values[i]);
+    }
+
+    hoisting->pending.size = offset;
+}
+
+// у многомерного массива указатели на строки читаются по очереди, поэтому, если массив и первые
+// индексы не меняются в цикле, чтение строки выносится отдельным индексатором с типом массива
+// оставшихся измерений; results — результаты массива и индексов
+static void hoist_rows(struct hoisting * hoisting, struct flow_graph_expr * indexer, const struct hoist_result * results) {
+    struct flow_graph_expr_list * const indices = &indexer->indexer.indices;
+
+    if (indices->size < 2 || !results[0].movable) {
+        return;
+    }
+
+    size_t prefix = 0;
+
+    while (prefix < indices->size - 1 && results[prefix + 1].movable) {
+        ++prefix;
+    }
+
+    if (prefix == 0) {
+        return;
+    }
+
+    struct ast_type_reference * const type = ast_type_reference_new_array(
+            indexer->position,
+            ast_type_reference_clone(indexer->type),
+            indices->size - prefix
+    );
+
+    if (!is_memory_invariant(hoisting, type)) {
+        ast_type_reference_delete(type);
+        return;
+    }
+
+    struct flow_graph_expr * const row = flow_graph_expr_new_indexer(indexer->position, indexer->indexer.value);
+    row->type = type;
+
+    for (size_t i = 0; i < prefix; ++i) {
+        flow_graph_expr_list_append(&row->indexer.indices, indices->values[i]);
+    }
+
+    if (!is_safe(hoisting, hoisting->node) && !is_hoisted(hoisting, row)) {
+        free(row->indexer.indices.values);
+        ast_type_reference_delete(row->type);
+        free(row);
+        return;
+    }
+
+    memmove(indices->values, &indices->values[prefix], sizeof(struct flow_graph_expr *) * (indices->size - prefix));
+    indices->size -= prefix;
+
+    indexer->indexer.value = row;
+    hoist(hoisting, row);
+}
+
+static size_t get_operands_count(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+                    && expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+                return 1;
+            }
+
+            if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                return 2 + expr->binary.lhs->indexer.indices.size;
+            }
+
+            return 2;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            return 1;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            return expr->call.args.size;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            return 1 + expr->indexer.indices.size;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            return 0;
+    }
+
+    return 0;
+}
+
+// выражение выносится целиком, если оно не меняется в цикле и его можно вычислить заранее; вынесенными
+// оказываются наибольшие такие выражения, логические не выносятся: переменная хранит их байтом
+static void finish_expr(struct hoisting * hoisting, struct flow_graph_expr * expr) {
+    const size_t results_offset = hoisting->results_size - get_operands_count(expr);
+    const struct hoist_result * const results = &hoisting->results[results_offset];
+    const size_t pending = results_offset < hoisting->results_size ? results[0].pending : hoisting->pending.size;
+
+    bool invariant = true;
+    bool reads = false;
+
+    for (size_t i = 0; i < hoisting->results_size - results_offset; ++i) {
+        invariant = invariant && results[i].movable;
+        reads = reads || results[i].reads;
+    }
+
+    bool candidate = false;
+
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            invariant = invariant && expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT;
+            candidate = true;
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            candidate = true;
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            invariant = false;
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            invariant = invariant && is_memory_invariant(hoisting, expr->type);
+            reads = true;
+            candidate = true;
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL: {
+            const size_t i = expr->local.local->index - 1;
+
+            invariant = i >= hoisting->written_size || hoisting->written[i] != hoisting->stamp;
+            reads = true;
+            break;
+        }
+
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            break;
+    }
+
+    const bool movable = invariant
+                         && (!is_trapping(expr) || is_safe(hoisting, hoisting->node) || is_hoisted(hoisting, expr));
+
+    if (!movable) {
+        hoist_pending(hoisting, pending);
+
+        if (expr->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+            hoist_rows(hoisting, expr, results);
+        } else if (expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+                && expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER
+                && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+            hoist_rows(hoisting, expr->binary.lhs, results);
+        }
+    } else if (candidate && reads && !ast_type_reference_is_bool(expr->type)) {
+        hoisting->pending.size = pending;
+        stack_push(&hoisting->pending, expr);
+    }
+
+    hoisting->results_size = results_offset;
+    result_push(hoisting, (struct hoist_result) {
+        .movable = movable,
+        .reads = reads,
+        .pending = pending,
+    });
+}
+
+// обход в порядке вычисления; у присваивания в элемент массива обходятся массив и индексы
+static void hoist_expr(struct hoisting * hoisting, struct flow_graph_expr * root) {
+    task_push(hoisting, root, false);
+
+    while (hoisting->tasks_size > 0) {
+        const struct hoist_task task = hoisting->tasks[--hoisting->tasks_size];
+        struct flow_graph_expr * const expr = task.expr;
+
+        if (task.done) {
+            finish_expr(hoisting, expr);
+            continue;
+        }
+
+        task_push(hoisting, expr, true);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+                struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                task_push(hoisting, expr->binary.rhs, false);
+
+                if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    task_push(hoisting, lhs, false);
+                } else if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+                    task_push_list(hoisting, &lhs->indexer.indices);
+                    task_push(hoisting, lhs->indexer.value, false);
+                }
+
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                task_push(hoisting, expr->unary.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                task_push_list(hoisting, &expr->call.args);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                task_push_list(hoisting, &expr->indexer.indices);
+                task_push(hoisting, expr->indexer.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    hoist_pending(hoisting, hoisting->results[0].pending);
+    hoisting->results_size = 0;
+}
+
+// записи тела в переменные и массивы, вызовы и побочные эффекты каждой вершины
+static void scan_effects(struct hoisting * hoisting, struct flow_graph_node * node) {
+    struct flow_graph_expr * const root = flow_graph_node_get_expr(node);
+    bool effects = false;
+
+    struct stack stack = stack_init();
+
+    if (root) {
+        stack_push(&stack, root);
+    }
+
+    while (stack.size > 0) {
+        const struct flow_graph_expr * const expr = stack_pop(&stack);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                    if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+                        hoisting->written[lhs->local.local->index - 1] = hoisting->stamp;
+                    } else {
+                        store_append(hoisting, lhs->type);
+                        effects = true;
+
+                        stack_push(&stack, lhs->indexer.value);
+
+                        for (size_t i = 0; i < lhs->indexer.indices.size; ++i) {
+                            stack_push(&stack, lhs->indexer.indices.values[i]);
+                        }
+                    }
+                } else {
+                    stack_push(&stack, expr->binary.lhs);
+                }
+
+                stack_push(&stack, expr->binary.rhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(&stack, expr->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                hoisting->has_call = true;
+                effects = true;
+
+                for (size_t i = 0; i < expr->call.args.size; ++i) {
+                    stack_push(&stack, expr->call.args.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                stack_push(&stack, expr->indexer.value);
+
+                for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                    stack_push(&stack, expr->indexer.indices.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    hoisting->effects[node->index - 1] = effects;
+}
+
+// вершина чиста, если на путях к ней от заголовка внутри тела нет побочных эффектов;
+// нечистота расходится от вершин с эффектами по переходам тела, кроме переходов в заголовок
+static void find_clean(struct hoisting * hoisting) {
+    const struct flow_graph_loop * const loop = hoisting->loop;
+    struct stack stack = stack_init();
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        hoisting->clean[loop->body[i]->index - 1] = true;
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        if (hoisting->effects[loop->body[i]->index - 1]) {
+            stack_push(&stack, loop->body[i]);
+        }
+    }
+
+    while (stack.size > 0) {
+        const struct flow_graph_node * const node = stack_pop(&stack);
+
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            struct flow_graph_node * const successor = successors[k];
+
+            if (in_body(hoisting, successor) && successor != loop->header && hoisting->clean[successor->index - 1]) {
+                hoisting->clean[successor->index - 1] = false;
+                stack_push(&stack, successor);
+            }
+        }
+    }
+
+    stack_fini(&stack);
+}
+
+static void scan_body(struct hoisting * hoisting) {
+    const struct flow_graph_loop * const loop = hoisting->loop;
+    struct flow_graph_node * const header = loop->header;
+
+    const size_t locals_size = hoisting->subroutine->locals.size;
+
+    if (hoisting->written_size < locals_size) {
+        hoisting->written = reallocs(hoisting->written, sizeof(size_t) * locals_size);
+        memset(&hoisting->written[hoisting->written_size], 0, sizeof(size_t) * (locals_size - hoisting->written_size));
+        hoisting->written_size = locals_size;
+    }
+
+    hoisting->has_call = false;
+    hoisting->stores_size = 0;
+    hoisting->exits_size = 0;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        hoisting->marks[loop->body[i]->index - 1] = hoisting->stamp;
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_node * const node = loop->body[i];
+
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        bool exit = flow_graph_node_is_exit(node);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            exit = exit || !in_body(hoisting, successors[k]);
+        }
+
+        if (exit) {
+            exit_append(hoisting, node);
+        }
+
+        scan_effects(hoisting, node);
+        hoisting->safety[node->index - 1] = SAFETY_UNKNOWN;
+    }
+
+    find_clean(hoisting);
+
+    // условие заголовка копируется до выноса, потому что вынос заменяет его части временными переменными
+    hoisting->guard = NULL;
+    hoisting->guarded = false;
+
+    if (header->_type == FLOW_GRAPH_NODE_TYPE_COND
+            && flow_graph_expr_is_pure(header->cond.cond)
+            && in_body(hoisting, header->cond.then_next) != in_body(hoisting, header->cond.else_next)) {
+        hoisting->guard = flow_graph_expr_clone(header->cond.cond);
+    }
+}
+
+// вынесенные присваивания ставятся цепочкой перед заголовком, в неё уводятся все входы в цикл снаружи;
+// защита повторяет условие заголовка и при выходе из цикла обходит цепочку
+static void insert_preheader(struct hoisting * hoisting) {
+    struct flow_graph_node_list * const nodes = &hoisting->subroutine->nodes;
+    struct flow_graph_node * const header = hoisting->loop->header;
+
+    struct flow_graph_node * next = header;
+
+    for (size_t i = hoisting->hoisted_size; i > 0; --i) {
+        struct flow_graph_node * const node =
+                flow_graph_node_new_expr(header->position, hoisting->hoisted[i - 1].assignment);
+
+        node->expr.next = next;
+        flow_graph_node_list_append(nodes, node);
+
+        next = node;
+    }
+
+    if (hoisting->guarded) {
+        struct flow_graph_node * const node = flow_graph_node_new_cond(header->position, hoisting->guard);
+        hoisting->guard = NULL;
+
+        if (in_body(hoisting, header->cond.then_next)) {
+            node->cond.then_next = next;
+            node->cond.else_next = header->cond.else_next;
+        } else {
+            node->cond.then_next = header->cond.then_next;
+            node->cond.else_next = next;
+        }
+
+        flow_graph_node_list_append(nodes, node);
+        next = node;
+    }
+
+    flow_graph_loop_insert_preheader(hoisting->subroutine, hoisting->loop, hoisting->predecessors, next);
+}
+
+static bool hoist_loop(struct hoisting * hoisting) {
+    const struct flow_graph_loop * const loop = hoisting->loop;
+
+    scan_body(hoisting);
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        hoisting->node = loop->body[i];
+
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(hoisting->node);
+
+        if (expr) {
+            hoist_expr(hoisting, expr);
+        }
+    }
+
+    const bool result = hoisting->hoisted_size > 0;
+
+    if (result) {
+        insert_preheader(hoisting);
+    }
+
+    flow_graph_expr_delete(hoisting->guard);
+    hoisting->guard = NULL;
+    hoisting->hoisted_size = 0;
+
+    return result;
+}
+
+bool flow_graph_optimize_hoist_invariants(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0) {
+        return false;
+    }
+
+    struct flow_graph_dominators dominators = flow_graph_dominators_build(subroutine);
+    struct flow_graph_loops loops = flow_graph_loops_find(subroutine, &dominators);
+
+    if (loops.size == 0) {
+        flow_graph_loops_fini(&loops);
+        flow_graph_dominators_fini(&dominators);
+        return false;
+    }
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    const size_t nodes_size = nodes->size;
+
+    struct hoisting hoisting = {
+        .subroutine = subroutine,
+        .dominators = &dominators,
+        .predecessors = &predecessors,
+        .nodes_size = nodes_size,
+        .marks = mallocs(sizeof(size_t) * nodes_size),
+        .effects = mallocs(sizeof(bool) * nodes_size),
+        .clean = mallocs(sizeof(bool) * nodes_size),
+        .safety = mallocs(sizeof(enum safety) * nodes_size),
+        .pending = stack_init(),
+    };
+
+    memset(hoisting.marks, 0, sizeof(size_t) * nodes_size);
+
+    bool result = false;
+
+    // объемлющие циклы обходятся раньше вложенных: вычисление выносится сразу из самого внешнего цикла,
+    // в котором оно не меняется, а новые вершины оказываются вне всех ещё не пройденных циклов
+    for (size_t i = 0; i < loops.size; ++i) {
+        hoisting.loop = &loops.values[i];
+        hoisting.stamp = i + 1;
+
+        result = hoist_loop(&hoisting) || result;
+    }
+
+    free(hoisting.results);
+    free(hoisting.tasks);
+    stack_fini(&hoisting.pending);
+    free(hoisting.hoisted);
+    free(hoisting.exits);
+    free(hoisting.stores);
+    free(hoisting.written);
+    free(hoisting.safety);
+    free(hoisting.clean);
+    free(hoisting.effects);
+    free(hoisting.marks);
+
+    flow_graph_predecessors_fini(&predecessors);
+    flow_graph_loops_fini(&loops);
+    flow_graph_dominators_fini(&dominators);
+
+    if (result) {
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    return result;
+}
@@ -0,0 +1,658 @@
+#include "passes.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dominators.h"
+#include "liveness.h"
+#include "loops.h"
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// обращения к переменной в текущем цикле, действительны, только если stamp совпадает с его отметкой
+struct local_info {
+
+    size_t stamp;
+    size_t writes;
+    size_t reads;
+
+    // чтения в индексах обращений к массивам, которые можно перевести на указатель
+    size_t addressing;
+
+    // номер индуктивной переменной + 1
+    size_t induction;
+};
+
+// базовая индуктивная переменная: единственная запись в неё в цикле — i = i ± c в корне вершины bump
+struct induction {
+
+    struct flow_graph_local * local;
+    struct flow_graph_node * bump;
+    uint32_t step;
+
+    // переменная нужна только для адресации, и все обращения через неё переводятся на указатели
+    bool addressing_only;
+};
+
+// обращение base[i ± offset] с единственным индексом, base в цикле не меняется
+struct access {
+
+    struct flow_graph_expr * indexer;
+    size_t induction;
+    struct flow_graph_local * base;
+    uint32_t offset;
+};
+
+struct reduction {
+
+    struct flow_graph_subroutine * subroutine;
+    const struct flow_graph_predecessors * predecessors;
+    const struct flow_graph_dataflow_result * liveness;
+
+    const struct flow_graph_loop * loop;
+    size_t stamp;
+
+    // число вершин и переменных до прохода, по ним выделены массивы ниже
+    size_t nodes_size;
+    size_t locals_size;
+
+    // вершины тела отмечены номером текущего цикла + 1
+    size_t * marks;
+    struct local_info * locals;
+
+    size_t inductions_size;
+    size_t inductions_capacity;
+    struct induction * inductions;
+
+    size_t accesses_size;
+    size_t accesses_capacity;
+    struct access * accesses;
+
+    // присваивания указателям, которые встанут перед заголовком
+    size_t preheader_size;
+    size_t preheader_capacity;
+    struct flow_graph_expr ** preheader;
+
+    struct stack stack;
+};
+
+// вершины, добавленные перед уже пройденными циклами, в массивах не учтены и телу не принадлежат
+static bool in_body(const struct reduction * reduction, const struct flow_graph_node * node) {
+    return node
+           && node->index > 0
+           && node->index <= reduction->nodes_size
+           && reduction->marks[node->index - 1] == reduction->stamp;
+}
+
+// переменные, добавленные проходом, индуктивными и базами обращений не бывают
+static struct local_info * get_info(struct reduction * reduction, const struct flow_graph_local * local) {
+    if (local->index == 0 || local->index > reduction->locals_size) {
+        return NULL;
+    }
+
+    struct local_info * const info = &reduction->locals[local->index - 1];
+
+    if (info->stamp != reduction->stamp) {
+        *info = (struct local_info) {
+            .stamp = reduction->stamp,
+        };
+    }
+
+    return info;
+}
+
+// размер значения в памяти, как его кладёт кодогенерация
+static size_t get_type_size(const struct ast_type_reference * type) {
+    if (type->_type != AST_TYPE_REFERENCE_TYPE_BUILTIN) {
+        return 4;
+    }
+
+    switch (type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BOOL:
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_CHAR:
+            return 1;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return 2;
+
+        default:
+            return 4;
+    }
+}
+
+// целое во всё слово: переполнение индуктивной переменной совпадает с переполнением адреса
+static bool is_word_type(const struct ast_type_reference * type) {
+    return ast_type_reference_is_numeric(type) && get_type_size(type) == 4;
+}
+
+// слово, которое литерал оставляет на стеке после обрезки до своего типа и расширения
+static bool get_literal(const struct flow_graph_expr * expr, uint32_t * value) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL
+        || expr->literal.literal->_type != FLOW_GRAPH_LITERAL_TYPE_INT
+        || !ast_type_reference_is_numeric(expr->type)) {
+        return false;
+    }
+
+    const uint32_t word = (uint32_t) expr->literal.literal->_int.value;
+
+    switch (expr->type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            *value = (uint8_t) word;
+            break;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            *value = (uint32_t) (int32_t) (int16_t) word;
+            break;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            *value = (uint16_t) word;
+            break;
+
+        default:
+            *value = word;
+            break;
+    }
+
+    return true;
+}
+
+static bool is_local(const struct flow_graph_expr * expr, const struct flow_graph_local * local) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->local.local == local;
+}
+
+// i ± c, где c — литерал; результат — слово, которое прибавляется к i
+static bool match_offset(const struct flow_graph_expr * expr, const struct flow_graph_local * local, uint32_t * offset) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+    const struct flow_graph_expr * const rhs = expr->binary.rhs;
+    uint32_t value;
+
+    switch (expr->binary.op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_PLUS:
+            if (is_local(lhs, local) && get_literal(rhs, &value)) {
+                *offset = value;
+                return true;
+            }
+
+            if (is_local(rhs, local) && get_literal(lhs, &value)) {
+                *offset = value;
+                return true;
+            }
+
+            return false;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_MINUS:
+            if (is_local(lhs, local) && get_literal(rhs, &value)) {
+                *offset = -value;
+                return true;
+            }
+
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+static void count_access(struct flow_graph_expr * expr, bool write, void * context) {
+    struct local_info * const info = get_info(context, expr->local.local);
+
+    if (info) {
+        if (write) {
+            ++info->writes;
+        } else {
+            ++info->reads;
+        }
+    }
+}
+
+static void induction_append(struct reduction * reduction, struct induction induction) {
+    if (reduction->inductions_size >= reduction->inductions_capacity) {
+        reduction->inductions_capacity = reduction->inductions_capacity ? reduction->inductions_capacity * 2 : 4;
+        reduction->inductions =
+                reallocs(reduction->inductions, sizeof(struct induction) * reduction->inductions_capacity);
+    }
+
+    reduction->inductions[reduction->inductions_size++] = induction;
+}
+
+static void access_append(struct reduction * reduction, struct access access) {
+    if (reduction->accesses_size >= reduction->accesses_capacity) {
+        reduction->accesses_capacity = reduction->accesses_capacity ? reduction->accesses_capacity * 2 : 16;
+        reduction->accesses = reallocs(reduction->accesses, sizeof(struct access) * reduction->accesses_capacity);
+    }
+
+    reduction->accesses[reduction->accesses_size++] = access;
+}
+
+static void preheader_append(struct reduction * reduction, struct flow_graph_expr * assignment) {
+    if (reduction->preheader_size >= reduction->preheader_capacity) {
+        reduction->preheader_capacity = reduction->preheader_capacity ? reduction->preheader_capacity * 2 : 4;
+        reduction->preheader =
+                reallocs(reduction->preheader, sizeof(struct flow_graph_expr *) * reduction->preheader_capacity);
+    }
+
+    reduction->preheader[reduction->preheader_size++] = assignment;
+}
+
+// вершина i = i ± c, после которой цикл продолжается; выход из подпрограммы по ней вернул бы значение
+static void find_induction(struct reduction * reduction, struct flow_graph_node * node) {
+    if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || !in_body(reduction, node->expr.next)) {
+        return;
+    }
+
+    const struct flow_graph_expr * const expr = node->expr.expr;
+
+    if (!expr
+        || expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+        || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+        || expr->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        return;
+    }
+
+    struct flow_graph_local * const local = expr->binary.lhs->local.local;
+    struct local_info * const info = get_info(reduction, local);
+    uint32_t step;
+
+    if (!info
+        || info->writes != 1
+        || !is_word_type(local->type)
+        || !ast_type_reference_equals(expr->binary.rhs->type, local->type)
+        || !match_offset(expr->binary.rhs, local, &step)
+        || step == 0) {
+        return;
+    }
+
+    induction_append(reduction, (struct induction) {
+        .local = local,
+        .bump = node,
+        .step = step,
+    });
+
+    info->induction = reduction->inductions_size;
+}
+
+static void match_access(struct reduction * reduction, struct flow_graph_expr * expr) {
+    if (expr->indexer.indices.size != 1 || expr->indexer.value->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        return;
+    }
+
+    struct flow_graph_local * const base = expr->indexer.value->local.local;
+    const struct local_info * const base_info = get_info(reduction, base);
+
+    if (!base_info || base_info->writes > 0) {
+        return;
+    }
+
+    const struct flow_graph_expr * const index = expr->indexer.indices.values[0];
+
+    if (!is_word_type(index->type)) {
+        return;
+    }
+
+    struct flow_graph_local * local = NULL;
+    uint32_t offset = 0;
+
+    if (index->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        local = index->local.local;
+    } else if (index->_type == FLOW_GRAPH_EXPR_TYPE_BINARY) {
+        const struct flow_graph_expr * const operand =
+                index->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL ? index->binary.lhs : index->binary.rhs;
+
+        if (operand->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && match_offset(index, operand->local.local, &offset)) {
+            local = operand->local.local;
+        }
+    }
+
+    struct local_info * const info = local ? get_info(reduction, local) : NULL;
+
+    if (!info || info->induction == 0) {
+        return;
+    }
+
+    ++info->addressing;
+
+    access_append(reduction, (struct access) {
+        .indexer = expr,
+        .induction = info->induction - 1,
+        .base = base,
+        .offset = offset,
+    });
+}
+
+static void collect_accesses(struct reduction * reduction, struct flow_graph_expr * root) {
+    struct stack * const stack = &reduction->stack;
+    stack_push(stack, root);
+
+    while (stack->size > 0) {
+        struct flow_graph_expr * const expr = stack_pop(stack);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                stack_push(stack, expr->binary.rhs);
+                stack_push(stack, expr->binary.lhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(stack, expr->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                for (size_t i = 0; i < expr->call.args.size; ++i) {
+                    stack_push(stack, expr->call.args.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                match_access(reduction, expr);
+
+                for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                    stack_push(stack, expr->indexer.indices.values[i]);
+                }
+
+                stack_push(stack, expr->indexer.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+}
+
+static bool is_live_at(const struct reduction * reduction, const struct flow_graph_node * node, const struct flow_graph_local * local) {
+    if (!node || in_body(reduction, node)) {
+        return false;
+    }
+
+    if (node->index == 0 || node->index > reduction->nodes_size) {
+        return true;
+    }
+
+    return bitset_test(&reduction->liveness->in[node->index - 1], local->index - 1);
+}
+
+// значение переменной может понадобиться после выхода из цикла
+static bool is_live_after(const struct reduction * reduction, const struct flow_graph_local * local) {
+    const struct flow_graph_loop * const loop = reduction->loop;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        const struct flow_graph_node * const node = loop->body[i];
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                if (is_live_at(reduction, node->expr.next, local)) {
+                    return true;
+                }
+
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                if (is_live_at(reduction, node->cond.then_next, local)
+                    || is_live_at(reduction, node->cond.else_next, local)) {
+                    return true;
+                }
+
+                break;
+        }
+    }
+
+    return false;
+}
+
+static int compare_accesses(const void * lhs, const void * rhs) {
+    const struct access * const lhs_access = lhs;
+    const struct access * const rhs_access = rhs;
+
+    if (lhs_access->induction != rhs_access->induction) {
+        return lhs_access->induction < rhs_access->induction ? -1 : 1;
+    }
+
+    if (lhs_access->base != rhs_access->base) {
+        return lhs_access->base->index < rhs_access->base->index ? -1 : 1;
+    }
+
+    return lhs_access->indexer < rhs_access->indexer ? -1 : lhs_access->indexer > rhs_access->indexer;
+}
+
+static struct flow_graph_expr * new_binary(
+        struct position position,
+        enum flow_graph_expr_binary_op op,
+        struct flow_graph_expr * lhs,
+        struct flow_graph_expr * rhs
+) {
+    struct flow_graph_expr * const expr = flow_graph_expr_new_binary(position, op, lhs, rhs);
+    expr->type = ast_type_reference_clone(lhs->type);
+    return expr;
+}
+
+// обращения одной группы переводятся на указатель p = base + i * size, который сдвигается сразу после
+// записи в i; индекс становится литералом, и кодогенерация складывает его со смещением заголовка массива
+static void reduce_group(struct reduction * reduction, const struct access * accesses, size_t size) {
+    const struct induction * const induction = &reduction->inductions[accesses[0].induction];
+    struct flow_graph_local * const base = accesses[0].base;
+    struct ast_type_reference * const index_type = induction->local->type;
+
+    const size_t elem_size = get_type_size(accesses[0].indexer->type);
+    const struct position position = reduction->loop->header->position;
+
+    struct flow_graph_local * const pointer =
+            flow_graph_subroutine_add_temp(reduction->subroutine, ast_type_reference_clone(base->type), base->position);
+
+    preheader_append(reduction, new_binary(
+            position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_typed_local(position, pointer),
+            new_binary(
+                    position,
+                    FLOW_GRAPH_EXPR_BINARY_OP_PLUS,
+                    flow_graph_expr_new_typed_local(position, base),
+                    new_binary(
+                            position,
+                            FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY,
+                            flow_graph_expr_new_typed_local(position, induction->local),
+                            flow_graph_expr_new_typed_int(position, ast_type_reference_clone(index_type), elem_size)
+                    )
+            )
+    ));
+
+    struct flow_graph_node * const bump = induction->bump;
+
+    struct flow_graph_node * const node = flow_graph_node_new_expr(bump->position, new_binary(
+            bump->position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_typed_local(bump->position, pointer),
+            new_binary(
+                    bump->position,
+                    FLOW_GRAPH_EXPR_BINARY_OP_PLUS,
+                    flow_graph_expr_new_typed_local(bump->position, pointer),
+                    flow_graph_expr_new_typed_int(
+                            bump->position,
+                            ast_type_reference_clone(index_type),
+                            induction->step * (uint32_t) elem_size
+                    )
+            )
+    ));
+
+    node->expr.next = bump->expr.next;
+    bump->expr.next = node;
+    flow_graph_node_list_append(&reduction->subroutine->nodes, node);
+
+    for (size_t i = 0; i < size; ++i) {
+        struct flow_graph_expr * const indexer = accesses[i].indexer;
+
+        flow_graph_expr_delete(indexer->indexer.value);
+        indexer->indexer.value = flow_graph_expr_new_typed_local(indexer->position, pointer);
+
+        flow_graph_expr_delete(indexer->indexer.indices.values[0]);
+        indexer->indexer.indices.values[0] =
+                flow_graph_expr_new_typed_int(indexer->position, ast_type_reference_clone(index_type), accesses[i].offset);
+    }
+}
+
+static void insert_preheader(struct reduction * reduction) {
+    struct flow_graph_node * const header = reduction->loop->header;
+    struct flow_graph_node * next = header;
+
+    for (size_t i = reduction->preheader_size; i > 0; --i) {
+        struct flow_graph_node * const node = flow_graph_node_new_expr(header->position, reduction->preheader[i - 1]);
+
+        node->expr.next = next;
+        flow_graph_node_list_append(&reduction->subroutine->nodes, node);
+
+        next = node;
+    }
+
+    flow_graph_loop_insert_preheader(reduction->subroutine, reduction->loop, reduction->predecessors, next);
+    reduction->preheader_size = 0;
+}
+
+static bool reduce_loop(struct reduction * reduction) {
+    const struct flow_graph_loop * const loop = reduction->loop;
+
+    reduction->inductions_size = 0;
+    reduction->accesses_size = 0;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        reduction->marks[loop->body[i]->index - 1] = reduction->stamp;
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(loop->body[i]);
+
+        if (expr) {
+            flow_graph_expr_visit_locals(expr, count_access, reduction);
+        }
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        find_induction(reduction, loop->body[i]);
+    }
+
+    if (reduction->inductions_size == 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(loop->body[i]);
+
+        if (expr) {
+            collect_accesses(reduction, expr);
+        }
+    }
+
+    // чтение в самой записи i = i ± c не в счёт: если других чтений, кроме индексов, нет, а после цикла
+    // переменная не нужна, её сдвиг становится мёртвым и удаляется вслед за этим проходом
+    for (size_t i = 0; i < reduction->inductions_size; ++i) {
+        struct induction * const induction = &reduction->inductions[i];
+        const struct local_info * const info = get_info(reduction, induction->local);
+
+        induction->addressing_only = info->addressing > 0
+                                     && info->reads == info->addressing + 1
+                                     && !is_live_after(reduction, induction->local);
+    }
+
+    if (reduction->accesses_size > 0) {
+        qsort(reduction->accesses, reduction->accesses_size, sizeof(struct access), compare_accesses);
+    }
+
+    // указатель окупается, если заменяет хотя бы два умножения или позволяет убрать саму переменную
+    for (size_t i = 0, end; i < reduction->accesses_size; i = end) {
+        const struct access * const group = &reduction->accesses[i];
+
+        for (end = i + 1; end < reduction->accesses_size; ++end) {
+            const struct access * const access = &reduction->accesses[end];
+
+            if (access->induction != group->induction || access->base != group->base) {
+                break;
+            }
+        }
+
+        if (end - i >= 2 || reduction->inductions[group->induction].addressing_only) {
+            reduce_group(reduction, group, end - i);
+        }
+    }
+
+    const bool result = reduction->preheader_size > 0;
+
+    if (result) {
+        insert_preheader(reduction);
+    }
+
+    return result;
+}
+
+bool flow_graph_optimize_reduce_strength(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0) {
+        return false;
+    }
+
+    struct flow_graph_dominators dominators = flow_graph_dominators_build(subroutine);
+    struct flow_graph_loops loops = flow_graph_loops_find(subroutine, &dominators);
+
+    if (loops.size == 0) {
+        flow_graph_loops_fini(&loops);
+        flow_graph_dominators_fini(&dominators);
+        return false;
+    }
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    struct flow_graph_dataflow_result liveness = flow_graph_liveness_build(subroutine);
+
+    const size_t nodes_size = nodes->size;
+    const size_t locals_size = subroutine->locals.size;
+
+    struct reduction reduction = {
+        .subroutine = subroutine,
+        .predecessors = &predecessors,
+        .liveness = &liveness,
+        .nodes_size = nodes_size,
+        .locals_size = locals_size,
+        .marks = mallocs(sizeof(size_t) * nodes_size),
+        .locals = mallocs(sizeof(struct local_info) * (locals_size ? locals_size : 1)),
+        .stack = stack_init(),
+    };
+
+    memset(reduction.marks, 0, sizeof(size_t) * nodes_size);
+    memset(reduction.locals, 0, sizeof(struct local_info) * locals_size);
+
+    bool result = false;
+
+    // вложенные циклы обходятся раньше объемлющих: сдвиги указателей, которые проход вставляет в тело,
+    // тогда не оказываются среди предшественников заголовков ещё не пройденных циклов
+    for (size_t i = loops.size; i > 0; --i) {
+        reduction.loop = &loops.values[i - 1];
+        reduction.stamp = i;
+
+        result = reduce_loop(&reduction) || result;
+    }
+
+    stack_fini(&reduction.stack);
+    free(reduction.preheader);
+    free(reduction.accesses);
+    free(reduction.inductions);
+    free(reduction.locals);
+    free(reduction.marks);
+
+    flow_graph_dataflow_result_fini(&liveness);
+    flow_graph_predecessors_fini(&predecessors);
+    flow_graph_loops_fini(&loops);
+    flow_graph_dominators_fini(&dominators);
+
+    if (result) {
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    return result;
+}
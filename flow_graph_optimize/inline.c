@@ -0,0 +1,701 @@
+#include "passes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flow_graph/call_graph.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// размер подпрограммы — число вершин и выражений в них; такие маленькие подпрограммы встраиваются
+// в каждый вызов: вызов с передачей аргументов и кадром стека стоит примерно столько же
+#define INLINE_SIZE_SMALL 16
+
+// подпрограмма с единственным вызовом встраивается, если не больше этого: копия заменяет оригинал
+#define INLINE_SIZE_SINGLE 256
+
+// предел размера подпрограммы, в которую встраиваются вызовы
+#define INLINE_CALLER_SIZE_MAX 2048
+
+// оригиналы встроенных подпрограмм остаются, поэтому рост всей программы ограничен долей её размера,
+// но не меньше минимума, чтобы маленькие программы встраивались полностью
+#define INLINE_UNIT_GROWTH_PERCENT 50
+#define INLINE_UNIT_GROWTH_MIN 1024
+
+// с такого числа сравнений кодогенерация заменяет цепочку таблицей, см. codegen/switch.c
+#define INLINE_VALUE_TABLE_CASES_MIN 5
+
+struct callee_info {
+
+    size_t size;
+
+    // число вызовов во всех подпрограммах
+    size_t calls;
+
+    // входит в цикл графа вызовов
+    bool recursive;
+
+    // тело — только цепочка сравнений с литералами, ветки которой возвращают литералы, см. is_value_table
+    bool value_table;
+};
+
+// выражения корня вершины в порядке окончания вычисления, см. collect_order
+struct slots {
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_expr ** * values;
+};
+
+struct inlining {
+
+    const struct flow_graph_subroutine_list * subroutines;
+
+    struct flow_graph_call_graph graph;
+    struct callee_info * infos;
+
+    // сколько ещё может вырасти программа
+    size_t growth;
+
+    struct stack stack;
+    struct stack calls;
+    struct slots order;
+
+    // отображения вершин и переменных встраиваемой подпрограммы в копии
+    struct flow_graph_node ** node_clones;
+    struct flow_graph_local ** local_clones;
+};
+
+static void slots_append(struct slots * slots, struct flow_graph_expr ** value) {
+    if (slots->size >= slots->capacity) {
+        slots->capacity = slots->capacity ? slots->capacity * 2 : 16;
+        slots->values = reallocs(slots->values, sizeof(struct flow_graph_expr **) * slots->capacity);
+    }
+
+    slots->values[slots->size++] = value;
+}
+
+static struct callee_info * get_info(const struct inlining * inlining, const struct flow_graph_subroutine * subroutine) {
+    return &inlining->infos[flow_graph_call_graph_get_position(&inlining->graph, subroutine)];
+}
+
+static bool is_defined(const struct flow_graph_subroutine * subroutine) {
+    return subroutine->defined && subroutine->nodes.size > 0;
+}
+
+// число выражений в дереве; если calls задан, в него дописываются вызовы
+static size_t count_exprs(struct stack * stack, struct flow_graph_expr * root, struct stack * calls) {
+    size_t result = 0;
+
+    stack_push(stack, root);
+
+    while (stack->size > 0) {
+        struct flow_graph_expr * const expr = stack_pop(stack);
+        ++result;
+
+        if (calls && expr->_type == FLOW_GRAPH_EXPR_TYPE_CALL) {
+            stack_push(calls, expr);
+        }
+
+        flow_graph_expr_push_children(stack, expr);
+    }
+
+    return result;
+}
+
+static size_t count_subroutine(struct stack * stack, const struct flow_graph_subroutine * subroutine, struct stack * calls) {
+    size_t result = subroutine->nodes.size;
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(subroutine->nodes.values[i]);
+
+        if (expr) {
+            result += count_exprs(stack, expr, calls);
+        }
+    }
+
+    return result;
+}
+
+static bool is_int_literal(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL && expr->literal.literal->_type == FLOW_GRAPH_LITERAL_TYPE_INT;
+}
+
+// подпрограмма только сравнивает одну переменную с целыми литералами и возвращает литерал: кодогенерация
+// вычисляет такую цепочку одним чтением из таблицы значений, а встроенная копия теряет возврат, и таблица
+// уже не строится, поэтому вызов обходится дешевле копии
+static bool is_value_table(const struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_local * local = NULL;
+    size_t cases = 0;
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        const struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        // пустые вершины только передают управление дальше
+        if (node->_type == FLOW_GRAPH_NODE_TYPE_EXPR) {
+            const struct flow_graph_expr * const expr = node->expr.expr;
+
+            if (expr ? node->expr.next || expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL : !node->expr.next) {
+                return false;
+            }
+
+            continue;
+        }
+
+        const struct flow_graph_expr * const cond = node->cond.cond;
+
+        if (cond->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || cond->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_EQ) {
+            return false;
+        }
+
+        const struct flow_graph_expr * variable = cond->binary.lhs;
+        const struct flow_graph_expr * literal = cond->binary.rhs;
+
+        if (is_int_literal(variable)) {
+            variable = cond->binary.rhs;
+            literal = cond->binary.lhs;
+        }
+
+        if (variable->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL || !is_int_literal(literal)
+            || (local && variable->local.local != local)) {
+            return false;
+        }
+
+        local = variable->local.local;
+        ++cases;
+    }
+
+    return cases >= INLINE_VALUE_TABLE_CASES_MIN;
+}
+
+// размеры подпрограмм и число вызовов каждой; рекурсивные подпрограммы берутся из графа вызовов
+static void collect_infos(struct inlining * inlining) {
+    const struct flow_graph_subroutine_list * const subroutines = inlining->subroutines;
+    struct stack * const calls = &inlining->calls;
+
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        const struct flow_graph_subroutine * const subroutine = subroutines->values[i];
+        inlining->infos[i].recursive = inlining->graph.recursive[i];
+
+        if (!is_defined(subroutine)) {
+            continue;
+        }
+
+        inlining->infos[i].size = count_subroutine(&inlining->stack, subroutine, calls);
+        inlining->infos[i].value_table = is_value_table(subroutine);
+
+        while (calls->size > 0) {
+            const struct flow_graph_expr * const call = stack_pop(calls);
+            ++get_info(inlining, call->call.subroutine)->calls;
+        }
+    }
+}
+
+static bool is_assignment(const struct flow_graph_expr * expr) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT;
+}
+
+// без побочных эффектов, исключений и чтения памяти: такое выражение можно вычислить после вызова
+static bool is_movable(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            return !is_assignment(expr)
+                   && expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE
+                   && expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            return true;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            return false;
+    }
+
+    return false;
+}
+
+// отметка в стеке обхода: следующий элемент уже раскрыт и записывается в порядок
+static char emit_marker;
+
+static void push_emit(struct stack * stack, struct flow_graph_expr ** slot) {
+    stack_push(stack, slot);
+    stack_push(stack, &emit_marker);
+}
+
+// места выражений корня в порядке окончания их вычисления, как в кодогенерации: поддерево выражения
+// занимает отрезок, который заканчивается им самим; адрес элемента при записи в массив с одним
+// индексом вычисляется до правой части, но сама запись идёт после неё
+static void collect_order(struct inlining * inlining, struct flow_graph_expr ** root) {
+    struct stack * const stack = &inlining->stack;
+
+    inlining->order.size = 0;
+    stack_push(stack, root);
+
+    while (stack->size > 0) {
+        void * const top = stack_pop(stack);
+
+        if (top == &emit_marker) {
+            slots_append(&inlining->order, stack_pop(stack));
+            continue;
+        }
+
+        struct flow_graph_expr ** const slot = top;
+        struct flow_graph_expr * const expr = *slot;
+
+        push_emit(stack, slot);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+                struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    stack_push(stack, &expr->binary.rhs);
+                    stack_push(stack, &expr->binary.lhs);
+                } else if (lhs->_type != FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+                    push_emit(stack, &expr->binary.lhs);
+                    stack_push(stack, &expr->binary.rhs);
+                } else {
+                    // промежуточные строки многомерного массива читаются до правой части
+                    if (lhs->indexer.indices.size == 1) {
+                        push_emit(stack, &expr->binary.lhs);
+                        stack_push(stack, &expr->binary.rhs);
+                    } else {
+                        stack_push(stack, &expr->binary.rhs);
+                        push_emit(stack, &expr->binary.lhs);
+                    }
+
+                    for (size_t i = lhs->indexer.indices.size; i > 0; --i) {
+                        stack_push(stack, &lhs->indexer.indices.values[i - 1]);
+                    }
+
+                    stack_push(stack, &lhs->indexer.value);
+                }
+
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(stack, &expr->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                for (size_t i = expr->call.args.size; i > 0; --i) {
+                    stack_push(stack, &expr->call.args.values[i - 1]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                for (size_t i = expr->indexer.indices.size; i > 0; --i) {
+                    stack_push(stack, &expr->indexer.indices.values[i - 1]);
+                }
+
+                stack_push(stack, &expr->indexer.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+}
+
+// стоит ли встраивать вызов: подпрограмма не рекурсивна, не таблица значений, мала или вызывается
+// один раз, а вызывающая не вырастает сверх предела
+static bool should_inline(
+        const struct inlining * inlining,
+        const struct flow_graph_subroutine * caller,
+        const struct flow_graph_subroutine * callee
+) {
+    if (callee == caller || !is_defined(callee)) {
+        return false;
+    }
+
+    const struct callee_info * const info = get_info(inlining, callee);
+
+    if (info->recursive
+        || info->value_table
+        || info->size > inlining->growth
+        || get_info(inlining, caller)->size + info->size > INLINE_CALLER_SIZE_MAX) {
+        return false;
+    }
+
+    return info->size <= INLINE_SIZE_SMALL || (info->calls == 1 && info->size <= INLINE_SIZE_SINGLE);
+}
+
+// первый вызов корня вершины, если его можно встроить: всё, что вычисляется до него, кроме аргументов,
+// можно перенести за вызов, а аргументы не присваивают; возвращает место вызова или NULL
+static struct flow_graph_expr ** find_call(
+        struct inlining * inlining,
+        const struct flow_graph_subroutine * caller,
+        struct flow_graph_expr ** root
+) {
+    collect_order(inlining, root);
+
+    const struct slots * const order = &inlining->order;
+
+    for (size_t i = 0; i < order->size; ++i) {
+        struct flow_graph_expr * const expr = *order->values[i];
+
+        if (expr->_type != FLOW_GRAPH_EXPR_TYPE_CALL) {
+            continue;
+        }
+
+        if (!should_inline(inlining, caller, expr->call.subroutine)) {
+            return NULL;
+        }
+
+        const size_t args_begin = i + 1 - count_exprs(&inlining->stack, expr, NULL);
+
+        for (size_t k = 0; k < args_begin; ++k) {
+            if (!is_movable(*order->values[k])) {
+                return NULL;
+            }
+        }
+
+        for (size_t k = args_begin; k < i; ++k) {
+            if (is_assignment(*order->values[k])) {
+                return NULL;
+            }
+        }
+
+        return order->values[i];
+    }
+
+    return NULL;
+}
+
+static struct flow_graph_expr * new_assignment(struct position position, struct flow_graph_local * local, struct flow_graph_expr * value) {
+    struct flow_graph_expr * const expr = flow_graph_expr_new_binary(
+            position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_typed_local(position, local),
+            value
+    );
+
+    expr->type = ast_type_reference_clone(local->type);
+    return expr;
+}
+
+// копия переменной вызываемой подпрограммы называется по ней через точку, как временные переменные,
+// см. flow_graph_subroutine_add_temp
+static struct flow_graph_local * new_local_clone(
+        struct flow_graph_subroutine * caller,
+        const struct flow_graph_subroutine * callee,
+        const char * id,
+        struct ast_type_reference * type,
+        struct position position
+) {
+    char * const result_id = mallocs(strlen(callee->id) + strlen(id) + 24);
+    sprintf(result_id, "%s.%s.%zu", callee->id, id, caller->locals.size + 1);
+
+    return flow_graph_subroutine_add_local(caller, flow_graph_local_new(result_id, ast_type_reference_clone(type), position));
+}
+
+static void remap_local(struct flow_graph_expr * expr, bool write, void * context) {
+    (void) write;
+
+    struct flow_graph_local ** const local_clones = context;
+    expr->local.local = local_clones[expr->local.local->index - 1];
+}
+
+static struct flow_graph_node * clone_node(struct inlining * inlining, const struct flow_graph_node * node) {
+    struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+    struct flow_graph_expr * const clone = expr ? flow_graph_expr_clone(expr) : NULL;
+
+    if (clone) {
+        flow_graph_expr_visit_locals(clone, remap_local, inlining->local_clones);
+    }
+
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            return flow_graph_node_new_expr(node->position, clone);
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            return flow_graph_node_new_cond(node->position, clone);
+    }
+
+    return NULL;
+}
+
+// куда ведёт выход копии: в continuation, а если результат нужен — через запись нуля в result
+struct exit_context {
+
+    struct flow_graph_subroutine * caller;
+    const struct flow_graph_subroutine * callee;
+
+    struct flow_graph_local * result;
+    struct flow_graph_node * continuation;
+
+    // общая для всех выходов без значения вершина result = 0, создаётся при первой надобности
+    struct flow_graph_node * zero;
+};
+
+static struct flow_graph_node * map_successor(
+        struct inlining * inlining,
+        struct exit_context * exit,
+        struct flow_graph_node * successor
+) {
+    if (successor) {
+        return inlining->node_clones[successor->index - 1];
+    }
+
+    if (!exit->result) {
+        return exit->continuation;
+    }
+
+    if (!exit->zero) {
+        const struct position position = exit->callee->position;
+
+        // результат подпрограммы, которая закончилась без значения
+        struct flow_graph_expr * const zero =
+                flow_graph_expr_new_typed_int(position, ast_type_reference_clone(exit->callee->return_type), 0);
+
+        exit->zero = flow_graph_node_new_expr(position, new_assignment(position, exit->result, zero));
+        exit->zero->expr.next = exit->continuation;
+
+        flow_graph_node_list_append(&exit->caller->nodes, exit->zero);
+    }
+
+    return exit->zero;
+}
+
+// копия вершин и переменных подпрограммы, в которую передаются аргументы вызова; вершина выхода
+// со значением присваивает его result, если он задан; возвращает первую вершину копии
+static struct flow_graph_node * copy_callee(
+        struct inlining * inlining,
+        struct exit_context * exit,
+        struct flow_graph_expr * call
+) {
+    struct flow_graph_subroutine * const caller = exit->caller;
+    const struct flow_graph_subroutine * const callee = exit->callee;
+
+    // копии параметров идут первыми среди копий переменных
+    const size_t first_local = caller->locals.size;
+
+    inlining->node_clones = mallocs(sizeof(struct flow_graph_node *) * callee->nodes.size);
+    inlining->local_clones = mallocs(sizeof(struct flow_graph_local *) * (callee->locals.size ? callee->locals.size : 1));
+
+    for (size_t i = 0; i < callee->locals.size; ++i) {
+        const struct flow_graph_local * const local = callee->locals.values[i];
+        inlining->local_clones[i] = new_local_clone(caller, callee, local->id, local->type, local->position);
+    }
+
+    for (size_t i = 0; i < callee->nodes.size; ++i) {
+        struct flow_graph_node * const clone = clone_node(inlining, callee->nodes.values[i]);
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(clone);
+
+        inlining->node_clones[i] = clone;
+        flow_graph_node_list_append(&caller->nodes, clone);
+
+        // вызовы в копии — новые вызовы своих подпрограмм
+        if (expr) {
+            count_exprs(&inlining->stack, expr, &inlining->calls);
+        }
+
+        while (inlining->calls.size > 0) {
+            const struct flow_graph_expr * const copied_call = stack_pop(&inlining->calls);
+            ++get_info(inlining, copied_call->call.subroutine)->calls;
+        }
+    }
+
+    for (size_t i = 0; i < callee->nodes.size; ++i) {
+        const struct flow_graph_node * const node = callee->nodes.values[i];
+        struct flow_graph_node * const clone = inlining->node_clones[i];
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                if (!node->expr.next && clone->expr.expr && exit->result) {
+                    clone->expr.expr = new_assignment(clone->position, exit->result, clone->expr.expr);
+                    clone->expr.next = exit->continuation;
+                } else {
+                    clone->expr.next = map_successor(inlining, exit, node->expr.next);
+                }
+
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                clone->cond.then_next = map_successor(inlining, exit, node->cond.then_next);
+                clone->cond.else_next = map_successor(inlining, exit, node->cond.else_next);
+                break;
+        }
+    }
+
+    // аргументы вычисляются по порядку и записываются в копии параметров, как при вызове
+    struct flow_graph_node * next = inlining->node_clones[0];
+
+    free(inlining->local_clones);
+    free(inlining->node_clones);
+
+    for (size_t i = callee->args_num; i > 0; --i) {
+        struct flow_graph_node * const node = flow_graph_node_new_expr(
+                call->position,
+                new_assignment(call->position, caller->locals.values[first_local + i - 1], call->call.args.values[i - 1])
+        );
+
+        node->expr.next = next;
+        next = node;
+
+        flow_graph_node_list_append(&caller->nodes, node);
+    }
+
+    call->call.args.size = 0;
+    return next;
+}
+
+// встраивание вызова из корня вершины; вызов в корне или в правой части присваивания переменной
+// того же типа заменяется копией на месте, иначе результат идёт через временную переменную, а
+// вершина делится: её содержимое переносится в новую вершину после копии
+static bool inline_call(
+        struct inlining * inlining,
+        struct flow_graph_subroutine * caller,
+        struct flow_graph_node * node,
+        struct flow_graph_expr ** slot
+) {
+    struct flow_graph_expr * const call = *slot;
+    struct flow_graph_expr * const root = flow_graph_node_get_expr(node);
+
+    struct exit_context exit = {
+        .caller = caller,
+        .callee = call->call.subroutine,
+    };
+
+    const bool statement = node->_type == FLOW_GRAPH_NODE_TYPE_EXPR && node->expr.next;
+
+    if (statement && root == call) {
+        exit.continuation = node->expr.next;
+        node->expr.expr = NULL;
+    } else if (statement
+               && root->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+               && root->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+               && root->binary.rhs == call
+               && root->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL
+               && ast_type_reference_equals(root->binary.lhs->local.local->type, exit.callee->return_type)) {
+        exit.result = root->binary.lhs->local.local;
+        exit.continuation = node->expr.next;
+
+        root->binary.rhs = NULL;
+        flow_graph_expr_delete(root);
+        node->expr.expr = NULL;
+    } else {
+        // значения bool во временных переменных кодогенерация не поддерживает
+        if (exit.callee->return_type->_type == AST_TYPE_REFERENCE_TYPE_BUILTIN
+            && exit.callee->return_type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_BOOL) {
+            return false;
+        }
+
+        exit.result = new_local_clone(caller, exit.callee, "result", exit.callee->return_type, call->position);
+        *slot = flow_graph_expr_new_typed_local(call->position, exit.result);
+
+        struct flow_graph_node * const rest = node->_type == FLOW_GRAPH_NODE_TYPE_EXPR
+                ? flow_graph_node_new_expr(node->position, node->expr.expr)
+                : flow_graph_node_new_cond(node->position, node->cond.cond);
+
+        if (node->_type == FLOW_GRAPH_NODE_TYPE_EXPR) {
+            rest->expr.next = node->expr.next;
+        } else {
+            rest->cond.then_next = node->cond.then_next;
+            rest->cond.else_next = node->cond.else_next;
+        }
+
+        flow_graph_node_list_append(&caller->nodes, rest);
+
+        node->_type = FLOW_GRAPH_NODE_TYPE_EXPR;
+        node->expr.expr = NULL;
+        exit.continuation = rest;
+    }
+
+    node->expr.next = copy_callee(inlining, &exit, call);
+
+    struct callee_info * const info = get_info(inlining, exit.callee);
+
+    get_info(inlining, caller)->size += info->size;
+    inlining->growth -= info->size;
+    --info->calls;
+
+    flow_graph_expr_delete(call);
+    return true;
+}
+
+static bool inline_calls(struct inlining * inlining, struct flow_graph_subroutine * caller) {
+    bool changed = false;
+
+    // новые вершины дописываются в конец и тоже просматриваются: в их корнях могут остаться вызовы
+    for (size_t i = 0; i < caller->nodes.size; ++i) {
+        struct flow_graph_node * const node = caller->nodes.values[i];
+
+        struct flow_graph_expr ** const root = node->_type == FLOW_GRAPH_NODE_TYPE_EXPR
+                ? &node->expr.expr
+                : &node->cond.cond;
+
+        if (!*root) {
+            continue;
+        }
+
+        struct flow_graph_expr ** const slot = find_call(inlining, caller, root);
+
+        if (slot && inline_call(inlining, caller, node, slot)) {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool flow_graph_optimize_inline_calls(struct flow_graph_subroutine_list * subroutines) {
+    const size_t size = subroutines->size;
+
+    struct inlining inlining = {
+        .subroutines = subroutines,
+        .graph = flow_graph_call_graph_build(subroutines),
+        .infos = mallocs(sizeof(struct callee_info) * (size ? size : 1)),
+        .stack = stack_init(),
+        .calls = stack_init(),
+    };
+
+    for (size_t i = 0; i < size; ++i) {
+        inlining.infos[i] = (struct callee_info) { 0 };
+    }
+
+    collect_infos(&inlining);
+    size_t total = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        total += inlining.infos[i].size;
+    }
+
+    inlining.growth = total * INLINE_UNIT_GROWTH_PERCENT / 100;
+
+    if (inlining.growth < INLINE_UNIT_GROWTH_MIN) {
+        inlining.growth = INLINE_UNIT_GROWTH_MIN;
+    }
+
+    const size_t * const order = inlining.graph.order;
+    bool changed = false;
+
+    for (size_t i = 0; i < size; ++i) {
+        struct flow_graph_subroutine * const caller = subroutines->values[order[i]];
+
+        if (!is_defined(caller)) {
+            continue;
+        }
+
+        // подпрограммы обрабатываются после всех вызываемых ими, поэтому встраиваются уже в готовом виде
+        if (inline_calls(&inlining, caller)) {
+            flow_graph_subroutine_renumber(caller);
+            changed = true;
+        }
+    }
+
+    free(inlining.order.values);
+    stack_fini(&inlining.calls);
+    stack_fini(&inlining.stack);
+    free(inlining.infos);
+    flow_graph_call_graph_fini(&inlining.graph);
+
+    return changed;
+}
@@ -0,0 +1,122 @@
+#include "liveness.h"
+
+#include "utils/mallocs.h"
+
+
+// переменные, читаемые вершиной до записи, и переменные, в которые она пишет, по номеру вершины - 1;
+// для сильной живости targets хранит номер переменной, запись в которую можно выбросить, или 0
+struct liveness_context {
+
+    struct bitset * uses;
+    struct bitset * defs;
+    size_t * targets;
+};
+
+// вершина-оператор, которая только записывает в переменную значение без побочных эффектов
+static size_t get_target(const struct flow_graph_node * node) {
+    if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || !node->expr.expr || !node->expr.next || node->phis.size > 0) {
+        return 0;
+    }
+
+    const struct flow_graph_expr * const expr = node->expr.expr;
+
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+            || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+            || expr->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL
+            || !flow_graph_expr_is_pure(expr->binary.rhs)) {
+        return 0;
+    }
+
+    return expr->binary.lhs->local.local->index;
+}
+
+// фи-функции пишут в цели до выражения вершины, а их аргументы считаются прочитанными в ней самой;
+// так аргумент живой на выходе из всех предшественников, а не только из своего, что лишь осторожнее
+static void add_phis(const struct flow_graph_node * node, struct bitset * uses, struct bitset * defs) {
+    for (size_t i = 0; i < node->phis.size; ++i) {
+        const size_t target = node->phis.values[i]->target->index - 1;
+
+        bitset_reset(uses, target);
+        bitset_set(defs, target);
+    }
+
+    for (size_t i = 0; i < node->phis.size; ++i) {
+        const struct flow_graph_phi * const phi = node->phis.values[i];
+
+        for (size_t j = 0; j < phi->size; ++j) {
+            bitset_set(uses, phi->args[j].value->index - 1);
+        }
+    }
+}
+
+// in = uses ∪ (out \ defs); выбрасываемая запись в мёртвую переменную ничего не читает
+static void transfer(const struct flow_graph_node * node, const struct bitset * input, struct bitset * output, void * context) {
+    const struct liveness_context * const liveness = context;
+    const size_t i = node->index - 1;
+    const size_t target = liveness->targets[i];
+
+    bitset_copy(output, input);
+
+    if (target && !bitset_test(input, target - 1)) {
+        return;
+    }
+
+    bitset_subtract(output, &liveness->defs[i]);
+    bitset_union(output, &liveness->uses[i]);
+}
+
+static struct flow_graph_dataflow_result liveness_build(const struct flow_graph_subroutine * subroutine, bool strong) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t bits = subroutine->locals.size;
+
+    struct liveness_context context = {
+        .uses = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+        .defs = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+        .targets = mallocs(sizeof(size_t) * (nodes->size ? nodes->size : 1)),
+    };
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        context.uses[i] = bitset_init(bits);
+        context.defs[i] = bitset_init(bits);
+        context.targets[i] = strong ? get_target(nodes->values[i]) : 0;
+
+        const struct flow_graph_expr * const expr = flow_graph_node_get_expr(nodes->values[i]);
+
+        if (expr) {
+            flow_graph_dataflow_accesses(expr, &context.uses[i], &context.defs[i]);
+        }
+
+        add_phis(nodes->values[i], &context.uses[i], &context.defs[i]);
+    }
+
+    // после выхода из подпрограммы локальные переменные не читаются
+    const struct flow_graph_dataflow_problem problem = {
+        .direction = FLOW_GRAPH_DATAFLOW_DIRECTION_BACKWARD,
+        .meet = FLOW_GRAPH_DATAFLOW_MEET_UNION,
+        .bits = bits,
+        .boundary = NULL,
+        .transfer = transfer,
+        .context = &context,
+    };
+
+    struct flow_graph_dataflow_result result = flow_graph_dataflow_solve(subroutine, &problem);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        bitset_fini(&context.uses[i]);
+        bitset_fini(&context.defs[i]);
+    }
+
+    free(context.targets);
+    free(context.uses);
+    free(context.defs);
+
+    return result;
+}
+
+struct flow_graph_dataflow_result flow_graph_liveness_build(const struct flow_graph_subroutine * subroutine) {
+    return liveness_build(subroutine, false);
+}
+
+struct flow_graph_dataflow_result flow_graph_liveness_build_strong(const struct flow_graph_subroutine * subroutine) {
+    return liveness_build(subroutine, true);
+}
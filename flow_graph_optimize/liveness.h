@@ -0,0 +1,13 @@
+#pragma once
+
+#include "dataflow.h"
+
+
+// живые локальные переменные перед каждой вершиной и после неё: значение переменной ещё может быть прочитано;
+// бит переменной — её номер - 1; в SSA-форме учитываются фи-функции
+struct flow_graph_dataflow_result flow_graph_liveness_build(const struct flow_graph_subroutine * subroutine);
+
+// сильная живость: чтения в правой части присваивания без побочных эффектов учитываются, только если
+// переменная, в которую оно пишет, живая; так мёртвыми оказываются и переменные, которые читают
+// только сами себя, например счётчик, который увеличивается в цикле, но нигде не используется
+struct flow_graph_dataflow_result flow_graph_liveness_build_strong(const struct flow_graph_subroutine * subroutine);
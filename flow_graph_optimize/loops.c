@@ -0,0 +1,240 @@
+#include "loops.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// пока массив вершин растёт, циклы хранят смещения в нём, указатели расставляются в конце
+struct loop_offsets {
+
+    struct flow_graph_node * header;
+
+    size_t body_offset;
+    size_t body_size;
+
+    size_t latches_offset;
+    size_t latches_size;
+};
+
+struct nodes {
+
+    size_t size;
+    size_t capacity;
+    struct flow_graph_node ** values;
+};
+
+static void nodes_append(struct nodes * nodes, struct flow_graph_node * value) {
+    if (nodes->size >= nodes->capacity) {
+        nodes->capacity = nodes->capacity ? nodes->capacity * 2 : 16;
+        nodes->values = reallocs(nodes->values, sizeof(struct flow_graph_node *) * nodes->capacity);
+    }
+
+    nodes->values[nodes->size++] = value;
+}
+
+static int compare_nodes(const void * lhs, const void * rhs) {
+    const struct flow_graph_node * const lhs_node = *(struct flow_graph_node * const *) lhs;
+    const struct flow_graph_node * const rhs_node = *(struct flow_graph_node * const *) rhs;
+
+    return lhs_node->index < rhs_node->index ? -1 : lhs_node->index > rhs_node->index;
+}
+
+// тело — заголовок и вершины, из которых концы обратных дуг достижимы, не проходя через заголовок;
+// marks отмечает вершины тела номером цикла + 1, поэтому между циклами его не нужно очищать
+static void collect_body(
+        const struct flow_graph_predecessors * predecessors,
+        struct loop_offsets * loop,
+        size_t mark,
+        size_t * marks,
+        struct nodes * nodes
+) {
+    struct stack stack = stack_init();
+
+    loop->body_offset = nodes->size;
+    nodes_append(nodes, loop->header);
+    marks[loop->header->index - 1] = mark;
+
+    for (size_t i = 0; i < loop->latches_size; ++i) {
+        struct flow_graph_node * const latch = nodes->values[loop->latches_offset + i];
+
+        if (marks[latch->index - 1] != mark) {
+            marks[latch->index - 1] = mark;
+            stack_push(&stack, latch);
+        }
+    }
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&stack);
+        const size_t i = node->index - 1;
+
+        nodes_append(nodes, node);
+
+        for (size_t k = predecessors->offsets[i]; k < predecessors->offsets[i + 1]; ++k) {
+            struct flow_graph_node * const predecessor = predecessors->values[k];
+
+            if (marks[predecessor->index - 1] != mark) {
+                marks[predecessor->index - 1] = mark;
+                stack_push(&stack, predecessor);
+            }
+        }
+    }
+
+    loop->body_size = nodes->size - loop->body_offset;
+    stack_fini(&stack);
+
+    qsort(&nodes->values[loop->body_offset], loop->body_size, sizeof(struct flow_graph_node *), compare_nodes);
+}
+
+static int compare_loops(const void * lhs, const void * rhs) {
+    const struct flow_graph_loop * const lhs_loop = lhs;
+    const struct flow_graph_loop * const rhs_loop = rhs;
+
+    if (lhs_loop->body_size != rhs_loop->body_size) {
+        return lhs_loop->body_size > rhs_loop->body_size ? -1 : 1;
+    }
+
+    return lhs_loop->header->index < rhs_loop->header->index ? -1 : 1;
+}
+
+struct flow_graph_loops flow_graph_loops_find(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_dominators * dominators
+) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+
+    size_t * const marks = mallocs(sizeof(size_t) * (nodes->size ? nodes->size : 1));
+    memset(marks, 0, sizeof(size_t) * nodes->size);
+
+    struct nodes loop_nodes = { 0 };
+
+    size_t loops_size = 0;
+    size_t loops_capacity = 0;
+    struct loop_offsets * loops = NULL;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const header = nodes->values[i];
+        const size_t latches_offset = loop_nodes.size;
+
+        for (size_t k = predecessors.offsets[i]; k < predecessors.offsets[i + 1]; ++k) {
+            struct flow_graph_node * const predecessor = predecessors.values[k];
+
+            // условие, обе ветки которого ведут в заголовок, встречается среди предшественников дважды
+            const bool repeated = loop_nodes.size > latches_offset
+                                  && loop_nodes.values[loop_nodes.size - 1] == predecessor;
+
+            if (!repeated && flow_graph_dominators_dominates(dominators, header, predecessor)) {
+                nodes_append(&loop_nodes, predecessor);
+            }
+        }
+
+        if (loop_nodes.size == latches_offset) {
+            continue;
+        }
+
+        if (loops_size >= loops_capacity) {
+            loops_capacity = loops_capacity ? loops_capacity * 2 : 4;
+            loops = reallocs(loops, sizeof(struct loop_offsets) * loops_capacity);
+        }
+
+        struct loop_offsets * const loop = &loops[loops_size++];
+
+        loop->header = header;
+        loop->latches_offset = latches_offset;
+        loop->latches_size = loop_nodes.size - latches_offset;
+
+        collect_body(&predecessors, loop, loops_size, marks, &loop_nodes);
+    }
+
+    struct flow_graph_loops result = {
+        .size = loops_size,
+        .values = mallocs(sizeof(struct flow_graph_loop) * (loops_size ? loops_size : 1)),
+        .nodes = loop_nodes.values,
+    };
+
+    for (size_t i = 0; i < loops_size; ++i) {
+        result.values[i] = (struct flow_graph_loop) {
+            .header = loops[i].header,
+            .body_size = loops[i].body_size,
+            .body = &loop_nodes.values[loops[i].body_offset],
+            .latches_size = loops[i].latches_size,
+            .latches = &loop_nodes.values[loops[i].latches_offset],
+        };
+    }
+
+    qsort(result.values, result.size, sizeof(struct flow_graph_loop), compare_loops);
+
+    free(loops);
+    free(marks);
+    flow_graph_predecessors_fini(&predecessors);
+
+    return result;
+}
+
+void flow_graph_loops_fini(struct flow_graph_loops * loops) {
+    free(loops->values);
+    free(loops->nodes);
+    *loops = (struct flow_graph_loops) { 0 };
+}
+
+static void redirect_edge(struct flow_graph_node * predecessor, struct flow_graph_node * from, struct flow_graph_node * to) {
+    switch (predecessor->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            predecessor->expr.next = to;
+            break;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            if (predecessor->cond.then_next == from) {
+                predecessor->cond.then_next = to;
+            } else {
+                predecessor->cond.else_next = to;
+            }
+
+            break;
+    }
+}
+
+static bool is_latch(const struct flow_graph_loop * loop, const struct flow_graph_node * node) {
+    for (size_t i = 0; i < loop->latches_size; ++i) {
+        if (loop->latches[i] == node) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void flow_graph_loop_insert_preheader(
+        struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_loop * loop,
+        const struct flow_graph_predecessors * predecessors,
+        struct flow_graph_node * entry
+) {
+    struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    struct flow_graph_node * const header = loop->header;
+    const size_t i = header->index - 1;
+
+    for (size_t k = predecessors->offsets[i]; k < predecessors->offsets[i + 1]; ++k) {
+        struct flow_graph_node * const predecessor = predecessors->values[k];
+
+        if (!is_latch(loop, predecessor)) {
+            redirect_edge(predecessor, header, entry);
+        }
+    }
+
+    // новые вершины добавляются в конец списка, поэтому entry ищется с конца
+    if (nodes->values[0] == header) {
+        for (size_t k = nodes->size; k > 1; --k) {
+            if (nodes->values[k - 1] == entry) {
+                nodes->values[k - 1] = header;
+                nodes->values[0] = entry;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "dominators.h"
+#include "flow_graph.h"
+#include "flow_graph/predecessors.h"
+
+
+// естественный цикл: заголовок доминирует над концами обратных дуг — вершинами тела, из которых
+// есть переход в заголовок; циклы с общим заголовком объединены в один
+struct flow_graph_loop {
+
+    struct flow_graph_node * header;
+
+    // вершины тела в порядке номеров; при нумерации обходом в глубину заголовок идёт первым,
+    // а вершины — в порядке выполнения, если не считать обратных дуг
+    size_t body_size;
+    struct flow_graph_node ** body;
+
+    // концы обратных дуг
+    size_t latches_size;
+    struct flow_graph_node ** latches;
+};
+
+// циклы в порядке невозрастания размера тела, поэтому объемлющий цикл идёт раньше вложенных
+struct flow_graph_loops {
+
+    size_t size;
+    struct flow_graph_loop * values;
+
+    // общий массив, в который указывают body и latches
+    struct flow_graph_node ** nodes;
+};
+
+// вершины должны быть пронумерованы по порядку, см. flow_graph_subroutine_renumber
+struct flow_graph_loops flow_graph_loops_find(
+        const struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_dominators * dominators
+);
+void flow_graph_loops_fini(struct flow_graph_loops * loops);
+
+// уводит в entry все входы в заголовок снаружи цикла — переходы не с концов обратных дуг, по
+// предшественникам, найденным до изменения графа; если заголовок — вход подпрограммы, entry
+// занимает его место в списке вершин
+void flow_graph_loop_insert_preheader(
+        struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_loop * loop,
+        const struct flow_graph_predecessors * predecessors,
+        struct flow_graph_node * entry
+);
@@ -0,0 +1,670 @@
+#include "passes.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "dominators.h"
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// приблизительные длины кода в командах: чтение переменной и то, что добавляется к первому вычислению,
+// когда его значение сохраняется во временную переменную и перечитывается
+#define LOCAL_READ_COST 4
+#define SAVE_COST 8
+
+#define NO_VALUE SIZE_MAX
+
+// значение выражения без побочных эффектов: вид, операция, тип и номера значений операндов;
+// чтение элемента массива зависит ещё и от состояния памяти, оно меняется вызовами и записями в массивы
+struct value {
+
+    enum flow_graph_expr_type kind;
+    int op;
+    const struct ast_type_reference * type;
+    const struct flow_graph_local * local;
+    const struct flow_graph_literal * literal;
+
+    size_t operands_offset;
+    size_t operands_size;
+    size_t epoch;
+
+    size_t hash;
+    // следующее значение в той же корзине
+    size_t next;
+
+    // первое вычисление значения, число повторных и их приблизительная длина
+    struct flow_graph_expr * leader;
+    size_t followers;
+    size_t cost;
+};
+
+// повторное вычисление значения, которое можно заменить чтением временной переменной
+struct occurrence {
+
+    struct flow_graph_expr * expr;
+    size_t value;
+    bool cancelled;
+};
+
+struct numbering_task {
+
+    struct flow_graph_expr * expr;
+    bool done;
+};
+
+struct numbering_result {
+
+    size_t value;
+    size_t cost;
+    size_t occurrence;
+};
+
+struct numbering {
+
+    size_t values_size;
+    size_t values_capacity;
+    struct value * values;
+
+    size_t operands_size;
+    size_t operands_capacity;
+    size_t * operands;
+
+    size_t occurrences_size;
+    size_t occurrences_capacity;
+    struct occurrence * occurrences;
+
+    // корзины таблицы значений, видимых в текущей вершине дерева доминаторов; значения снимаются
+    // в обратном порядке добавления, поэтому каждое снимаемое стоит первым в своей корзине
+    size_t buckets_size;
+    size_t * buckets;
+    struct stack log;
+
+    size_t epoch;
+    size_t epochs;
+
+    size_t tasks_size;
+    size_t tasks_capacity;
+    struct numbering_task * tasks;
+
+    size_t results_size;
+    size_t results_capacity;
+    struct numbering_result * results;
+};
+
+static void task_push(struct numbering * numbering, struct flow_graph_expr * expr, bool done) {
+    if (numbering->tasks_size >= numbering->tasks_capacity) {
+        numbering->tasks_capacity = numbering->tasks_capacity ? numbering->tasks_capacity * 2 : 16;
+        numbering->tasks = reallocs(numbering->tasks, sizeof(struct numbering_task) * numbering->tasks_capacity);
+    }
+
+    numbering->tasks[numbering->tasks_size++] = (struct numbering_task) {
+        .expr = expr,
+        .done = done,
+    };
+}
+
+static void task_push_list(struct numbering * numbering, const struct flow_graph_expr_list * list) {
+    for (size_t i = list->size; i > 0; --i) {
+        task_push(numbering, list->values[i - 1], false);
+    }
+}
+
+static void result_push(struct numbering * numbering, size_t value, size_t cost, size_t occurrence) {
+    if (numbering->results_size >= numbering->results_capacity) {
+        numbering->results_capacity = numbering->results_capacity ? numbering->results_capacity * 2 : 16;
+        numbering->results =
+                reallocs(numbering->results, sizeof(struct numbering_result) * numbering->results_capacity);
+    }
+
+    numbering->results[numbering->results_size++] = (struct numbering_result) {
+        .value = value,
+        .cost = cost,
+        .occurrence = occurrence,
+    };
+}
+
+static void operand_push(struct numbering * numbering, size_t value) {
+    if (numbering->operands_size >= numbering->operands_capacity) {
+        numbering->operands_capacity = numbering->operands_capacity ? numbering->operands_capacity * 2 : 16;
+        numbering->operands = reallocs(numbering->operands, sizeof(size_t) * numbering->operands_capacity);
+    }
+
+    numbering->operands[numbering->operands_size++] = value;
+}
+
+static size_t occurrence_push(struct numbering * numbering, struct flow_graph_expr * expr, size_t value) {
+    if (numbering->occurrences_size >= numbering->occurrences_capacity) {
+        numbering->occurrences_capacity = numbering->occurrences_capacity ? numbering->occurrences_capacity * 2 : 16;
+        numbering->occurrences =
+                reallocs(numbering->occurrences, sizeof(struct occurrence) * numbering->occurrences_capacity);
+    }
+
+    numbering->occurrences[numbering->occurrences_size] = (struct occurrence) {
+        .expr = expr,
+        .value = value,
+        .cancelled = false,
+    };
+
+    return numbering->occurrences_size++;
+}
+
+static size_t get_own_cost(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            return 2;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            return 3;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            return 2 + 7 * expr->indexer.indices.size;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            return LOCAL_READ_COST;
+
+        default:
+            return 2;
+    }
+}
+
+static int get_op(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            return expr->binary.op;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            return expr->unary.op;
+
+        default:
+            return 0;
+    }
+}
+
+static size_t hash_value(const struct numbering * numbering, const struct value * value) {
+    size_t result = value->kind;
+
+    result = result * 31 + (size_t) value->op;
+    result = result * 31 + (value->local ? value->local->index : 0);
+    result = result * 31 + (value->literal ? flow_graph_literal_hash(value->literal) : 0);
+    result = result * 31 + value->epoch;
+
+    for (size_t i = 0; i < value->operands_size; ++i) {
+        result = result * 31 + numbering->operands[value->operands_offset + i];
+    }
+
+    return result;
+}
+
+static bool values_equal(const struct numbering * numbering, const struct value * lhs, const struct value * rhs) {
+    if (lhs->hash != rhs->hash
+            || lhs->kind != rhs->kind
+            || lhs->op != rhs->op
+            || lhs->local != rhs->local
+            || lhs->epoch != rhs->epoch
+            || lhs->operands_size != rhs->operands_size
+            || !ast_type_reference_equals(lhs->type, rhs->type)) {
+        return false;
+    }
+
+    if ((lhs->literal || rhs->literal)
+            && (!lhs->literal || !rhs->literal || !flow_graph_literal_equals(lhs->literal, rhs->literal))) {
+        return false;
+    }
+
+    return memcmp(
+            &numbering->operands[lhs->operands_offset],
+            &numbering->operands[rhs->operands_offset],
+            sizeof(size_t) * lhs->operands_size
+    ) == 0;
+}
+
+// номер значения выражения, операнды которого уже пронумерованы и сняты в operands;
+// если такое значение уже видно, found истинно и операнды выбрасываются
+static size_t lookup_value(
+        struct numbering * numbering,
+        struct flow_graph_expr * expr,
+        size_t operands_offset,
+        size_t cost,
+        bool * found
+) {
+    struct value candidate = {
+        .kind = expr->_type,
+        .op = get_op(expr),
+        .type = expr->type,
+        .local = expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL ? expr->local.local : NULL,
+        .literal = expr->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL ? expr->literal.literal : NULL,
+        .operands_offset = operands_offset,
+        .operands_size = numbering->operands_size - operands_offset,
+        .epoch = expr->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER ? numbering->epoch : 0,
+        .leader = expr,
+        .followers = 0,
+        .cost = cost,
+    };
+
+    candidate.hash = hash_value(numbering, &candidate);
+
+    size_t * const bucket = &numbering->buckets[candidate.hash & (numbering->buckets_size - 1)];
+
+    for (size_t i = *bucket; i != NO_VALUE; i = numbering->values[i].next) {
+        if (values_equal(numbering, &numbering->values[i], &candidate)) {
+            numbering->operands_size = operands_offset;
+            *found = true;
+            return i;
+        }
+    }
+
+    if (numbering->values_size >= numbering->values_capacity) {
+        numbering->values_capacity = numbering->values_capacity ? numbering->values_capacity * 2 : 16;
+        numbering->values = reallocs(numbering->values, sizeof(struct value) * numbering->values_capacity);
+    }
+
+    const size_t result = numbering->values_size++;
+
+    candidate.next = *bucket;
+    numbering->values[result] = candidate;
+    *bucket = result;
+
+    stack_push(&numbering->log, (void *) (uintptr_t) result);
+
+    *found = false;
+    return result;
+}
+
+// повторное вычисление поглощает повторные вычисления своих операндов: заменяется оно целиком
+static void cancel_operands(struct numbering * numbering, size_t results_offset) {
+    for (size_t i = results_offset; i < numbering->results_size; ++i) {
+        const size_t occurrence = numbering->results[i].occurrence;
+
+        if (occurrence != NO_VALUE) {
+            numbering->occurrences[occurrence].cancelled = true;
+            --numbering->values[numbering->occurrences[occurrence].value].followers;
+        }
+    }
+}
+
+static size_t get_operands_count(const struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                const struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                switch (lhs->_type) {
+                    case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                        return 2 + lhs->indexer.indices.size;
+
+                    default:
+                        return 1;
+                }
+            }
+
+            return 2;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            return 1;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            return expr->call.args.size;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            return 1 + expr->indexer.indices.size;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            return 0;
+    }
+
+    return 0;
+}
+
+// снимает результаты операндов; значения без побочных эффектов нумеруются, повторные запоминаются,
+// вызовы и записи в массивы начинают новое состояние памяти
+static void finish_expr(struct numbering * numbering, struct flow_graph_expr * expr) {
+    const size_t results_offset = numbering->results_size - get_operands_count(expr);
+    const size_t operands_offset = numbering->operands_size;
+
+    size_t cost = get_own_cost(expr);
+    bool numbered = true;
+
+    for (size_t i = results_offset; i < numbering->results_size; ++i) {
+        const struct numbering_result * const result = &numbering->results[i];
+
+        cost += result->cost;
+        numbered = numbered && result->value != NO_VALUE;
+        operand_push(numbering, result->value);
+    }
+
+    const bool is_assignment = expr->_type == FLOW_GRAPH_EXPR_TYPE_BINARY
+                               && expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT;
+
+    if (is_assignment || expr->_type == FLOW_GRAPH_EXPR_TYPE_CALL) {
+        if (expr->_type == FLOW_GRAPH_EXPR_TYPE_CALL || expr->binary.lhs->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+            numbering->epoch = ++numbering->epochs;
+        }
+
+        numbered = false;
+    }
+
+    if (!numbered) {
+        numbering->operands_size = operands_offset;
+        numbering->results_size = results_offset;
+        result_push(numbering, NO_VALUE, cost, NO_VALUE);
+        return;
+    }
+
+    bool found;
+    const size_t value = lookup_value(numbering, expr, operands_offset, cost, &found);
+
+    // логические значения не сохраняются: на стеке они занимают слово, а переменная — байт
+    const bool reusable = found
+                          && expr->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL
+                          && expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL
+                          && !ast_type_reference_is_bool(expr->type);
+
+    size_t occurrence = NO_VALUE;
+
+    if (reusable) {
+        cancel_operands(numbering, results_offset);
+        occurrence = occurrence_push(numbering, expr, value);
+        ++numbering->values[value].followers;
+    }
+
+    numbering->results_size = results_offset;
+    result_push(numbering, value, cost, occurrence);
+}
+
+// обход в порядке вычисления, как в кодогенерации; у присваивания в элемент массива
+// нумеруются массив и индексы, но не сам элемент
+static void number_expr(struct numbering * numbering, struct flow_graph_expr * root) {
+    task_push(numbering, root, false);
+
+    while (numbering->tasks_size > 0) {
+        const struct numbering_task task = numbering->tasks[--numbering->tasks_size];
+        struct flow_graph_expr * const expr = task.expr;
+
+        if (task.done) {
+            finish_expr(numbering, expr);
+            continue;
+        }
+
+        task_push(numbering, expr, true);
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+                struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                task_push(numbering, expr->binary.rhs, false);
+
+                if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    task_push(numbering, lhs, false);
+                } else if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+                    task_push_list(numbering, &lhs->indexer.indices);
+                    task_push(numbering, lhs->indexer.value, false);
+                }
+
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                task_push(numbering, expr->unary.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                task_push_list(numbering, &expr->call.args);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                task_push_list(numbering, &expr->indexer.indices);
+                task_push(numbering, expr->indexer.value, false);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    --numbering->results_size;
+}
+
+static void remove_values(struct numbering * numbering, size_t mark) {
+    while (numbering->log.size > mark) {
+        const size_t value = (size_t) (uintptr_t) stack_pop(&numbering->log);
+        size_t * const bucket = &numbering->buckets[numbering->values[value].hash & (numbering->buckets_size - 1)];
+
+        *bucket = numbering->values[value].next;
+    }
+}
+
+static size_t count_exprs(const struct flow_graph_node_list * nodes) {
+    struct stack stack = stack_init();
+    size_t result = 0;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        const struct flow_graph_expr * const expr = flow_graph_node_get_expr(nodes->values[i]);
+
+        if (expr) {
+            stack_push(&stack, (void *) expr);
+        }
+    }
+
+    while (stack.size > 0) {
+        const struct flow_graph_expr * const expr = stack_pop(&stack);
+        ++result;
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                stack_push(&stack, expr->binary.lhs);
+                stack_push(&stack, expr->binary.rhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(&stack, expr->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                for (size_t i = 0; i < expr->call.args.size; ++i) {
+                    stack_push(&stack, expr->call.args.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                stack_push(&stack, expr->indexer.value);
+
+                for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                    stack_push(&stack, expr->indexer.indices.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    stack_fini(&stack);
+    return result;
+}
+
+// обход дерева доминаторов в глубину: в вершине видны значения, вычисленные в её доминаторах;
+// состояние памяти переходит к вершине от единственного предшественника, в вершине слияния оно новое
+static void number_subroutine(const struct flow_graph_subroutine * subroutine, struct numbering * numbering) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    struct flow_graph_dominators dominators = flow_graph_dominators_build(subroutine);
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+
+    size_t * const marks = mallocs(sizeof(size_t) * nodes->size);
+    size_t * const exit_epochs = mallocs(sizeof(size_t) * nodes->size);
+    bool * const visited = mallocs(sizeof(bool) * nodes->size);
+    memset(visited, 0, sizeof(bool) * nodes->size);
+
+    struct stack stack = stack_init();
+    stack_push(&stack, nodes->values[0]);
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack.values[stack.size - 1];
+        const size_t i = node->index - 1;
+
+        if (visited[i]) {
+            stack_pop(&stack);
+            remove_values(numbering, marks[i]);
+            continue;
+        }
+
+        visited[i] = true;
+        marks[i] = numbering->log.size;
+
+        if (flow_graph_predecessors_count(&predecessors, node) == 1) {
+            numbering->epoch = exit_epochs[predecessors.values[predecessors.offsets[i]]->index - 1];
+        } else {
+            numbering->epoch = ++numbering->epochs;
+        }
+
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+        if (expr) {
+            number_expr(numbering, expr);
+        }
+
+        exit_epochs[i] = numbering->epoch;
+
+        for (size_t k = dominators.children_offsets[i + 1]; k > dominators.children_offsets[i]; --k) {
+            stack_push(&stack, dominators.children[k - 1]);
+        }
+    }
+
+    stack_fini(&stack);
+    free(visited);
+    free(exit_epochs);
+    free(marks);
+
+    flow_graph_predecessors_fini(&predecessors);
+    flow_graph_dominators_fini(&dominators);
+}
+
+static void delete_operands(struct flow_graph_expr * expr) {
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            flow_graph_expr_delete(expr->binary.lhs);
+            flow_graph_expr_delete(expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            flow_graph_expr_delete(expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            flow_graph_expr_list_fini(&expr->call.args);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+            flow_graph_expr_delete(expr->indexer.value);
+            flow_graph_expr_list_fini(&expr->indexer.indices);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+            break;
+    }
+}
+
+// первое вычисление заменяется на месте присваиванием его значения временной переменной,
+// поэтому ссылки на него из родителя и вершины остаются верными
+static void save_leader(struct flow_graph_expr * leader, struct flow_graph_local * temp) {
+    struct flow_graph_expr * const moved = mallocs(sizeof(struct flow_graph_expr));
+    *moved = *leader;
+
+    struct flow_graph_expr * const lhs = flow_graph_expr_new_typed_local(leader->position, temp);
+
+    leader->_type = FLOW_GRAPH_EXPR_TYPE_BINARY;
+    leader->type = ast_type_reference_clone(moved->type);
+    leader->binary.op = FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT;
+    leader->binary.lhs = lhs;
+    leader->binary.rhs = moved;
+}
+
+static void reuse_temp(struct flow_graph_expr * follower, struct flow_graph_local * temp) {
+    delete_operands(follower);
+
+    follower->_type = FLOW_GRAPH_EXPR_TYPE_LOCAL;
+    follower->local.local = temp;
+}
+
+bool flow_graph_optimize_number_values(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0) {
+        return false;
+    }
+
+    // значений не больше, чем выражений, и каждое выражение — операнд не более чем одного родителя,
+    // поэтому массивы выделяются сразу целиком
+    const size_t exprs = count_exprs(nodes) + 1;
+    size_t buckets_size = 16;
+
+    while (buckets_size < exprs) {
+        buckets_size *= 2;
+    }
+
+    struct numbering numbering = {
+        .values_capacity = exprs,
+        .values = mallocs(sizeof(struct value) * exprs),
+        .operands_capacity = exprs,
+        .operands = mallocs(sizeof(size_t) * exprs),
+        .buckets_size = buckets_size,
+        .buckets = mallocs(sizeof(size_t) * buckets_size),
+        .log = stack_init(),
+    };
+
+    for (size_t i = 0; i < buckets_size; ++i) {
+        numbering.buckets[i] = NO_VALUE;
+    }
+
+    number_subroutine(subroutine, &numbering);
+
+    struct flow_graph_local ** const temps =
+            mallocs(sizeof(struct flow_graph_local *) * (numbering.values_size ? numbering.values_size : 1));
+
+    bool result = false;
+
+    for (size_t i = 0; i < numbering.values_size; ++i) {
+        const struct value * const value = &numbering.values[i];
+        const size_t saved = value->cost > LOCAL_READ_COST ? value->followers * (value->cost - LOCAL_READ_COST) : 0;
+
+        temps[i] = NULL;
+
+        if (saved > SAVE_COST) {
+            temps[i] = flow_graph_subroutine_add_temp(
+                    subroutine,
+                    ast_type_reference_clone(value->leader->type),
+                    value->leader->position
+            );
+            save_leader(value->leader, temps[i]);
+            result = true;
+        }
+    }
+
+    for (size_t i = 0; i < numbering.occurrences_size; ++i) {
+        const struct occurrence * const occurrence = &numbering.occurrences[i];
+
+        if (!occurrence->cancelled && temps[occurrence->value]) {
+            reuse_temp(occurrence->expr, temps[occurrence->value]);
+        }
+    }
+
+    free(temps);
+
+    free(numbering.results);
+    free(numbering.tasks);
+    stack_fini(&numbering.log);
+    free(numbering.buckets);
+    free(numbering.occurrences);
+    free(numbering.operands);
+    free(numbering.values);
+
+    return result;
+}
@@ -0,0 +1,77 @@
+#include "optimize.h"
+
+#include "passes.h"
+#include "ssa.h"
+
+
+struct flow_graph_optimize_options flow_graph_optimize_options_init(void) {
+    return (struct flow_graph_optimize_options) {
+        .enabled = true,
+        .keep_ssa = false,
+        .unroll_budget = 64,
+    };
+}
+
+void flow_graph_optimize(struct flow_graph_subroutine_list * subroutines, const struct flow_graph_optimize_options * options) {
+    if (!options->enabled) {
+        return;
+    }
+
+    // после замены хвостовой рекурсии циклом подпрограмма может перестать быть рекурсивной и встроиться
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        struct flow_graph_subroutine * const subroutine = subroutines->values[i];
+
+        if (subroutine->defined && subroutine->nodes.size > 0) {
+            flow_graph_optimize_eliminate_tail_recursion(subroutine);
+        }
+    }
+
+    // встроенные копии оптимизируются вместе с телом вызывающей подпрограммы
+    flow_graph_optimize_inline_calls(subroutines);
+
+    for (size_t i = 0; i < subroutines->size; ++i) {
+        struct flow_graph_subroutine * const subroutine = subroutines->values[i];
+
+        if (!subroutine->defined || subroutine->nodes.size == 0) {
+            continue;
+        }
+
+        flow_graph_optimize_simplify(subroutine);
+
+        if (flow_graph_optimize_eliminate(subroutine)) {
+            flow_graph_optimize_simplify(subroutine);
+        }
+
+        flow_graph_optimize_hoist_invariants(subroutine);
+
+        // переменная цикла, которая осталась нужна только самой себе, удаляется сильной живостью
+        if (flow_graph_optimize_reduce_strength(subroutine) && flow_graph_optimize_eliminate(subroutine)) {
+            flow_graph_optimize_simplify(subroutine);
+        }
+
+        if (flow_graph_optimize_unroll_loops(subroutine, options->unroll_budget)) {
+            flow_graph_optimize_simplify(subroutine);
+        }
+
+        // проходы над SSA-формой идут между её построением и выходом из неё
+        flow_graph_ssa_build(subroutine);
+
+        const bool propagated = flow_graph_optimize_propagate_constants(subroutine);
+        flow_graph_optimize_number_values(subroutine);
+
+        if (!options->keep_ssa) {
+            flow_graph_ssa_destroy(subroutine);
+            flow_graph_optimize_simplify(subroutine);
+
+            // после подстановки констант присваивания, из которых они взяты, часто становятся мёртвыми
+            if (propagated && flow_graph_optimize_eliminate(subroutine)) {
+                flow_graph_optimize_simplify(subroutine);
+            }
+
+            // пары вставляются последними, чтобы другие проходы не разнесли их по разным местам
+            flow_graph_optimize_fuse_division(subroutine);
+        }
+
+        flow_graph_subroutine_build_blocks(subroutine);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "flow_graph.h"
+
+
+struct flow_graph_optimize_options {
+
+    // при выключенной оптимизации графы передаются в кодогенерацию в том виде, в котором их построил анализ
+    bool enabled;
+
+    // графы остаются в SSA-форме, чтобы их можно было вывести; кодогенерация фи-функции не понимает
+    bool keep_ssa;
+
+    // сколько выражений развёртка может добавить на один цикл, 0 выключает развёртку
+    size_t unroll_budget;
+};
+
+struct flow_graph_optimize_options flow_graph_optimize_options_init(void);
+
+// преобразует графы определённых подпрограмм и заново строит по ним блоки;
+// вызывается после успешного анализа, перед кодогенерацией
+void flow_graph_optimize(struct flow_graph_subroutine_list * subroutines, const struct flow_graph_optimize_options * options);
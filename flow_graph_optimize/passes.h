@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "flow_graph.h"
+
+
+// проходы оптимизации над графом одной подпрограммы; каждый возвращает true, если граф изменился,
+// и оставляет вершины пронумерованными по порядку без недостижимых
+
+// продвижение переходов через пустые вершины и известные условия, слияние одинаковых хвостов
+bool flow_graph_optimize_simplify(struct flow_graph_subroutine * subroutine);
+
+// удаление записей в переменные, которые дальше не читаются, и выражений без побочных эффектов,
+// значение которых не используется; опустевшие вершины остаются пустыми до следующего упрощения
+bool flow_graph_optimize_eliminate(struct flow_graph_subroutine * subroutine);
+
+// хвостовая рекурсия: вершина, которая возвращает значение вызова самой подпрограммы, записывает
+// аргументы в параметры и переходит в начало; параметры, которые читают следующие аргументы,
+// перезаписываются через временные переменные
+bool flow_graph_optimize_eliminate_tail_recursion(struct flow_graph_subroutine * subroutine);
+
+// вынос из естественных циклов выражений без побочных эффектов, которые в цикле не меняются: значение
+// вычисляется во временную переменную перед заголовком; деление и чтение элементов массивов выносятся,
+// только если цикл вычислил бы их и сам, для циклов с проверкой в заголовке — под копией этой проверки
+bool flow_graph_optimize_hoist_invariants(struct flow_graph_subroutine * subroutine);
+
+// снижение стоимости адресации в циклах: обращения a[i ± c] по переменной, которая в цикле только
+// сдвигается на константу, читают элемент по временному указателю, сдвигаемому вместе с ней на размер
+// элемента; индекс-литерал кодогенерация складывает со смещением, умножение уходит из цикла
+bool flow_graph_optimize_reduce_strength(struct flow_graph_subroutine * subroutine);
+
+// развёртка циклов с проверкой i < n или i > n в заголовке и шагом i на единицу: при известных
+// начале и границе цикл заменяется копиями тела целиком, иначе тело повторяется несколько раз под одной
+// проверкой, а оставшиеся проходы делает исходный цикл; budget ограничивает число добавленных выражений
+bool flow_graph_optimize_unroll_loops(struct flow_graph_subroutine * subroutine, size_t budget);
+
+// деление и остаток от деления одних и тех же переменных или литералов в одной цепочке вершин без
+// ветвлений вычисляются одной парой присваиваний перед первым из них, которую кодогенерация выполняет
+// одной инструкцией divmod; присваивание x = a op b второго вхождения само становится частью пары,
+// остальные вхождения читают временные переменные, если операнды между ними не меняются
+bool flow_graph_optimize_fuse_division(struct flow_graph_subroutine * subroutine);
+
+// межпроцедурные проходы над всеми подпрограммами
+
+// встраивание вызовов: вызов нерекурсивной подпрограммы, которая мала или вызывается один раз, заменяется
+// копией её вершин и переменных с присваиванием аргументов копиям параметров; подпрограммы обходятся
+// от вызываемых к вызывающим, рост каждой ограничен
+bool flow_graph_optimize_inline_calls(struct flow_graph_subroutine_list * subroutines);
+
+// проходы над SSA-формой, см. ssa.h
+
+// распространение констант по версиям переменных с учётом только исполнимых дуг: чтения переменных
+// с известным значением и вычислимые подвыражения без побочных эффектов заменяются литералами,
+// условия с известным результатом — переходами, у фи-функций убираются аргументы удалённых дуг
+bool flow_graph_optimize_propagate_constants(struct flow_graph_subroutine * subroutine);
+
+// нумерация значений по дереву доминаторов: повторное вычисление выражения без побочных эффектов,
+// которое уже вычислено в доминирующей вершине, заменяется чтением временной переменной, куда
+// сохраняется первое вычисление; чтения элементов массивов не переживают вызовов и записей в массивы
+bool flow_graph_optimize_number_values(struct flow_graph_subroutine * subroutine);
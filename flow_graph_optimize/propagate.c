@@ -0,0 +1,853 @@
+#include "passes.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// значение переменной или выражения: ещё не вычислено ни на одном исполнимом пути,
+// одна и та же константа на всех путях или неизвестно до исполнения
+enum lattice_state {
+
+    LATTICE_STATE_UNKNOWN = 0,
+    LATTICE_STATE_CONSTANT,
+    LATTICE_STATE_VARYING,
+};
+
+// константа хранится так, как её видят операции кодогенерации: 32-битным словом, в которое значение
+// расширено по знаковости своего типа; логическое значение — 0 или 0xffffffff, символ — его код
+struct lattice {
+
+    enum lattice_state state;
+    uint32_t value;
+};
+
+static const struct lattice UNKNOWN = { .state = LATTICE_STATE_UNKNOWN };
+static const struct lattice VARYING = { .state = LATTICE_STATE_VARYING };
+
+static struct lattice constant(uint32_t value) {
+    return (struct lattice) {
+        .state = LATTICE_STATE_CONSTANT,
+        .value = value,
+    };
+}
+
+static struct lattice meet(struct lattice lhs, struct lattice rhs) {
+    if (lhs.state == LATTICE_STATE_UNKNOWN) {
+        return rhs;
+    }
+
+    if (rhs.state == LATTICE_STATE_UNKNOWN) {
+        return lhs;
+    }
+
+    if (lhs.state == LATTICE_STATE_CONSTANT && rhs.state == LATTICE_STATE_CONSTANT && lhs.value == rhs.value) {
+        return lhs;
+    }
+
+    return VARYING;
+}
+
+static bool is_char(const struct ast_type_reference * type) {
+    return type && type->_type == AST_TYPE_REFERENCE_TYPE_BUILTIN && type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_CHAR;
+}
+
+static bool is_tracked_type(const struct ast_type_reference * type) {
+    return ast_type_reference_is_numeric(type) || ast_type_reference_is_bool(type) || is_char(type);
+}
+
+// слово, которое получится, если обрезать его до размера числового типа и снова расширить
+static uint32_t normalize(uint32_t value, const struct ast_type_reference * type) {
+    if (!ast_type_reference_is_numeric(type)) {
+        return value;
+    }
+
+    switch (type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            return (uint8_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            return (uint32_t) (int32_t) (int16_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return (uint16_t) value;
+
+        default:
+            return value;
+    }
+}
+
+static struct lattice literal_value(const struct flow_graph_literal * literal, const struct ast_type_reference * type) {
+    switch (literal->_type) {
+        case FLOW_GRAPH_LITERAL_TYPE_BOOL:
+            return constant(literal->_bool.value ? UINT32_MAX : 0);
+
+        case FLOW_GRAPH_LITERAL_TYPE_CHAR:
+            return constant((uint8_t) literal->_char.value);
+
+        case FLOW_GRAPH_LITERAL_TYPE_INT:
+            return constant(normalize((uint32_t) literal->_int.value, type));
+
+        case FLOW_GRAPH_LITERAL_TYPE_STR:
+            return VARYING;
+    }
+
+    return VARYING;
+}
+
+// операции над 32-битными словами повторяют команды машины: сравнения знаковые, деление и сдвиги
+// беззнаковые, сдвиг на 32 и больше даёт 0; деление на ноль не вычисляется, оно остаётся до исполнения
+static bool evaluate_binary_op(enum flow_graph_expr_binary_op op, uint32_t lhs, uint32_t rhs, uint32_t * result) {
+    switch (op) {
+        case FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT:
+            return false;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_PLUS:
+            *result = lhs + rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_MINUS:
+            *result = lhs - rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_MULTIPLY:
+            *result = lhs * rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_DIVIDE:
+            *result = rhs ? lhs / rhs : 0;
+            return rhs != 0;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_REMAINDER:
+            *result = rhs ? lhs % rhs : 0;
+            return rhs != 0;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_AND:
+        case FLOW_GRAPH_EXPR_BINARY_OP_AND:
+            *result = lhs & rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_OR:
+        case FLOW_GRAPH_EXPR_BINARY_OP_OR:
+            *result = lhs | rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_BITWISE_XOR:
+            *result = lhs ^ rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_EQ:
+            *result = lhs == rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_NE:
+            *result = lhs != rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_LT:
+            *result = (int32_t) lhs < (int32_t) rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_LE:
+            *result = (int32_t) lhs <= (int32_t) rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_GT:
+            *result = (int32_t) lhs > (int32_t) rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_GE:
+            *result = (int32_t) lhs >= (int32_t) rhs ? UINT32_MAX : 0;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_LEFT_BITSHIFT:
+            *result = rhs >= 32 ? 0 : lhs << rhs;
+            return true;
+
+        case FLOW_GRAPH_EXPR_BINARY_OP_RIGHT_BITSHIFT:
+            *result = rhs >= 32 ? 0 : lhs >> rhs;
+            return true;
+    }
+
+    return false;
+}
+
+static struct lattice evaluate_binary(const struct flow_graph_expr * expr, struct lattice lhs, struct lattice rhs) {
+    if (lhs.state == LATTICE_STATE_VARYING || rhs.state == LATTICE_STATE_VARYING) {
+        return VARYING;
+    }
+
+    if (lhs.state == LATTICE_STATE_UNKNOWN || rhs.state == LATTICE_STATE_UNKNOWN) {
+        return UNKNOWN;
+    }
+
+    uint32_t result;
+
+    if (!evaluate_binary_op(expr->binary.op, lhs.value, rhs.value, &result)) {
+        return VARYING;
+    }
+
+    return constant(normalize(result, expr->type));
+}
+
+static struct lattice evaluate_unary(const struct flow_graph_expr * expr, struct lattice value) {
+    if (value.state != LATTICE_STATE_CONSTANT) {
+        return value;
+    }
+
+    switch (expr->unary.op) {
+        case FLOW_GRAPH_EXPR_UNARY_OP_MINUS:
+            return constant(normalize(0 - value.value, expr->type));
+
+        case FLOW_GRAPH_EXPR_UNARY_OP_BITWISE_NOT:
+        case FLOW_GRAPH_EXPR_UNARY_OP_NOT:
+            return constant(normalize(value.value ^ UINT32_MAX, expr->type));
+    }
+
+    return VARYING;
+}
+
+// значение, которое запись в переменную типа type оставляет в ней, а присваивание возвращает
+static struct lattice convert(struct lattice value, const struct ast_type_reference * type) {
+    if (!is_tracked_type(type)) {
+        return VARYING;
+    }
+
+    if (value.state != LATTICE_STATE_CONSTANT) {
+        return value;
+    }
+
+    return constant(normalize(value.value, type));
+}
+
+static bool is_byte_type(const struct ast_type_reference * type) {
+    return is_char(type) || (ast_type_reference_is_numeric(type) && type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE);
+}
+
+// встроенные ord и chr только меняют тип байта, и кодогенерация разворачивает их в ничто,
+// поэтому их вызов без побочных эффектов, а значение — аргумент, приведённый к типу результата
+static bool is_retype_builtin(const struct flow_graph_subroutine * subroutine) {
+    return !subroutine->defined
+           && (strcmp(subroutine->id, "ord") == 0 || strcmp(subroutine->id, "chr") == 0)
+           && subroutine->args_num == 1
+           && is_byte_type(subroutine->locals.values[0]->type)
+           && is_byte_type(subroutine->return_type);
+}
+
+struct eval_task {
+
+    struct flow_graph_expr * expr;
+    bool done;
+};
+
+struct eval_value {
+
+    struct lattice value;
+    bool pure;
+};
+
+struct evaluation {
+
+    size_t tasks_size;
+    size_t tasks_capacity;
+    struct eval_task * tasks;
+
+    size_t values_size;
+    size_t values_capacity;
+    struct eval_value * values;
+};
+
+static void eval_task_push(struct evaluation * evaluation, struct flow_graph_expr * expr, bool done) {
+    if (evaluation->tasks_size >= evaluation->tasks_capacity) {
+        evaluation->tasks_capacity = evaluation->tasks_capacity ? evaluation->tasks_capacity * 2 : 16;
+        evaluation->tasks = reallocs(evaluation->tasks, sizeof(struct eval_task) * evaluation->tasks_capacity);
+    }
+
+    evaluation->tasks[evaluation->tasks_size++] = (struct eval_task) {
+        .expr = expr,
+        .done = done,
+    };
+}
+
+static void eval_value_push(struct evaluation * evaluation, struct lattice value, bool pure) {
+    if (evaluation->values_size >= evaluation->values_capacity) {
+        evaluation->values_capacity = evaluation->values_capacity ? evaluation->values_capacity * 2 : 16;
+        evaluation->values = reallocs(evaluation->values, sizeof(struct eval_value) * evaluation->values_capacity);
+    }
+
+    evaluation->values[evaluation->values_size++] = (struct eval_value) {
+        .value = value,
+        .pure = pure,
+    };
+}
+
+// снимает значения count операндов и сообщает, все ли они без побочных эффектов
+static bool eval_values_pop(struct evaluation * evaluation, size_t count) {
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++i) {
+        result = evaluation->values[--evaluation->values_size].pure && result;
+    }
+
+    return result;
+}
+
+struct propagation {
+
+    struct flow_graph_subroutine * subroutine;
+
+    // по номеру переменной - 1
+    struct lattice * values;
+
+    // вершины, которые читают переменную с номером i, лежат в uses с use_offsets[i - 1] по use_offsets[i]
+    size_t * use_offsets;
+    struct flow_graph_node ** uses;
+
+    // исполнимые вершины и дуги по номеру вершины - 1; дуга 0 — переход или ветка then, дуга 1 — ветка else
+    bool * executable;
+    bool (* edges)[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+
+    struct stack worklist;
+    bool * queued;
+
+    struct evaluation evaluation;
+};
+
+static void enqueue(struct propagation * propagation, struct flow_graph_node * node) {
+    if (!propagation->queued[node->index - 1]) {
+        propagation->queued[node->index - 1] = true;
+        stack_push(&propagation->worklist, node);
+    }
+}
+
+static void set_value(struct propagation * propagation, const struct flow_graph_local * local, struct lattice value) {
+    const size_t i = local->index - 1;
+    const struct lattice old = propagation->values[i];
+    const struct lattice new = meet(old, value);
+
+    if (new.state == old.state && new.value == old.value) {
+        return;
+    }
+
+    propagation->values[i] = new;
+
+    for (size_t k = propagation->use_offsets[i]; k < propagation->use_offsets[i + 1]; ++k) {
+        struct flow_graph_node * const node = propagation->uses[k];
+
+        if (propagation->executable[node->index - 1]) {
+            enqueue(propagation, node);
+        }
+    }
+}
+
+static struct flow_graph_literal * new_literal(struct position position, const struct ast_type_reference * type, uint32_t value) {
+    if (ast_type_reference_is_bool(type)) {
+        return flow_graph_literal_new_bool(position, value != 0);
+    }
+
+    if (is_char(type)) {
+        return flow_graph_literal_new_char(position, (char) value);
+    }
+
+    return flow_graph_literal_new_int(position, value);
+}
+
+// выражение заменяется на месте, поэтому ссылки на него из родителя и вершины остаются верными;
+// тип выражения сохраняется, кодогенерация по нему приводит литерал так же, как вычисленное значение
+static void make_literal(struct flow_graph_expr * expr, uint32_t value) {
+    struct flow_graph_literal * const literal = new_literal(expr->position, expr->type, value);
+
+    switch (expr->_type) {
+        case FLOW_GRAPH_EXPR_TYPE_BINARY:
+            flow_graph_expr_delete(expr->binary.lhs);
+            flow_graph_expr_delete(expr->binary.rhs);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_UNARY:
+            flow_graph_expr_delete(expr->unary.value);
+            break;
+
+        case FLOW_GRAPH_EXPR_TYPE_CALL:
+            flow_graph_expr_list_fini(&expr->call.args);
+            break;
+
+        default:
+            break;
+    }
+
+    expr->_type = FLOW_GRAPH_EXPR_TYPE_LITERAL;
+    expr->literal.literal = literal;
+}
+
+// вычисление в порядке кодогенерации, чтобы чтение после присваивания в том же выражении видело
+// записанную версию; при fold значения переменных уже окончательные и не обновляются,
+// а подвыражения без побочных эффектов с известным значением заменяются литералами
+static struct lattice evaluate(struct propagation * propagation, struct flow_graph_expr * root, bool fold, bool * changed) {
+    struct evaluation * const evaluation = &propagation->evaluation;
+
+    eval_task_push(evaluation, root, false);
+
+    while (evaluation->tasks_size > 0) {
+        const struct eval_task task = evaluation->tasks[--evaluation->tasks_size];
+        struct flow_graph_expr * const expr = task.expr;
+
+        if (!task.done) {
+            eval_task_push(evaluation, expr, true);
+
+            switch (expr->_type) {
+                case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                    eval_task_push(evaluation, expr->binary.rhs, false);
+
+                    if (expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+                            || expr->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+                        eval_task_push(evaluation, expr->binary.lhs, false);
+                    }
+
+                    break;
+
+                case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                    eval_task_push(evaluation, expr->unary.value, false);
+                    break;
+
+                case FLOW_GRAPH_EXPR_TYPE_CALL:
+                    for (size_t i = expr->call.args.size; i > 0; --i) {
+                        eval_task_push(evaluation, expr->call.args.values[i - 1], false);
+                    }
+
+                    break;
+
+                case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                    for (size_t i = expr->indexer.indices.size; i > 0; --i) {
+                        eval_task_push(evaluation, expr->indexer.indices.values[i - 1], false);
+                    }
+
+                    eval_task_push(evaluation, expr->indexer.value, false);
+                    break;
+
+                case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+                case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                    break;
+            }
+
+            continue;
+        }
+
+        struct lattice value = VARYING;
+        bool pure = true;
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY: {
+                const struct eval_value rhs = evaluation->values[evaluation->values_size - 1];
+
+                if (expr->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT) {
+                    const struct flow_graph_expr * const lhs = expr->binary.lhs;
+
+                    eval_values_pop(evaluation, lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL ? 1 : 2);
+
+                    value = convert(rhs.value, lhs->type);
+                    pure = false;
+
+                    if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && !fold) {
+                        set_value(propagation, lhs->local.local, convert(rhs.value, lhs->local.local->type));
+                    }
+
+                    break;
+                }
+
+                const struct eval_value lhs = evaluation->values[evaluation->values_size - 2];
+
+                pure = eval_values_pop(evaluation, 2);
+                value = evaluate_binary(expr, lhs.value, rhs.value);
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY: {
+                const struct eval_value operand = evaluation->values[evaluation->values_size - 1];
+
+                pure = eval_values_pop(evaluation, 1);
+                value = evaluate_unary(expr, operand.value);
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL: {
+                const struct flow_graph_subroutine * const callee = expr->call.subroutine;
+
+                if (!is_retype_builtin(callee)) {
+                    eval_values_pop(evaluation, expr->call.args.size);
+                    pure = false;
+                    break;
+                }
+
+                const struct eval_value arg = evaluation->values[evaluation->values_size - 1];
+
+                pure = eval_values_pop(evaluation, 1);
+                value = convert(convert(arg.value, callee->locals.values[0]->type), expr->type);
+                break;
+            }
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                pure = eval_values_pop(evaluation, expr->indexer.indices.size + 1);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+                value = propagation->values[expr->local.local->index - 1];
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                value = literal_value(expr->literal.literal, expr->type);
+                break;
+        }
+
+        if (fold && pure && value.state == LATTICE_STATE_CONSTANT && is_tracked_type(expr->type)
+                && expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL
+                && expr->_type != FLOW_GRAPH_EXPR_TYPE_INDEXER) {
+            make_literal(expr, value.value);
+            *changed = true;
+        }
+
+        eval_value_push(evaluation, value, pure);
+    }
+
+    return evaluation->values[--evaluation->values_size].value;
+}
+
+static bool is_edge_executable(
+        const struct propagation * propagation,
+        const struct flow_graph_node * predecessor,
+        const struct flow_graph_node * node
+) {
+    const bool * const edges = propagation->edges[predecessor->index - 1];
+
+    switch (predecessor->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            return edges[0];
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            return (edges[0] && predecessor->cond.then_next == node) || (edges[1] && predecessor->cond.else_next == node);
+    }
+
+    return false;
+}
+
+static void mark_edge(struct propagation * propagation, struct flow_graph_node * node, size_t slot, struct flow_graph_node * target) {
+    bool * const edge = &propagation->edges[node->index - 1][slot];
+
+    if (!target || *edge) {
+        return;
+    }
+
+    *edge = true;
+    propagation->executable[target->index - 1] = true;
+
+    // новая исполнимая дуга меняет значения фи-функций цели, даже если цель уже посещалась
+    enqueue(propagation, target);
+}
+
+static void visit_node(struct propagation * propagation, struct flow_graph_node * node) {
+    for (size_t i = 0; i < node->phis.size; ++i) {
+        const struct flow_graph_phi * const phi = node->phis.values[i];
+        struct lattice value = UNKNOWN;
+
+        for (size_t j = 0; j < phi->size; ++j) {
+            if (is_edge_executable(propagation, phi->args[j].predecessor, node)) {
+                value = meet(value, propagation->values[phi->args[j].value->index - 1]);
+            }
+        }
+
+        set_value(propagation, phi->target, value);
+    }
+
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            if (node->expr.expr) {
+                evaluate(propagation, node->expr.expr, false, NULL);
+            }
+
+            mark_edge(propagation, node, 0, node->expr.next);
+            break;
+
+        case FLOW_GRAPH_NODE_TYPE_COND: {
+            const struct lattice cond = evaluate(propagation, node->cond.cond, false, NULL);
+
+            if (cond.state == LATTICE_STATE_UNKNOWN) {
+                break;
+            }
+
+            if (cond.state == LATTICE_STATE_VARYING || cond.value) {
+                mark_edge(propagation, node, 0, node->cond.then_next);
+            }
+
+            if (cond.state == LATTICE_STATE_VARYING || !cond.value) {
+                mark_edge(propagation, node, 1, node->cond.else_next);
+            }
+
+            break;
+        }
+    }
+}
+
+// номера - 1 прочитанных переменных подряд по всем вершинам
+struct use {
+
+    size_t size;
+    size_t capacity;
+    size_t * locals;
+};
+
+static void append_use(struct use * use, size_t local) {
+    if (use->size >= use->capacity) {
+        use->capacity = use->capacity ? use->capacity * 2 : 16;
+        use->locals = reallocs(use->locals, sizeof(size_t) * use->capacity);
+    }
+
+    use->locals[use->size++] = local;
+}
+
+static void collect_use(struct flow_graph_expr * local, bool write, void * context) {
+    if (!write) {
+        append_use(context, local->local.local->index - 1);
+    }
+}
+
+// вершины-читатели каждой переменной; аргументы фи-функций читаются в вершине самой фи-функции
+static void build_uses(struct propagation * propagation) {
+    const struct flow_graph_node_list * const nodes = &propagation->subroutine->nodes;
+    const size_t locals_size = propagation->subroutine->locals.size;
+
+    struct use use = { 0 };
+    size_t * const node_offsets = mallocs(sizeof(size_t) * (nodes->size + 1));
+
+    node_offsets[0] = 0;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const node = nodes->values[i];
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+        for (size_t p = 0; p < node->phis.size; ++p) {
+            const struct flow_graph_phi * const phi = node->phis.values[p];
+
+            for (size_t j = 0; j < phi->size; ++j) {
+                append_use(&use, phi->args[j].value->index - 1);
+            }
+        }
+
+        if (expr) {
+            flow_graph_expr_visit_locals(expr, collect_use, &use);
+        }
+
+        node_offsets[i + 1] = use.size;
+    }
+
+    propagation->use_offsets = mallocs(sizeof(size_t) * (locals_size + 1));
+    propagation->uses = mallocs(sizeof(struct flow_graph_node *) * (use.size ? use.size : 1));
+
+    memset(propagation->use_offsets, 0, sizeof(size_t) * (locals_size + 1));
+
+    for (size_t k = 0; k < use.size; ++k) {
+        ++propagation->use_offsets[use.locals[k] + 1];
+    }
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        propagation->use_offsets[i + 1] += propagation->use_offsets[i];
+    }
+
+    size_t * const filled = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memcpy(filled, propagation->use_offsets, sizeof(size_t) * locals_size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        for (size_t k = node_offsets[i]; k < node_offsets[i + 1]; ++k) {
+            propagation->uses[filled[use.locals[k]]++] = nodes->values[i];
+        }
+    }
+
+    free(filled);
+    free(node_offsets);
+    free(use.locals);
+}
+
+static void make_expr(struct flow_graph_node * node, struct flow_graph_expr * expr, struct flow_graph_node * next) {
+    node->_type = FLOW_GRAPH_NODE_TYPE_EXPR;
+    node->expr.expr = expr;
+    node->expr.next = next;
+}
+
+// условие с известным значением заменяется переходом; если в нём остались побочные эффекты,
+// оно остаётся выражением вершины, но так нельзя выразить возврат без значения по ветке NULL
+static bool fold_cond(struct flow_graph_node * node, struct lattice cond) {
+    if (cond.state != LATTICE_STATE_CONSTANT) {
+        return false;
+    }
+
+    struct flow_graph_node * const taken = cond.value ? node->cond.then_next : node->cond.else_next;
+    struct flow_graph_expr * const expr = node->cond.cond;
+
+    if (expr->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL) {
+        flow_graph_expr_delete(expr);
+        make_expr(node, NULL, taken);
+        return true;
+    }
+
+    if (!taken) {
+        return false;
+    }
+
+    make_expr(node, expr, taken);
+    return true;
+}
+
+static size_t count_edges(const struct flow_graph_node * predecessor, const struct flow_graph_node * node) {
+    struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+    const size_t successors_size = flow_graph_node_get_successors(predecessor, successors);
+
+    size_t result = 0;
+
+    for (size_t k = 0; k < successors_size; ++k) {
+        result += successors[k] == node;
+    }
+
+    return result;
+}
+
+static void mark_reachable(const struct flow_graph_subroutine * subroutine, bool * reachable) {
+    struct stack stack = stack_init();
+
+    memset(reachable, 0, sizeof(bool) * subroutine->nodes.size);
+
+    reachable[0] = true;
+    stack_push(&stack, subroutine->nodes.values[0]);
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&stack);
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            if (!reachable[successors[k]->index - 1]) {
+                reachable[successors[k]->index - 1] = true;
+                stack_push(&stack, successors[k]);
+            }
+        }
+    }
+
+    stack_fini(&stack);
+}
+
+// у фи-функций остаются аргументы только тех дуг, которые остались в графе после удаления
+// недостижимых вершин: по одному на каждую дугу из предшественника
+static bool prune_phi_args(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    bool * const reachable = mallocs(sizeof(bool) * nodes->size);
+    bool result = false;
+
+    mark_reachable(subroutine, reachable);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        const struct flow_graph_node * const node = nodes->values[i];
+
+        if (!reachable[i]) {
+            continue;
+        }
+
+        for (size_t p = 0; p < node->phis.size; ++p) {
+            struct flow_graph_phi * const phi = node->phis.values[p];
+            size_t size = 0;
+
+            for (size_t j = 0; j < phi->size; ++j) {
+                const struct flow_graph_phi_arg arg = phi->args[j];
+                size_t kept = 0;
+
+                for (size_t k = 0; k < size; ++k) {
+                    kept += phi->args[k].predecessor == arg.predecessor;
+                }
+
+                if (reachable[arg.predecessor->index - 1] && kept < count_edges(arg.predecessor, node)) {
+                    phi->args[size++] = arg;
+                }
+            }
+
+            result = result || size != phi->size;
+            phi->size = size;
+        }
+    }
+
+    free(reachable);
+    return result;
+}
+
+bool flow_graph_optimize_propagate_constants(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const struct flow_graph_local_list * const locals = &subroutine->locals;
+
+    if (nodes->size == 0) {
+        return false;
+    }
+
+    struct propagation propagation = {
+        .subroutine = subroutine,
+        .values = mallocs(sizeof(struct lattice) * (locals->size ? locals->size : 1)),
+        .executable = mallocs(sizeof(bool) * nodes->size),
+        .edges = mallocs(sizeof(bool [FLOW_GRAPH_NODE_SUCCESSORS_MAX]) * nodes->size),
+        .worklist = stack_init(),
+        .queued = mallocs(sizeof(bool) * nodes->size),
+        .evaluation = { 0 },
+    };
+
+    // чтения исходных переменных остались только до первой записи: это аргументы
+    // или неинициализированные значения
+    for (size_t i = 0; i < locals->size; ++i) {
+        const struct flow_graph_local * const local = locals->values[i];
+        propagation.values[i] = local->origin && is_tracked_type(local->type) ? UNKNOWN : VARYING;
+    }
+
+    memset(propagation.executable, 0, sizeof(bool) * nodes->size);
+    memset(propagation.edges, 0, sizeof(bool [FLOW_GRAPH_NODE_SUCCESSORS_MAX]) * nodes->size);
+    memset(propagation.queued, 0, sizeof(bool) * nodes->size);
+
+    build_uses(&propagation);
+
+    propagation.executable[0] = true;
+    enqueue(&propagation, nodes->values[0]);
+
+    while (propagation.worklist.size > 0) {
+        struct flow_graph_node * const node = stack_pop(&propagation.worklist);
+
+        propagation.queued[node->index - 1] = false;
+        visit_node(&propagation, node);
+    }
+
+    bool result = false;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const node = nodes->values[i];
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+        if (!propagation.executable[i] || !expr) {
+            continue;
+        }
+
+        const struct lattice value = evaluate(&propagation, expr, true, &result);
+
+        if (node->_type == FLOW_GRAPH_NODE_TYPE_COND) {
+            result = fold_cond(node, value) || result;
+        }
+    }
+
+    if (result) {
+        prune_phi_args(subroutine);
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    free(propagation.evaluation.tasks);
+    free(propagation.evaluation.values);
+    free(propagation.uses);
+    free(propagation.use_offsets);
+    free(propagation.queued);
+    stack_fini(&propagation.worklist);
+    free(propagation.edges);
+    free(propagation.executable);
+    free(propagation.values);
+
+    return result;
+}
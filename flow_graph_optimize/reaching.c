@@ -0,0 +1,153 @@
+#include "reaching.h"
+
+#include "utils/mallocs.h"
+
+
+// определения вершины (gen) и все определения переменных, в которые она пишет (kill), по номеру вершины - 1
+struct reaching_context {
+
+    struct bitset * gen;
+    struct bitset * kill;
+};
+
+// out = gen ∪ (in \ kill)
+static void transfer(const struct flow_graph_node * node, const struct bitset * input, struct bitset * output, void * context) {
+    const struct reaching_context * const reaching = context;
+    const size_t i = node->index - 1;
+
+    bitset_copy(output, input);
+    bitset_subtract(output, &reaching->kill[i]);
+    bitset_union(output, &reaching->gen[i]);
+}
+
+static void append_definition(
+        struct flow_graph_reaching * reaching,
+        size_t * capacity,
+        const struct flow_graph_node * node,
+        const struct flow_graph_local * local
+) {
+    if (reaching->size >= *capacity) {
+        *capacity *= 2;
+        reaching->definitions = reallocs(reaching->definitions, sizeof(struct flow_graph_definition) * *capacity);
+    }
+
+    reaching->definitions[reaching->size++] = (struct flow_graph_definition) {
+        .node = node,
+        .local = local,
+    };
+}
+
+struct flow_graph_reaching flow_graph_reaching_build(const struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const struct flow_graph_local_list * const locals = &subroutine->locals;
+
+    size_t capacity = 16;
+
+    struct flow_graph_reaching result = {
+        .size = 0,
+        .definitions = mallocs(sizeof(struct flow_graph_definition) * capacity),
+    };
+
+    // аргументы определены на входе в подпрограмму
+    for (size_t i = 0; i < subroutine->args_num; ++i) {
+        append_definition(&result, &capacity, NULL, locals->values[i]);
+    }
+
+    // переменные, в которые пишет каждая вершина; нужны и для нумерации определений, и для kill
+
+    struct bitset * const defs = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1));
+    struct bitset uses = bitset_init(locals->size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        defs[i] = bitset_init(locals->size);
+
+        const struct flow_graph_expr * const expr = flow_graph_node_get_expr(nodes->values[i]);
+
+        if (expr) {
+            flow_graph_dataflow_accesses(expr, &uses, &defs[i]);
+        }
+
+        for (size_t j = 0; j < locals->size; ++j) {
+            if (bitset_test(&defs[i], j)) {
+                append_definition(&result, &capacity, nodes->values[i], locals->values[j]);
+            }
+        }
+    }
+
+    bitset_fini(&uses);
+
+    // определения каждой переменной
+
+    struct bitset * const local_definitions = mallocs(sizeof(struct bitset) * (locals->size ? locals->size : 1));
+
+    for (size_t j = 0; j < locals->size; ++j) {
+        local_definitions[j] = bitset_init(result.size);
+    }
+
+    for (size_t k = 0; k < result.size; ++k) {
+        bitset_set(&local_definitions[result.definitions[k].local->index - 1], k);
+    }
+
+    struct reaching_context context = {
+        .gen = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+        .kill = mallocs(sizeof(struct bitset) * (nodes->size ? nodes->size : 1)),
+    };
+
+    for (size_t i = 0, k = subroutine->args_num; i < nodes->size; ++i) {
+        context.gen[i] = bitset_init(result.size);
+        context.kill[i] = bitset_init(result.size);
+
+        for (size_t j = 0; j < locals->size; ++j) {
+            if (bitset_test(&defs[i], j)) {
+                bitset_set(&context.gen[i], k++);
+                bitset_union(&context.kill[i], &local_definitions[j]);
+            }
+        }
+
+        bitset_fini(&defs[i]);
+    }
+
+    free(defs);
+
+    struct bitset boundary = bitset_init(result.size);
+
+    for (size_t k = 0; k < subroutine->args_num; ++k) {
+        bitset_set(&boundary, k);
+    }
+
+    const struct flow_graph_dataflow_problem problem = {
+        .direction = FLOW_GRAPH_DATAFLOW_DIRECTION_FORWARD,
+        .meet = FLOW_GRAPH_DATAFLOW_MEET_UNION,
+        .bits = result.size,
+        .boundary = &boundary,
+        .transfer = transfer,
+        .context = &context,
+    };
+
+    result.result = flow_graph_dataflow_solve(subroutine, &problem);
+
+    bitset_fini(&boundary);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        bitset_fini(&context.gen[i]);
+        bitset_fini(&context.kill[i]);
+    }
+
+    free(context.gen);
+    free(context.kill);
+
+    for (size_t j = 0; j < locals->size; ++j) {
+        bitset_fini(&local_definitions[j]);
+    }
+
+    free(local_definitions);
+
+    return result;
+}
+
+void flow_graph_reaching_fini(struct flow_graph_reaching * reaching) {
+    flow_graph_dataflow_result_fini(&reaching->result);
+    free(reaching->definitions);
+
+    *reaching = (struct flow_graph_reaching) { 0 };
+}
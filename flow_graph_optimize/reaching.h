@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dataflow.h"
+
+
+// определение — запись в локальную переменную; node равен NULL для значения аргумента на входе
+struct flow_graph_definition {
+
+    const struct flow_graph_node * node;
+    const struct flow_graph_local * local;
+};
+
+// достигающие определения: биты множеств — номера в definitions; если вершина пишет в переменную
+// несколько раз, её определением считается последняя запись
+struct flow_graph_reaching {
+
+    size_t size;
+    struct flow_graph_definition * definitions;
+
+    struct flow_graph_dataflow_result result;
+};
+
+struct flow_graph_reaching flow_graph_reaching_build(const struct flow_graph_subroutine * subroutine);
+void flow_graph_reaching_fini(struct flow_graph_reaching * reaching);
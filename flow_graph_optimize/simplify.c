@@ -0,0 +1,366 @@
+#include "passes.h"
+
+#include <stdlib.h>
+
+#include "utils/mallocs.h"
+
+
+// продвижение переходов по циклу из условий, проверяющих одно и то же, может не сойтись,
+// поэтому число кругов упрощения ограничено
+#define ROUNDS_MAX 16
+
+static bool is_nop(const struct flow_graph_node * node) {
+    return node->_type == FLOW_GRAPH_NODE_TYPE_EXPR && !node->expr.expr && node->expr.next;
+}
+
+static bool is_return_void(const struct flow_graph_node * node) {
+    return node->_type == FLOW_GRAPH_NODE_TYPE_EXPR && !node->expr.expr && !node->expr.next;
+}
+
+static bool get_bool_literal(const struct flow_graph_expr * expr, bool * value) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL || expr->literal.literal->_type != FLOW_GRAPH_LITERAL_TYPE_BOOL) {
+        return false;
+    }
+
+    *value = expr->literal.literal->_bool.value;
+    return true;
+}
+
+static const struct flow_graph_expr * get_negated(const struct flow_graph_expr * expr) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_UNARY || expr->unary.op != FLOW_GRAPH_EXPR_UNARY_OP_NOT) {
+        return NULL;
+    }
+
+    return expr->unary.value;
+}
+
+// значение условия test, если оно следует из того, что только что вычисленное условие cond равно value;
+// cond равно NULL, если о нём ничего не известно
+static bool get_known_value(
+        const struct flow_graph_expr * test,
+        const struct flow_graph_expr * cond,
+        bool value,
+        bool * result
+) {
+    if (get_bool_literal(test, result)) {
+        return true;
+    }
+
+    if (!cond) {
+        return false;
+    }
+
+    if (flow_graph_expr_equals(test, cond)) {
+        *result = value;
+        return true;
+    }
+
+    const struct flow_graph_expr * const negated_test = get_negated(test);
+
+    if (negated_test && flow_graph_expr_equals(negated_test, cond)) {
+        *result = !value;
+        return true;
+    }
+
+    const struct flow_graph_expr * const negated_cond = get_negated(cond);
+
+    if (negated_cond && flow_graph_expr_equals(test, negated_cond)) {
+        *result = !value;
+        return true;
+    }
+
+    return false;
+}
+
+// конечная цель перехода: пропускаются пустые вершины и условия, результат которых известен;
+// NULL допустим только как цель условного перехода, для вершины-выражения он означает возврат её значения
+static struct flow_graph_node * thread(
+        struct flow_graph_node * target,
+        bool cond_edge,
+        const struct flow_graph_expr * cond,
+        bool value,
+        size_t limit
+) {
+    for (size_t i = 0; target && i < limit; ++i) {
+        struct flow_graph_node * next;
+
+        if (is_nop(target)) {
+            next = target->expr.next;
+        } else if (cond_edge && is_return_void(target)) {
+            next = NULL;
+        } else {
+            bool known;
+
+            if (target->_type != FLOW_GRAPH_NODE_TYPE_COND
+                    || !flow_graph_expr_is_pure(target->cond.cond)
+                    || !get_known_value(target->cond.cond, cond, value, &known)) {
+                break;
+            }
+
+            next = known ? target->cond.then_next : target->cond.else_next;
+        }
+
+        if (!next && !cond_edge) {
+            break;
+        }
+
+        target = next;
+    }
+
+    return target;
+}
+
+static bool update_edge(struct flow_graph_node ** edge, struct flow_graph_node * target) {
+    if (*edge == target) {
+        return false;
+    }
+
+    *edge = target;
+    return true;
+}
+
+static bool thread_jumps(struct flow_graph_subroutine * subroutine) {
+    const size_t limit = subroutine->nodes.size;
+    bool result = false;
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                if (node->expr.next) {
+                    result = update_edge(&node->expr.next, thread(node->expr.next, false, NULL, false, limit)) || result;
+                }
+
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND: {
+                // повторная проверка того же условия сразу после перехода даёт тот же результат,
+                // только если условие не имеет побочных эффектов
+                const struct flow_graph_expr * const cond =
+                        flow_graph_expr_is_pure(node->cond.cond) ? node->cond.cond : NULL;
+
+                result = update_edge(&node->cond.then_next, thread(node->cond.then_next, true, cond, true, limit))
+                         || result;
+                result = update_edge(&node->cond.else_next, thread(node->cond.else_next, true, cond, false, limit))
+                         || result;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void make_expr(struct flow_graph_node * node, struct flow_graph_expr * expr, struct flow_graph_node * next) {
+    node->_type = FLOW_GRAPH_NODE_TYPE_EXPR;
+    node->expr.expr = expr;
+    node->expr.next = next;
+}
+
+// условие с известным результатом или с одинаковыми ветками заменяется переходом
+static bool fold_conds(struct flow_graph_subroutine * subroutine) {
+    bool result = false;
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        if (node->_type != FLOW_GRAPH_NODE_TYPE_COND) {
+            continue;
+        }
+
+        struct flow_graph_expr * const cond = node->cond.cond;
+        struct flow_graph_node * const then_next = node->cond.then_next;
+        struct flow_graph_node * const else_next = node->cond.else_next;
+
+        bool value;
+
+        if (get_bool_literal(cond, &value)) {
+            flow_graph_expr_delete(cond);
+            make_expr(node, NULL, value ? then_next : else_next);
+        } else if (then_next == else_next && flow_graph_expr_is_pure(cond)) {
+            flow_graph_expr_delete(cond);
+            make_expr(node, NULL, then_next);
+        } else if (then_next == else_next && then_next) {
+            // условие вычисляется ради побочных эффектов, его значение выбрасывается
+            make_expr(node, cond, then_next);
+        } else {
+            continue;
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+// первая вершина подпрограммы не может быть пропущена переходом, вместо неё входом становится её цель
+static bool skip_entry_nops(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    struct flow_graph_node * target = nodes->values[0];
+
+    for (size_t i = 0; i < nodes->size && is_nop(target); ++i) {
+        target = target->expr.next;
+    }
+
+    if (target == nodes->values[0] || is_nop(target)) {
+        return false;
+    }
+
+    const size_t position = target->index - 1;
+
+    nodes->values[position] = nodes->values[0];
+    nodes->values[0] = target;
+
+    return true;
+}
+
+struct tail {
+
+    struct flow_graph_node * node;
+    size_t hash;
+};
+
+static size_t get_index(const struct flow_graph_node * node) {
+    return node ? node->index : 0;
+}
+
+static void get_successors(const struct flow_graph_node * node, size_t * successors) {
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            successors[0] = get_index(node->expr.next);
+            successors[1] = 0;
+            break;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            successors[0] = get_index(node->cond.then_next);
+            successors[1] = get_index(node->cond.else_next);
+            break;
+    }
+}
+
+static int compare_size(size_t lhs, size_t rhs) {
+    return lhs < rhs ? -1 : lhs > rhs ? 1 : 0;
+}
+
+// ключ без номера самой вершины: кандидаты на слияние оказываются рядом
+static int tail_key_cmp(const struct tail * lhs, const struct tail * rhs) {
+    int result = compare_size(lhs->node->_type, rhs->node->_type);
+
+    size_t lhs_successors[2];
+    size_t rhs_successors[2];
+
+    get_successors(lhs->node, lhs_successors);
+    get_successors(rhs->node, rhs_successors);
+
+    for (size_t i = 0; result == 0 && i < 2; ++i) {
+        result = compare_size(lhs_successors[i], rhs_successors[i]);
+    }
+
+    return result ? result : compare_size(lhs->hash, rhs->hash);
+}
+
+static int tail_cmp(const void * lhs_ptr, const void * rhs_ptr) {
+    const struct tail * const lhs = lhs_ptr;
+    const struct tail * const rhs = rhs_ptr;
+
+    const int result = tail_key_cmp(lhs, rhs);
+    return result ? result : compare_size(lhs->node->index, rhs->node->index);
+}
+
+static void replace_edge(struct flow_graph_node ** edge, struct flow_graph_node ** replacements) {
+    if (*edge) {
+        *edge = replacements[(*edge)->index - 1];
+    }
+}
+
+// вершины с одинаковым выражением и одинаковыми переходами сливаются в одну с меньшим номером,
+// поэтому вход подпрограммы всегда сохраняется
+static bool merge_tails(struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    struct tail * const tails = mallocs(sizeof(struct tail) * nodes->size);
+    struct flow_graph_node ** const replacements = mallocs(sizeof(struct flow_graph_node *) * nodes->size);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const node = nodes->values[i];
+
+        tails[i] = (struct tail) {
+            .node = node,
+            .hash = flow_graph_expr_hash(flow_graph_node_get_expr(node)),
+        };
+
+        replacements[node->index - 1] = node;
+    }
+
+    qsort(tails, nodes->size, sizeof(struct tail), tail_cmp);
+
+    bool result = false;
+
+    for (size_t begin = 0, end; begin < nodes->size; begin = end) {
+        for (end = begin + 1; end < nodes->size && tail_key_cmp(&tails[begin], &tails[end]) == 0; ++end) {}
+
+        // совпадение ключа означает совпадение хешей, выражения сравниваются попарно
+        for (size_t i = begin; i < end; ++i) {
+            struct flow_graph_node * const node = tails[i].node;
+            const struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+            if (replacements[node->index - 1] != node) {
+                continue;
+            }
+
+            for (size_t j = i + 1; j < end; ++j) {
+                struct flow_graph_node * const other = tails[j].node;
+
+                if (replacements[other->index - 1] == other && flow_graph_expr_equals(expr, flow_graph_node_get_expr(other))) {
+                    replacements[other->index - 1] = node;
+                    result = true;
+                }
+            }
+        }
+    }
+
+    if (result) {
+        for (size_t i = 0; i < nodes->size; ++i) {
+            struct flow_graph_node * const node = nodes->values[i];
+
+            switch (node->_type) {
+                case FLOW_GRAPH_NODE_TYPE_EXPR:
+                    replace_edge(&node->expr.next, replacements);
+                    break;
+
+                case FLOW_GRAPH_NODE_TYPE_COND:
+                    replace_edge(&node->cond.then_next, replacements);
+                    replace_edge(&node->cond.else_next, replacements);
+                    break;
+            }
+        }
+    }
+
+    free(replacements);
+    free(tails);
+
+    return result;
+}
+
+bool flow_graph_optimize_simplify(struct flow_graph_subroutine * subroutine) {
+    bool result = false;
+
+    for (size_t round = 0; round < ROUNDS_MAX; ++round) {
+        bool changed = thread_jumps(subroutine);
+        changed = fold_conds(subroutine) || changed;
+        changed = merge_tails(subroutine) || changed;
+
+        // перестановка входа нарушает соответствие номеров позициям, поэтому идёт последней
+        changed = skip_entry_nops(subroutine) || changed;
+
+        if (!changed) {
+            break;
+        }
+
+        flow_graph_subroutine_renumber(subroutine);
+        result = true;
+    }
+
+    return result;
+}
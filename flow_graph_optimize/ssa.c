@@ -0,0 +1,972 @@
+#include "ssa.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dominators.h"
+#include "liveness.h"
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+static struct flow_graph_local * get_origin(struct flow_graph_local * local) {
+    return local->origin ? local->origin : local;
+}
+
+// версия называется по исходной переменной и своему номеру среди переменных подпрограммы
+static struct flow_graph_local * new_version(struct flow_graph_subroutine * subroutine, struct flow_graph_local * origin) {
+    char * const id = mallocs(strlen(origin->id) + 22);
+    sprintf(id, "%s.%zu", origin->id, subroutine->locals.size + 1);
+
+    struct flow_graph_local * const result =
+            flow_graph_local_new(id, ast_type_reference_clone(origin->type), origin->position);
+
+    result->origin = origin;
+    return flow_graph_subroutine_add_local(subroutine, result);
+}
+
+static void ensure_entry_without_predecessors(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    struct flow_graph_node * const entry = nodes->values[0];
+
+    bool found = false;
+
+    for (size_t i = 0; i < nodes->size && !found; ++i) {
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(nodes->values[i], successors);
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            found = found || successors[k] == entry;
+        }
+    }
+
+    if (!found) {
+        return;
+    }
+
+    struct flow_graph_node * const node = flow_graph_node_new_expr(entry->position, NULL);
+    node->expr.next = entry;
+
+    flow_graph_node_list_append(nodes, node);
+
+    nodes->values[nodes->size - 1] = entry;
+    nodes->values[0] = node;
+
+    flow_graph_subroutine_renumber(subroutine);
+}
+
+struct access {
+
+    struct flow_graph_local * local;
+    bool write;
+};
+
+// обращения всех вершин одним массивом: обращения вершины с номером i лежат в values
+// с offsets[i - 1] по offsets[i] не включительно, в порядке вычисления
+struct accesses {
+
+    size_t size;
+    size_t capacity;
+    struct access * values;
+
+    size_t * offsets;
+};
+
+static void collect_access(struct flow_graph_expr * local, bool write, void * context) {
+    struct accesses * const accesses = context;
+
+    if (accesses->size >= accesses->capacity) {
+        accesses->capacity = accesses->capacity ? accesses->capacity * 2 : 16;
+        accesses->values = reallocs(accesses->values, sizeof(struct access) * accesses->capacity);
+    }
+
+    accesses->values[accesses->size++] = (struct access) { .local = local->local.local, .write = write };
+}
+
+static struct accesses collect_accesses(const struct flow_graph_node_list * nodes) {
+    struct accesses result = {
+        .size = 0,
+        .capacity = 0,
+        .values = NULL,
+        .offsets = mallocs(sizeof(size_t) * (nodes->size + 1)),
+    };
+
+    result.offsets[0] = 0;
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(nodes->values[i]);
+
+        if (expr) {
+            flow_graph_expr_visit_locals(expr, collect_access, &result);
+        }
+
+        result.offsets[i + 1] = result.size;
+    }
+
+    return result;
+}
+
+static void accesses_fini(struct accesses * accesses) {
+    free(accesses->values);
+    free(accesses->offsets);
+}
+
+enum occurrence_kind {
+
+    OCCURRENCE_READ = 0,
+    // чтение до записи в той же вершине: переменная живая на входе в вершину
+    OCCURRENCE_EXPOSED_READ,
+    OCCURRENCE_WRITE,
+    OCCURRENCE_KINDS,
+};
+
+// номера - 1 вершин, в которых встречается переменная, по её номеру - 1, каждая вершина по разу;
+// списки строятся в два прохода: сначала считаются размеры, потом заполняются
+struct occurrences {
+
+    size_t * offsets;
+    size_t * values;
+    // следующее свободное место при заполнении и последняя добавленная вершина + 1
+    size_t * cursors;
+    size_t * last;
+};
+
+static struct occurrences occurrences_init(size_t locals_size) {
+    struct occurrences result = {
+        .offsets = mallocs(sizeof(size_t) * (locals_size + 1)),
+        .values = NULL,
+        .cursors = NULL,
+        .last = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1)),
+    };
+
+    memset(result.offsets, 0, sizeof(size_t) * (locals_size + 1));
+    memset(result.last, 0, sizeof(size_t) * locals_size);
+
+    return result;
+}
+
+static void occurrences_add(struct occurrences * occurrences, size_t local, size_t node) {
+    if (occurrences->last[local] == node + 1) {
+        return;
+    }
+
+    occurrences->last[local] = node + 1;
+
+    if (occurrences->values) {
+        occurrences->values[occurrences->cursors[local]++] = node;
+    } else {
+        ++occurrences->offsets[local + 1];
+    }
+}
+
+static void occurrences_prepare(struct occurrences * occurrences, size_t locals_size) {
+    for (size_t i = 0; i < locals_size; ++i) {
+        occurrences->offsets[i + 1] += occurrences->offsets[i];
+    }
+
+    occurrences->values = mallocs(sizeof(size_t) * (occurrences->offsets[locals_size] + 1));
+    occurrences->cursors = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+
+    memcpy(occurrences->cursors, occurrences->offsets, sizeof(size_t) * locals_size);
+    memset(occurrences->last, 0, sizeof(size_t) * locals_size);
+}
+
+static void add_occurrences(
+        const struct accesses * accesses,
+        size_t nodes_size,
+        size_t locals_size,
+        struct occurrences * occurrences
+) {
+    // вершина + 1, в которой была последняя запись в переменную
+    size_t * const written = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memset(written, 0, sizeof(size_t) * locals_size);
+
+    for (size_t i = 0; i < nodes_size; ++i) {
+        for (size_t k = accesses->offsets[i]; k < accesses->offsets[i + 1]; ++k) {
+            const struct access * const access = &accesses->values[k];
+            const size_t v = access->local->index - 1;
+
+            if (access->write) {
+                occurrences_add(&occurrences[OCCURRENCE_WRITE], v, i);
+                written[v] = i + 1;
+                continue;
+            }
+
+            occurrences_add(&occurrences[OCCURRENCE_READ], v, i);
+
+            if (written[v] != i + 1) {
+                occurrences_add(&occurrences[OCCURRENCE_EXPOSED_READ], v, i);
+            }
+        }
+    }
+    free(written);
+}
+
+static void build_occurrences(
+        const struct accesses * accesses,
+        size_t nodes_size,
+        size_t locals_size,
+        struct occurrences * occurrences
+) {
+    for (size_t kind = 0; kind < OCCURRENCE_KINDS; ++kind) {
+        occurrences[kind] = occurrences_init(locals_size);
+    }
+
+    add_occurrences(accesses, nodes_size, locals_size, occurrences);
+
+    for (size_t kind = 0; kind < OCCURRENCE_KINDS; ++kind) {
+        occurrences_prepare(&occurrences[kind], locals_size);
+    }
+
+    add_occurrences(accesses, nodes_size, locals_size, occurrences);
+}
+
+static void occurrences_fini(struct occurrences * occurrences) {
+    free(occurrences->offsets);
+    free(occurrences->values);
+    free(occurrences->cursors);
+    free(occurrences->last);
+}
+
+// фи-функции ставятся в итерированной границе доминирования вершин, которые пишут в переменную,
+// но только там, где переменная живая; аргументы пока без значений, по одному на входящую дугу
+static void place_phis(
+        struct flow_graph_subroutine * subroutine,
+        const struct flow_graph_dominators * dominators,
+        const struct flow_graph_predecessors * predecessors
+) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t locals_size = subroutine->locals.size;
+
+    struct flow_graph_dataflow_result liveness = flow_graph_liveness_build(subroutine);
+
+    struct accesses accesses = collect_accesses(nodes);
+    struct occurrences occurrences[OCCURRENCE_KINDS];
+
+    build_occurrences(&accesses, nodes->size, locals_size, occurrences);
+
+    const struct occurrences * const writes = &occurrences[OCCURRENCE_WRITE];
+
+    // отметки номером переменной + 1 не нужно сбрасывать между переменными
+    size_t * const has_phi = mallocs(sizeof(size_t) * nodes->size);
+    size_t * const queued = mallocs(sizeof(size_t) * nodes->size);
+
+    memset(has_phi, 0, sizeof(size_t) * nodes->size);
+    memset(queued, 0, sizeof(size_t) * nodes->size);
+
+    struct stack worklist = stack_init();
+
+    for (size_t v = 0; v < locals_size; ++v) {
+        const size_t mark = v + 1;
+
+        for (size_t k = writes->offsets[v]; k < writes->offsets[v + 1]; ++k) {
+            queued[writes->values[k]] = mark;
+            stack_push(&worklist, nodes->values[writes->values[k]]);
+        }
+
+        while (worklist.size > 0) {
+            const struct flow_graph_node * const node = stack_pop(&worklist);
+            const size_t i = node->index - 1;
+
+            for (size_t k = dominators->frontier_offsets[i]; k < dominators->frontier_offsets[i + 1]; ++k) {
+                struct flow_graph_node * const join = dominators->frontiers[k];
+                const size_t j = join->index - 1;
+
+                if (has_phi[j] == mark || !bitset_test(&liveness.in[j], v)) {
+                    continue;
+                }
+
+                has_phi[j] = mark;
+
+                struct flow_graph_phi * const phi = flow_graph_phi_new(subroutine->locals.values[v]);
+
+                for (size_t p = predecessors->offsets[j]; p < predecessors->offsets[j + 1]; ++p) {
+                    flow_graph_phi_append(phi, predecessors->values[p], NULL);
+                }
+
+                flow_graph_phi_list_append(&join->phis, phi);
+
+                if (queued[j] != mark) {
+                    queued[j] = mark;
+                    stack_push(&worklist, join);
+                }
+            }
+        }
+    }
+
+    stack_fini(&worklist);
+    free(queued);
+    free(has_phi);
+
+    for (size_t kind = 0; kind < OCCURRENCE_KINDS; ++kind) {
+        occurrences_fini(&occurrences[kind]);
+    }
+
+    accesses_fini(&accesses);
+    flow_graph_dataflow_result_fini(&liveness);
+}
+
+struct rename_context {
+
+    struct flow_graph_subroutine * subroutine;
+
+    // текущие версии по номеру исходной переменной - 1; до первой записи версией служит сама переменная
+    struct flow_graph_local ** versions;
+    // пары (исходная переменная, её прежняя версия) в порядке записей, чтобы вернуть версии
+    // при выходе из вершины
+    struct stack log;
+};
+
+static struct flow_graph_local * current_version(const struct rename_context * context, struct flow_graph_local * origin) {
+    return context->versions[origin->index - 1];
+}
+
+static struct flow_graph_local * push_version(struct rename_context * context, struct flow_graph_local * origin) {
+    struct flow_graph_local * const result = new_version(context->subroutine, origin);
+
+    stack_push(&context->log, origin);
+    stack_push(&context->log, context->versions[origin->index - 1]);
+    context->versions[origin->index - 1] = result;
+
+    return result;
+}
+
+static void rename_access(struct flow_graph_expr * local, bool write, void * context) {
+    struct flow_graph_local * const origin = get_origin(local->local.local);
+
+    local->local.local = write ? push_version(context, origin) : current_version(context, origin);
+}
+
+static void rename_node(struct rename_context * context, struct flow_graph_node * node) {
+    for (size_t i = 0; i < node->phis.size; ++i) {
+        struct flow_graph_phi * const phi = node->phis.values[i];
+        phi->target = push_version(context, phi->target);
+    }
+
+    struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+    if (expr) {
+        flow_graph_expr_visit_locals(expr, rename_access, context);
+    }
+
+    // если обе ветки условия ведут в одну вершину, каждая заполняет свой аргумент
+    struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+    const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+    for (size_t k = 0; k < successors_size; ++k) {
+        const struct flow_graph_phi_list * const phis = &successors[k]->phis;
+
+        for (size_t i = 0; i < phis->size; ++i) {
+            struct flow_graph_phi * const phi = phis->values[i];
+
+            for (size_t j = 0; j < phi->size; ++j) {
+                if (phi->args[j].predecessor == node && !phi->args[j].value) {
+                    phi->args[j].value = current_version(context, get_origin(phi->target));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// обход дерева доминаторов в глубину: в вершине видны версии, записанные в её доминаторах
+static void rename_versions(struct flow_graph_subroutine * subroutine, const struct flow_graph_dominators * dominators) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t locals_size = subroutine->locals.size;
+
+    struct rename_context context = {
+        .subroutine = subroutine,
+        .versions = mallocs(sizeof(struct flow_graph_local *) * (locals_size ? locals_size : 1)),
+        .log = stack_init(),
+    };
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        context.versions[i] = subroutine->locals.values[i];
+    }
+
+    size_t * const marks = mallocs(sizeof(size_t) * nodes->size);
+    bool * const visited = mallocs(sizeof(bool) * nodes->size);
+    memset(visited, 0, sizeof(bool) * nodes->size);
+
+    struct stack stack = stack_init();
+    stack_push(&stack, nodes->values[0]);
+
+    while (stack.size > 0) {
+        struct flow_graph_node * const node = stack.values[stack.size - 1];
+        const size_t i = node->index - 1;
+
+        if (!visited[i]) {
+            visited[i] = true;
+            marks[i] = context.log.size;
+
+            rename_node(&context, node);
+
+            for (size_t k = dominators->children_offsets[i + 1]; k > dominators->children_offsets[i]; --k) {
+                stack_push(&stack, dominators->children[k - 1]);
+            }
+
+            continue;
+        }
+
+        stack_pop(&stack);
+
+        while (context.log.size > marks[i]) {
+            struct flow_graph_local * const previous = stack_pop(&context.log);
+            const struct flow_graph_local * const origin = stack_pop(&context.log);
+
+            context.versions[origin->index - 1] = previous;
+        }
+    }
+
+    stack_fini(&stack);
+    free(visited);
+    free(marks);
+
+    stack_fini(&context.log);
+    free(context.versions);
+}
+
+void flow_graph_ssa_build(struct flow_graph_subroutine * subroutine) {
+    if (subroutine->nodes.size == 0) {
+        return;
+    }
+
+    ensure_entry_without_predecessors(subroutine);
+
+    struct flow_graph_dominators dominators = flow_graph_dominators_build(subroutine);
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(&subroutine->nodes);
+
+    place_phis(subroutine, &dominators, &predecessors);
+    rename_versions(subroutine, &dominators);
+
+    flow_graph_predecessors_fini(&predecessors);
+    flow_graph_dominators_fini(&dominators);
+}
+
+static struct flow_graph_node * new_copy(
+        struct flow_graph_subroutine * subroutine,
+        struct position position,
+        struct flow_graph_local * target,
+        struct flow_graph_local * value,
+        struct flow_graph_node * next
+) {
+    struct flow_graph_expr * const expr = flow_graph_expr_new_binary(
+            position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_typed_local(position, target),
+            flow_graph_expr_new_typed_local(position, value)
+    );
+
+    expr->type = ast_type_reference_clone(target->type);
+
+    struct flow_graph_node * const result = flow_graph_node_new_expr(position, expr);
+    result->expr.next = next;
+
+    flow_graph_node_list_append(&subroutine->nodes, result);
+    result->index = subroutine->nodes.size;
+
+    return result;
+}
+
+// переменная, из которой копирует вершина вида local = local, или NULL
+static struct flow_graph_local * get_copy_source(const struct flow_graph_node * node) {
+    if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || !node->expr.expr) {
+        return NULL;
+    }
+
+    const struct flow_graph_expr * const expr = node->expr.expr;
+
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+            || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+            || expr->binary.lhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL
+            || expr->binary.rhs->_type != FLOW_GRAPH_EXPR_TYPE_LOCAL) {
+        return NULL;
+    }
+
+    return expr->binary.rhs->local.local;
+}
+
+// первая из дуг предшественника, ведущих в from, перенаправляется в to
+static void redirect_edge(struct flow_graph_node * predecessor, struct flow_graph_node * from, struct flow_graph_node * to) {
+    switch (predecessor->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            predecessor->expr.next = to;
+            break;
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            if (predecessor->cond.then_next == from) {
+                predecessor->cond.then_next = to;
+            } else {
+                predecessor->cond.else_next = to;
+            }
+
+            break;
+    }
+}
+
+// на каждой входящей дуге значения аргументов копируются в новые переменные, а в начале вершины
+// из них — в цели фи-функций; копирования на дуге читают только старые версии, а в начале вершины
+// пишут только цели, поэтому фи-функции остаются одновременными при любом порядке копирований;
+// аргументы всех фи-функций вершины идут в одном порядке дуг
+static void lower_phis(struct flow_graph_subroutine * subroutine, struct flow_graph_node * node) {
+    const struct flow_graph_phi_list * const phis = &node->phis;
+
+    struct flow_graph_local ** const temps = mallocs(sizeof(struct flow_graph_local *) * phis->size);
+    struct flow_graph_node * head = node;
+
+    for (size_t i = phis->size; i > 0; --i) {
+        struct flow_graph_phi * const phi = phis->values[i - 1];
+
+        temps[i - 1] = new_version(subroutine, get_origin(phi->target));
+        head = new_copy(subroutine, node->position, phi->target, temps[i - 1], head);
+    }
+
+    const size_t edges_size = phis->values[0]->size;
+
+    for (size_t k = 0; k < edges_size; ++k) {
+        struct flow_graph_node * edge_head = head;
+
+        for (size_t i = phis->size; i > 0; --i) {
+            edge_head = new_copy(subroutine, node->position, temps[i - 1], phis->values[i - 1]->args[k].value, edge_head);
+        }
+
+        redirect_edge(phis->values[0]->args[k].predecessor, node, edge_head);
+    }
+
+    free(temps);
+
+    flow_graph_phi_list_fini(&node->phis);
+    node->phis = flow_graph_phi_list_init();
+}
+
+// пересечения времён жизни: соседи переменной по её номеру - 1, возможно с повторами;
+// ищутся только между версиями одной исходной переменной, потому что сливаться могут только они
+struct interference_search {
+
+    const struct flow_graph_node_list * nodes;
+    const struct flow_graph_predecessors * predecessors;
+    const struct accesses * accesses;
+    struct occurrences occurrences[OCCURRENCE_KINDS];
+
+    // отметки номером переменной + 1 для вершин, которые в неё пишут, в которых она живая
+    // на входе или на выходе, и которые уже просмотрены
+    size_t * written;
+    size_t * live_in;
+    size_t * live_out;
+    size_t * scanned;
+
+    struct stack worklist;
+    struct stack live_out_nodes;
+
+    // пересекающиеся переменные парами подряд
+    struct stack pairs;
+};
+
+// соседи переменной с номером i в графе пересечений лежат в values с offsets[i - 1] по offsets[i]
+struct interferences {
+
+    size_t * offsets;
+    struct flow_graph_local ** values;
+};
+
+// запись в другую версию той же переменной, пока переменная живая, означает пересечение,
+// если только это не копирование из неё самой; обращения просматриваются с конца вершины
+static void scan_node(struct interference_search * search, struct flow_graph_local * local, const struct flow_graph_node * node) {
+    const size_t i = node->index - 1;
+    const size_t mark = local->index;
+
+    const struct flow_graph_local * const source = get_copy_source(node);
+    const struct flow_graph_local * const target = source ? node->expr.expr->binary.lhs->local.local : NULL;
+
+    bool live = search->live_out[i] == mark;
+
+    for (size_t k = search->accesses->offsets[i + 1]; k > search->accesses->offsets[i]; --k) {
+        const struct access * const access = &search->accesses->values[k - 1];
+        struct flow_graph_local * const other = access->local;
+
+        if (other == local) {
+            live = !access->write;
+            continue;
+        }
+
+        if (!access->write || !live || get_origin(other) != get_origin(local) || (source == local && target == other)) {
+            continue;
+        }
+
+        stack_push(&search->pairs, local);
+        stack_push(&search->pairs, other);
+    }
+}
+
+// живость одной переменной обходом назад от вершин, где она читается до записи, до вершин, которые в неё пишут
+static void search_local(struct interference_search * search, struct flow_graph_local * local) {
+    const size_t v = local->index - 1;
+    const size_t mark = local->index;
+
+    const struct occurrences * const writes = &search->occurrences[OCCURRENCE_WRITE];
+    const struct occurrences * const exposed = &search->occurrences[OCCURRENCE_EXPOSED_READ];
+    const struct occurrences * const reads = &search->occurrences[OCCURRENCE_READ];
+
+    for (size_t k = writes->offsets[v]; k < writes->offsets[v + 1]; ++k) {
+        search->written[writes->values[k]] = mark;
+    }
+
+    for (size_t k = exposed->offsets[v]; k < exposed->offsets[v + 1]; ++k) {
+        search->live_in[exposed->values[k]] = mark;
+        stack_push(&search->worklist, search->nodes->values[exposed->values[k]]);
+    }
+
+    search->live_out_nodes.size = 0;
+
+    while (search->worklist.size > 0) {
+        const struct flow_graph_node * const node = stack_pop(&search->worklist);
+        const size_t i = node->index - 1;
+
+        for (size_t k = search->predecessors->offsets[i]; k < search->predecessors->offsets[i + 1]; ++k) {
+            struct flow_graph_node * const predecessor = search->predecessors->values[k];
+            const size_t j = predecessor->index - 1;
+
+            if (search->live_out[j] != mark) {
+                search->live_out[j] = mark;
+                stack_push(&search->live_out_nodes, predecessor);
+            }
+
+            if (search->written[j] != mark && search->live_in[j] != mark) {
+                search->live_in[j] = mark;
+                stack_push(&search->worklist, predecessor);
+            }
+        }
+    }
+
+    for (size_t k = 0; k < search->live_out_nodes.size; ++k) {
+        const struct flow_graph_node * const node = search->live_out_nodes.values[k];
+
+        search->scanned[node->index - 1] = mark;
+        scan_node(search, local, node);
+    }
+
+    for (size_t k = reads->offsets[v]; k < reads->offsets[v + 1]; ++k) {
+        if (search->scanned[reads->values[k]] != mark) {
+            search->scanned[reads->values[k]] = mark;
+            scan_node(search, local, search->nodes->values[reads->values[k]]);
+        }
+    }
+}
+
+static struct interferences build_interferences(const struct flow_graph_subroutine * subroutine) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+    const size_t locals_size = subroutine->locals.size;
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    struct accesses accesses = collect_accesses(nodes);
+
+    struct interference_search search = {
+        .nodes = nodes,
+        .predecessors = &predecessors,
+        .accesses = &accesses,
+        .written = mallocs(sizeof(size_t) * nodes->size),
+        .live_in = mallocs(sizeof(size_t) * nodes->size),
+        .live_out = mallocs(sizeof(size_t) * nodes->size),
+        .scanned = mallocs(sizeof(size_t) * nodes->size),
+        .worklist = stack_init(),
+        .live_out_nodes = stack_init(),
+        .pairs = stack_init(),
+    };
+
+    build_occurrences(&accesses, nodes->size, locals_size, search.occurrences);
+
+    memset(search.written, 0, sizeof(size_t) * nodes->size);
+    memset(search.live_in, 0, sizeof(size_t) * nodes->size);
+    memset(search.live_out, 0, sizeof(size_t) * nodes->size);
+    memset(search.scanned, 0, sizeof(size_t) * nodes->size);
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        search_local(&search, subroutine->locals.values[i]);
+    }
+
+    struct interferences result = {
+        .offsets = mallocs(sizeof(size_t) * (locals_size + 1)),
+        .values = mallocs(sizeof(struct flow_graph_local *) * (search.pairs.size ? search.pairs.size : 1)),
+    };
+
+    memset(result.offsets, 0, sizeof(size_t) * (locals_size + 1));
+
+    for (size_t k = 0; k < search.pairs.size; ++k) {
+        const struct flow_graph_local * const local = search.pairs.values[k];
+        ++result.offsets[local->index];
+    }
+
+    for (size_t i = 0; i < locals_size; ++i) {
+        result.offsets[i + 1] += result.offsets[i];
+    }
+
+    size_t * const filled = mallocs(sizeof(size_t) * (locals_size ? locals_size : 1));
+    memcpy(filled, result.offsets, sizeof(size_t) * locals_size);
+
+    for (size_t k = 0; k < search.pairs.size; k += 2) {
+        struct flow_graph_local * const lhs = search.pairs.values[k];
+        struct flow_graph_local * const rhs = search.pairs.values[k + 1];
+
+        result.values[filled[lhs->index - 1]++] = rhs;
+        result.values[filled[rhs->index - 1]++] = lhs;
+    }
+
+    free(filled);
+
+    for (size_t kind = 0; kind < OCCURRENCE_KINDS; ++kind) {
+        occurrences_fini(&search.occurrences[kind]);
+    }
+
+    stack_fini(&search.pairs);
+    stack_fini(&search.live_out_nodes);
+    stack_fini(&search.worklist);
+
+    free(search.scanned);
+    free(search.live_out);
+    free(search.live_in);
+    free(search.written);
+
+    accesses_fini(&accesses);
+    flow_graph_predecessors_fini(&predecessors);
+
+    return result;
+}
+
+// классы сливаемых переменных по номеру - 1: переменные класса связаны в список через next,
+// у корня хранятся первая и последняя из них и их число
+struct classes {
+
+    size_t * parents;
+    size_t * next;
+    size_t * first;
+    size_t * last;
+    size_t * sizes;
+};
+
+static size_t find_class(struct classes * classes, size_t i) {
+    size_t root = i;
+
+    while (classes->parents[root] != root) {
+        root = classes->parents[root];
+    }
+
+    while (classes->parents[i] != root) {
+        const size_t next = classes->parents[i];
+        classes->parents[i] = root;
+        i = next;
+    }
+
+    return root;
+}
+
+static bool classes_interfere(
+        struct classes * classes,
+        const struct interferences * interferences,
+        size_t lhs_root,
+        size_t rhs_root
+) {
+    if (classes->sizes[lhs_root] > classes->sizes[rhs_root]) {
+        const size_t root = lhs_root;
+        lhs_root = rhs_root;
+        rhs_root = root;
+    }
+
+    for (size_t i = classes->first[lhs_root]; i != SIZE_MAX; i = classes->next[i]) {
+        for (size_t k = interferences->offsets[i]; k < interferences->offsets[i + 1]; ++k) {
+            const struct flow_graph_local * const neighbour = interferences->values[k];
+
+            if (find_class(classes, neighbour->index - 1) == rhs_root) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// сливаются только версии одной исходной переменной, поэтому в классе не больше одной исходной
+static void try_merge(
+        struct classes * classes,
+        const struct interferences * interferences,
+        struct flow_graph_local * lhs,
+        struct flow_graph_local * rhs
+) {
+    const size_t lhs_root = find_class(classes, lhs->index - 1);
+    const size_t rhs_root = find_class(classes, rhs->index - 1);
+
+    if (lhs_root == rhs_root
+            || get_origin(lhs) != get_origin(rhs)
+            || classes_interfere(classes, interferences, lhs_root, rhs_root)) {
+        return;
+    }
+
+    classes->parents[rhs_root] = lhs_root;
+    classes->next[classes->last[lhs_root]] = classes->first[rhs_root];
+    classes->last[lhs_root] = classes->last[rhs_root];
+    classes->sizes[lhs_root] += classes->sizes[rhs_root];
+}
+
+// каждой переменной сопоставляется переменная её класса: исходная, если она есть, иначе первая по номеру
+static void coalesce(const struct flow_graph_subroutine * subroutine, struct flow_graph_local ** replacements) {
+    const struct flow_graph_local_list * const locals = &subroutine->locals;
+    const size_t size = locals->size ? locals->size : 1;
+
+    struct classes classes = {
+        .parents = mallocs(sizeof(size_t) * size),
+        .next = mallocs(sizeof(size_t) * size),
+        .first = mallocs(sizeof(size_t) * size),
+        .last = mallocs(sizeof(size_t) * size),
+        .sizes = mallocs(sizeof(size_t) * size),
+    };
+
+    for (size_t i = 0; i < locals->size; ++i) {
+        classes.parents[i] = i;
+        classes.next[i] = SIZE_MAX;
+        classes.first[i] = i;
+        classes.last[i] = i;
+        classes.sizes[i] = 1;
+    }
+
+    struct interferences interferences = build_interferences(subroutine);
+
+    // сначала версии возвращаются к исходным переменным, затем сливаются оставшиеся копирования
+    for (size_t i = 0; i < locals->size; ++i) {
+        struct flow_graph_local * const local = locals->values[i];
+
+        if (local->origin) {
+            try_merge(&classes, &interferences, local->origin, local);
+        }
+    }
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        const struct flow_graph_node * const node = subroutine->nodes.values[i];
+        struct flow_graph_local * const source = get_copy_source(node);
+
+        if (source) {
+            try_merge(&classes, &interferences, node->expr.expr->binary.lhs->local.local, source);
+        }
+    }
+
+    for (size_t i = 0; i < locals->size; ++i) {
+        replacements[i] = NULL;
+    }
+
+    for (size_t pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < locals->size; ++i) {
+            const size_t root = find_class(&classes, i);
+
+            if (!replacements[root] && (pass > 0 || !locals->values[i]->origin)) {
+                replacements[root] = locals->values[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < locals->size; ++i) {
+        replacements[i] = replacements[find_class(&classes, i)];
+    }
+
+    free(classes.parents);
+    free(classes.next);
+    free(classes.first);
+    free(classes.last);
+    free(classes.sizes);
+    free(interferences.offsets);
+    free(interferences.values);
+}
+
+static void replace_access(struct flow_graph_expr * local, bool write, void * context) {
+    struct flow_graph_local ** const replacements = context;
+
+    (void) write;
+    local->local.local = replacements[local->local.local->index - 1];
+}
+
+static void mark_access(struct flow_graph_expr * local, bool write, void * context) {
+    bool * const used = context;
+
+    (void) write;
+    used[local->local.local->index - 1] = true;
+}
+
+// исходные переменные остаются на своих местах, версии — только если к ним ещё обращаются;
+// оставшиеся версии становятся обычными переменными подпрограммы
+static void remove_unused_locals(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_local_list * const locals = &subroutine->locals;
+
+    bool * const used = mallocs(sizeof(bool) * locals->size);
+    memset(used, 0, sizeof(bool) * locals->size);
+
+    for (size_t i = 0; i < subroutine->nodes.size; ++i) {
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(subroutine->nodes.values[i]);
+
+        if (expr) {
+            flow_graph_expr_visit_locals(expr, mark_access, used);
+        }
+    }
+
+    size_t size = 0;
+
+    for (size_t i = 0; i < locals->size; ++i) {
+        struct flow_graph_local * const local = locals->values[i];
+
+        if (local->origin && !used[i]) {
+            flow_graph_local_delete(local);
+            continue;
+        }
+
+        local->origin = NULL;
+        local->index = size + 1;
+
+        locals->values[size++] = local;
+    }
+
+    locals->size = size;
+    free(used);
+}
+
+void flow_graph_ssa_destroy(struct flow_graph_subroutine * subroutine) {
+    struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0) {
+        return;
+    }
+
+    const size_t nodes_size = nodes->size;
+
+    for (size_t i = 0; i < nodes_size; ++i) {
+        if (nodes->values[i]->phis.size > 0) {
+            lower_phis(subroutine, nodes->values[i]);
+        }
+    }
+
+    flow_graph_subroutine_renumber(subroutine);
+
+    struct flow_graph_local ** const replacements =
+            mallocs(sizeof(struct flow_graph_local *) * (subroutine->locals.size ? subroutine->locals.size : 1));
+
+    coalesce(subroutine, replacements);
+
+    for (size_t i = 0; i < nodes->size; ++i) {
+        struct flow_graph_node * const node = nodes->values[i];
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+        if (!expr) {
+            continue;
+        }
+
+        flow_graph_expr_visit_locals(expr, replace_access, replacements);
+
+        // копирование внутри одной переменной не нужно, если его значение не возвращается
+        const struct flow_graph_local * const source = get_copy_source(node);
+
+        if (source && node->expr.next && source == expr->binary.lhs->local.local) {
+            flow_graph_expr_delete(expr);
+            node->expr.expr = NULL;
+        }
+    }
+
+    free(replacements);
+    remove_unused_locals(subroutine);
+}
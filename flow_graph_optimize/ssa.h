@@ -0,0 +1,17 @@
+#pragma once
+
+#include "flow_graph.h"
+
+
+// SSA-форма: каждая запись в локальную переменную создаёт новую версию — переменную подпрограммы,
+// origin которой указывает на исходную; в вершинах слияния версии объединяются фи-функциями,
+// которые ставятся только там, где переменная живая. Чтения до первой записи, в том числе
+// аргументов, остаются чтениями исходной переменной. Если во вход подпрограммы ведут дуги,
+// перед ним ставится пустая вершина, чтобы фи-функциям входа было откуда получать значения
+void flow_graph_ssa_build(struct flow_graph_subroutine * subroutine);
+
+// выход из SSA-формы: фи-функции заменяются копированиями на входящих дугах, затем переменные,
+// связанные копированием или общей исходной переменной, сливаются, если их времена жизни
+// не пересекаются; копирования внутри слитых переменных исчезают, версии, которые не удалось
+// слить с исходной переменной, остаются отдельными переменными подпрограммы
+void flow_graph_ssa_destroy(struct flow_graph_subroutine * subroutine);
@@ -0,0 +1,166 @@
+#include "passes.h"
+
+#include <stdlib.h>
+
+#include "utils/mallocs.h"
+
+
+struct reads_context {
+
+    const struct flow_graph_local * local;
+    bool found;
+};
+
+static void find_read(struct flow_graph_expr * expr, bool write, void * context) {
+    struct reads_context * const reads = context;
+
+    if (!write && expr->local.local == reads->local) {
+        reads->found = true;
+    }
+}
+
+static bool reads_local(struct flow_graph_expr * expr, const struct flow_graph_local * local) {
+    struct reads_context context = { .local = local };
+    flow_graph_expr_visit_locals(expr, find_read, &context);
+    return context.found;
+}
+
+static bool is_local(const struct flow_graph_expr * expr, const struct flow_graph_local * local) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->local.local == local;
+}
+
+static bool is_bool(const struct ast_type_reference * type) {
+    return type->_type == AST_TYPE_REFERENCE_TYPE_BUILTIN && type->builtin.type == AST_TYPE_REFERENCE_BUILTIN_TYPE_BOOL;
+}
+
+// параметр, который читают следующие аргументы, нельзя перезаписать сразу: его новое значение
+// ждёт во временной переменной, пока вычисляются остальные
+static bool needs_temp(const struct flow_graph_expr * call, size_t i, const struct flow_graph_local * param) {
+    for (size_t k = i + 1; k < call->call.args.size; ++k) {
+        if (reads_local(call->call.args.values[k], param)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct flow_graph_node * new_assignment(
+        struct flow_graph_subroutine * subroutine,
+        struct flow_graph_local * local,
+        struct flow_graph_expr * value
+) {
+    struct flow_graph_expr * const expr = flow_graph_expr_new_binary(
+            value->position,
+            FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+            flow_graph_expr_new_typed_local(value->position, local),
+            value
+    );
+
+    expr->type = ast_type_reference_clone(local->type);
+
+    struct flow_graph_node * const node = flow_graph_node_new_expr(value->position, expr);
+    flow_graph_node_list_append(&subroutine->nodes, node);
+    return node;
+}
+
+static void append_node(struct flow_graph_node ** first, struct flow_graph_node ** last, struct flow_graph_node * node) {
+    if (*last) {
+        (*last)->expr.next = node;
+    } else {
+        *first = node;
+    }
+
+    *last = node;
+}
+
+// вершина возвращает значение вызова самой подпрограммы: аргументы записываются в параметры,
+// и управление уходит в начало
+static bool eliminate_call(struct flow_graph_subroutine * subroutine, struct flow_graph_node * node) {
+    struct flow_graph_expr * const call = node->expr.expr;
+    const size_t args_num = subroutine->args_num;
+
+    bool * const staged = mallocs(sizeof(bool) * (args_num + 1));
+
+    for (size_t i = 0; i < args_num; ++i) {
+        const struct flow_graph_local * const param = subroutine->locals.values[i];
+        staged[i] = !is_local(call->call.args.values[i], param) && needs_temp(call, i, param);
+
+        // значения bool во временных переменных кодогенерация не поддерживает
+        if (staged[i] && is_bool(param->type)) {
+            free(staged);
+            return false;
+        }
+    }
+
+    struct flow_graph_local ** const temps = mallocs(sizeof(struct flow_graph_local *) * (args_num + 1));
+    struct flow_graph_node * first = NULL;
+    struct flow_graph_node * last = NULL;
+
+    // аргументы вычисляются по порядку, как при вызове; копирования из временных переменных — после всех
+    for (size_t i = 0; i < args_num; ++i) {
+        struct flow_graph_local * const param = subroutine->locals.values[i];
+        struct flow_graph_expr * const arg = call->call.args.values[i];
+
+        if (is_local(arg, param)) {
+            continue;
+        }
+
+        if (staged[i]) {
+            temps[i] = flow_graph_subroutine_add_temp(subroutine, ast_type_reference_clone(param->type), param->position);
+        }
+
+        struct flow_graph_local * const target = staged[i] ? temps[i] : param;
+
+        append_node(&first, &last, new_assignment(subroutine, target, arg));
+        call->call.args.values[i] = NULL;
+    }
+
+    for (size_t i = 0; i < args_num; ++i) {
+        if (staged[i]) {
+            struct flow_graph_local * const param = subroutine->locals.values[i];
+            struct flow_graph_expr * const value = flow_graph_expr_new_typed_local(param->position, temps[i]);
+            append_node(&first, &last, new_assignment(subroutine, param, value));
+        }
+    }
+
+    struct flow_graph_node * const entry = subroutine->nodes.values[0];
+
+    if (last) {
+        last->expr.next = entry;
+    }
+
+    node->expr.expr = NULL;
+    node->expr.next = first ? first : entry;
+
+    flow_graph_expr_delete(call);
+    free(temps);
+    free(staged);
+
+    return true;
+}
+
+bool flow_graph_optimize_eliminate_tail_recursion(struct flow_graph_subroutine * subroutine) {
+    bool changed = false;
+    const size_t size = subroutine->nodes.size;
+
+    for (size_t i = 0; i < size; ++i) {
+        struct flow_graph_node * const node = subroutine->nodes.values[i];
+
+        if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR || node->expr.next || !node->expr.expr) {
+            continue;
+        }
+
+        const struct flow_graph_expr * const expr = node->expr.expr;
+
+        if (expr->_type == FLOW_GRAPH_EXPR_TYPE_CALL && expr->call.subroutine == subroutine) {
+            changed |= eliminate_call(subroutine, node);
+        }
+    }
+
+    if (changed) {
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    return changed;
+}
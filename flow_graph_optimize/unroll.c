@@ -0,0 +1,718 @@
+#include "passes.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "dominators.h"
+#include "loops.h"
+#include "flow_graph/predecessors.h"
+#include "utils/mallocs.h"
+#include "utils/stack.h"
+
+
+// развёртка с остатком копирует тело столько раз, сколько позволяет бюджет, но не больше
+#define UNROLL_FACTOR_MAX 4
+
+// сколько вершин перед заголовком просматривается в поисках начального значения переменной цикла
+#define INIT_SEARCH_DEPTH 16
+
+// цикл с проверкой в заголовке: пока i < n (direction = 1) или i > n (direction = -1), выполняется тело,
+// в котором i меняется на direction ровно один раз за проход и больше нигде не пишется, а n не меняется
+struct counted_loop {
+
+    const struct flow_graph_loop * loop;
+
+    struct flow_graph_local * local;
+    int direction;
+
+    // граница: переменная или литерал
+    const struct flow_graph_expr * bound;
+
+    // первая вершина тела и выход из цикла
+    struct flow_graph_node * entry;
+    struct flow_graph_node * exit;
+
+    // число выражений в теле без заголовка
+    size_t size;
+};
+
+struct unrolling {
+
+    struct flow_graph_subroutine * subroutine;
+    const struct flow_graph_dominators * dominators;
+    const struct flow_graph_predecessors * predecessors;
+    size_t budget;
+
+    const struct flow_graph_loop * loop;
+    size_t stamp;
+
+    // число вершин до развёртки, по нему выделены массивы ниже
+    size_t nodes_size;
+
+    // вершины тела отмечены номером текущего цикла + 1
+    size_t * marks;
+    // вершины развёрнутых циклов и выходы из них: предшественники и тела, найденные до развёртки,
+    // для них уже неверны
+    bool * changed;
+    // копии вершин тела по номеру исходной вершины - 1
+    struct flow_graph_node ** clones;
+
+    struct stack stack;
+};
+
+// вершины, добавленные развёрткой, в массивах не учтены и телу не принадлежат
+static bool in_body(const struct unrolling * unrolling, const struct flow_graph_node * node) {
+    return node
+           && node->index > 0
+           && node->index <= unrolling->nodes_size
+           && unrolling->marks[node->index - 1] == unrolling->stamp;
+}
+
+// слово, которое получится, если обрезать его до размера числового типа и снова расширить
+static uint32_t normalize(uint32_t value, const struct ast_type_reference * type) {
+    switch (type->builtin.type) {
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_BYTE:
+            return (uint8_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_INT:
+            return (uint32_t) (int32_t) (int16_t) value;
+
+        case AST_TYPE_REFERENCE_BUILTIN_TYPE_UINT:
+            return (uint16_t) value;
+
+        default:
+            return value;
+    }
+}
+
+static bool get_literal(const struct flow_graph_expr * expr, uint32_t * value) {
+    if (expr->_type != FLOW_GRAPH_EXPR_TYPE_LITERAL
+        || expr->literal.literal->_type != FLOW_GRAPH_LITERAL_TYPE_INT
+        || !ast_type_reference_is_numeric(expr->type)) {
+        return false;
+    }
+
+    *value = normalize((uint32_t) expr->literal.literal->_int.value, expr->type);
+    return true;
+}
+
+static bool is_local(const struct flow_graph_expr * expr, const struct flow_graph_local * local) {
+    return expr->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && expr->local.local == local;
+}
+
+struct writes_context {
+
+    const struct flow_graph_local * local;
+    size_t writes;
+};
+
+static void count_writes(struct flow_graph_expr * expr, bool write, void * context) {
+    struct writes_context * const writes = context;
+
+    if (write && expr->local.local == writes->local) {
+        ++writes->writes;
+    }
+}
+
+static size_t count_local_writes(const struct flow_graph_node * node, const struct flow_graph_local * local) {
+    struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+    struct writes_context context = { .local = local };
+
+    if (expr) {
+        flow_graph_expr_visit_locals(expr, count_writes, &context);
+    }
+
+    return context.writes;
+}
+
+static size_t count_exprs(struct unrolling * unrolling, struct flow_graph_expr * root) {
+    struct stack * const stack = &unrolling->stack;
+    size_t result = 0;
+
+    stack_push(stack, root);
+
+    while (stack->size > 0) {
+        struct flow_graph_expr * const expr = stack_pop(stack);
+        ++result;
+
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                stack_push(stack, expr->binary.lhs);
+                stack_push(stack, expr->binary.rhs);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(stack, expr->unary.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                for (size_t i = 0; i < expr->call.args.size; ++i) {
+                    stack_push(stack, expr->call.args.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                stack_push(stack, expr->indexer.value);
+
+                for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
+                    stack_push(stack, expr->indexer.indices.values[i]);
+                }
+
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
+    }
+
+    return result;
+}
+
+// i = i ± 1 в корне вершины; возвращает шаг: 1, -1 или 0, если вершина не такая
+static int match_step(const struct flow_graph_node * node, const struct flow_graph_local * local) {
+    const struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+    if (node->_type != FLOW_GRAPH_NODE_TYPE_EXPR
+        || !expr
+        || expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+        || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+        || !is_local(expr->binary.lhs, local)) {
+        return 0;
+    }
+
+    const struct flow_graph_expr * const rhs = expr->binary.rhs;
+
+    if (rhs->_type != FLOW_GRAPH_EXPR_TYPE_BINARY || !ast_type_reference_equals(rhs->type, local->type)) {
+        return 0;
+    }
+
+    uint32_t value;
+
+    if (rhs->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_PLUS) {
+        if (!(is_local(rhs->binary.lhs, local) && get_literal(rhs->binary.rhs, &value))
+            && !(is_local(rhs->binary.rhs, local) && get_literal(rhs->binary.lhs, &value))) {
+            return 0;
+        }
+    } else if (rhs->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_MINUS) {
+        if (!is_local(rhs->binary.lhs, local) || !get_literal(rhs->binary.rhs, &value)) {
+            return 0;
+        }
+
+        value = -value;
+    } else {
+        return 0;
+    }
+
+    return value == 1 ? 1 : value == UINT32_MAX ? -1 : 0;
+}
+
+// заголовок — проверка i < n или i > n, продолжение цикла — по ветке then
+static bool match_header(struct counted_loop * counted) {
+    const struct flow_graph_node * const header = counted->loop->header;
+
+    if (header->_type != FLOW_GRAPH_NODE_TYPE_COND) {
+        return false;
+    }
+
+    const struct flow_graph_expr * const cond = header->cond.cond;
+
+    if (cond->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+        || (cond->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_LT && cond->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_GT)) {
+        return false;
+    }
+
+    const int direction = cond->binary.op == FLOW_GRAPH_EXPR_BINARY_OP_LT ? 1 : -1;
+    const struct flow_graph_expr * const lhs = cond->binary.lhs;
+    const struct flow_graph_expr * const rhs = cond->binary.rhs;
+
+    if (lhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && ast_type_reference_is_numeric(lhs->type)) {
+        counted->local = lhs->local.local;
+        counted->direction = direction;
+        counted->bound = rhs;
+    } else if (rhs->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && ast_type_reference_is_numeric(rhs->type)) {
+        counted->local = rhs->local.local;
+        counted->direction = -direction;
+        counted->bound = lhs;
+    } else {
+        return false;
+    }
+
+    uint32_t value;
+
+    if (!(counted->bound->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL && ast_type_reference_is_numeric(counted->bound->type))
+        && !get_literal(counted->bound, &value)) {
+        return false;
+    }
+
+    counted->entry = header->cond.then_next;
+    counted->exit = header->cond.else_next;
+
+    return counted->entry != header;
+}
+
+// переходы вершин тела ведут только в тело или в заголовок; переменная цикла пишется ровно в одной
+// вершине, через которую проходит каждая итерация, граница не пишется вовсе
+static bool match_body(struct unrolling * unrolling, struct counted_loop * counted) {
+    const struct flow_graph_loop * const loop = counted->loop;
+
+    if (!in_body(unrolling, counted->entry) || in_body(unrolling, counted->exit)) {
+        return false;
+    }
+
+    const struct flow_graph_local * const bound =
+            counted->bound->_type == FLOW_GRAPH_EXPR_TYPE_LOCAL ? counted->bound->local.local : NULL;
+
+    const struct flow_graph_node * step = NULL;
+    counted->size = 0;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_node * const node = loop->body[i];
+
+        if (unrolling->changed[node->index - 1]) {
+            return false;
+        }
+
+        if (node == loop->header) {
+            continue;
+        }
+
+        struct flow_graph_node * successors[FLOW_GRAPH_NODE_SUCCESSORS_MAX];
+        const size_t successors_size = flow_graph_node_get_successors(node, successors);
+
+        if (flow_graph_node_is_exit(node)) {
+            return false;
+        }
+
+        for (size_t k = 0; k < successors_size; ++k) {
+            if (successors[k] != loop->header && !in_body(unrolling, successors[k])) {
+                return false;
+            }
+        }
+
+        if (bound && count_local_writes(node, bound) > 0) {
+            return false;
+        }
+
+        const size_t writes = count_local_writes(node, counted->local);
+
+        if (writes > 0) {
+            if (step || writes > 1 || match_step(node, counted->local) != counted->direction) {
+                return false;
+            }
+
+            step = node;
+        }
+
+        struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+
+        if (expr) {
+            counted->size += count_exprs(unrolling, expr);
+        }
+    }
+
+    if (!step) {
+        return false;
+    }
+
+    for (size_t i = 0; i < loop->latches_size; ++i) {
+        if (!flow_graph_dominators_dominates(unrolling->dominators, step, loop->latches[i])) {
+            return false;
+        }
+    }
+
+    return counted->size > 0;
+}
+
+// единственный вход в цикл снаружи; начальное значение известно, если на пути к заголовку без
+// ветвлений переменной присваивается литерал
+static bool find_init(const struct unrolling * unrolling, const struct counted_loop * counted, uint32_t * value) {
+    const struct flow_graph_predecessors * const predecessors = unrolling->predecessors;
+    const struct flow_graph_node * node = counted->loop->header;
+
+    for (size_t depth = 0; depth < INIT_SEARCH_DEPTH; ++depth) {
+        const size_t i = node->index - 1;
+        const struct flow_graph_node * predecessor = NULL;
+
+        for (size_t k = predecessors->offsets[i]; k < predecessors->offsets[i + 1]; ++k) {
+            if (node == counted->loop->header && in_body(unrolling, predecessors->values[k])) {
+                continue;
+            }
+
+            if (predecessor) {
+                return false;
+            }
+
+            predecessor = predecessors->values[k];
+        }
+
+        if (!predecessor) {
+            return false;
+        }
+
+        const size_t writes = count_local_writes(predecessor, counted->local);
+
+        if (writes > 0) {
+            const struct flow_graph_expr * const expr = flow_graph_node_get_expr(predecessor);
+            const struct ast_type_reference * const type = counted->local->type;
+
+            if (writes > 1
+                || expr->_type != FLOW_GRAPH_EXPR_TYPE_BINARY
+                || expr->binary.op != FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT
+                || !is_local(expr->binary.lhs, counted->local)
+                || !get_literal(expr->binary.rhs, value)) {
+                return false;
+            }
+
+            *value = normalize(*value, type);
+            return true;
+        }
+
+        // у вершины, в которую развёртка провела новые переходы, найденные предшественники неполны
+        if (unrolling->changed[predecessor->index - 1]) {
+            return false;
+        }
+
+        node = predecessor;
+    }
+
+    return false;
+}
+
+static bool compare(uint32_t lhs, uint32_t rhs, int direction) {
+    return direction > 0 ? (int32_t) lhs < (int32_t) rhs : (int32_t) lhs > (int32_t) rhs;
+}
+
+// число проходов цикла с известными началом и границей, если оно не больше limit
+static bool count_trips(const struct counted_loop * counted, uint32_t init, size_t limit, size_t * trips) {
+    uint32_t bound;
+    get_literal(counted->bound, &bound);
+
+    uint32_t value = init;
+
+    for (size_t i = 0; i <= limit; ++i) {
+        if (!compare(value, bound, counted->direction)) {
+            *trips = i;
+            return true;
+        }
+
+        value = normalize(value + (uint32_t) counted->direction, counted->local->type);
+    }
+
+    return false;
+}
+
+static struct flow_graph_node * clone_node(const struct flow_graph_node * node) {
+    struct flow_graph_expr * const expr = flow_graph_node_get_expr(node);
+    struct flow_graph_expr * const clone = expr ? flow_graph_expr_clone(expr) : NULL;
+
+    switch (node->_type) {
+        case FLOW_GRAPH_NODE_TYPE_EXPR:
+            return flow_graph_node_new_expr(node->position, clone);
+
+        case FLOW_GRAPH_NODE_TYPE_COND:
+            return flow_graph_node_new_cond(node->position, clone);
+    }
+
+    return NULL;
+}
+
+static struct flow_graph_node * map_successor(
+        const struct unrolling * unrolling,
+        struct flow_graph_node * successor,
+        struct flow_graph_node * next
+) {
+    return successor == unrolling->loop->header ? next : unrolling->clones[successor->index - 1];
+}
+
+// копия тела без заголовка, в которой переходы в заголовок ведут в next; возвращает копию первой вершины
+static struct flow_graph_node * copy_body(
+        struct unrolling * unrolling,
+        const struct counted_loop * counted,
+        struct flow_graph_node * next
+) {
+    const struct flow_graph_loop * const loop = counted->loop;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_node * const node = loop->body[i];
+
+        if (node != loop->header) {
+            struct flow_graph_node * const clone = clone_node(node);
+
+            unrolling->clones[node->index - 1] = clone;
+            flow_graph_node_list_append(&unrolling->subroutine->nodes, clone);
+        }
+    }
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        struct flow_graph_node * const node = loop->body[i];
+
+        if (node == loop->header) {
+            continue;
+        }
+
+        struct flow_graph_node * const clone = unrolling->clones[node->index - 1];
+
+        switch (node->_type) {
+            case FLOW_GRAPH_NODE_TYPE_EXPR:
+                clone->expr.next = map_successor(unrolling, node->expr.next, next);
+                break;
+
+            case FLOW_GRAPH_NODE_TYPE_COND:
+                clone->cond.then_next = map_successor(unrolling, node->cond.then_next, next);
+                clone->cond.else_next = map_successor(unrolling, node->cond.else_next, next);
+                break;
+        }
+    }
+
+    return unrolling->clones[counted->entry->index - 1];
+}
+
+static struct flow_graph_expr * new_word(struct position position, uint32_t value) {
+    return flow_graph_expr_new_typed_int(
+            position,
+            ast_type_reference_new_builtin(position, AST_TYPE_REFERENCE_BUILTIN_TYPE_LONG),
+            value
+    );
+}
+
+static struct flow_graph_expr * new_compare(
+        struct position position,
+        int direction,
+        struct flow_graph_expr * lhs,
+        struct flow_graph_expr * rhs
+) {
+    struct flow_graph_expr * const expr = flow_graph_expr_new_binary(
+            position,
+            direction > 0 ? FLOW_GRAPH_EXPR_BINARY_OP_LT : FLOW_GRAPH_EXPR_BINARY_OP_GT,
+            lhs,
+            rhs
+    );
+
+    expr->type = ast_type_reference_new_builtin(position, AST_TYPE_REFERENCE_BUILTIN_TYPE_BOOL);
+    return expr;
+}
+
+// полная развёртка: trips копий тела подряд, проверка в заголовке больше не нужна
+static void unroll_fully(struct unrolling * unrolling, const struct counted_loop * counted, size_t trips) {
+    struct flow_graph_node * next = counted->exit;
+
+    for (size_t i = 0; i < trips; ++i) {
+        next = copy_body(unrolling, counted, next);
+    }
+
+    flow_graph_loop_insert_preheader(unrolling->subroutine, counted->loop, unrolling->predecessors, next);
+}
+
+// развёртка с остатком: пока до границы не меньше factor проходов, тело выполняется factor раз подряд
+// под одной проверкой i < n - (factor - 1), оставшиеся проходы делает исходный цикл; граница-переменная
+// сначала проверяется на то, что вычитание не переполнится, иначе сразу выполняется исходный цикл
+static void unroll_with_remainder(struct unrolling * unrolling, const struct counted_loop * counted, size_t factor) {
+    struct flow_graph_subroutine * const subroutine = unrolling->subroutine;
+    struct flow_graph_node * const header = counted->loop->header;
+    const struct position position = header->position;
+
+    const uint32_t distance = (uint32_t) (factor - 1);
+    const enum flow_graph_expr_binary_op op =
+            counted->direction > 0 ? FLOW_GRAPH_EXPR_BINARY_OP_MINUS : FLOW_GRAPH_EXPR_BINARY_OP_PLUS;
+
+    struct flow_graph_local * limit = NULL;
+    struct flow_graph_expr * limit_expr;
+    uint32_t bound;
+
+    if (get_literal(counted->bound, &bound)) {
+        limit_expr = new_word(position, counted->direction > 0 ? bound - distance : bound + distance);
+    } else {
+        limit = flow_graph_subroutine_add_temp(
+                subroutine,
+                ast_type_reference_new_builtin(position, AST_TYPE_REFERENCE_BUILTIN_TYPE_LONG),
+                position
+        );
+        limit_expr = flow_graph_expr_new_typed_local(position, limit);
+    }
+
+    struct flow_graph_node * const test = flow_graph_node_new_cond(
+            position,
+            new_compare(position, counted->direction, flow_graph_expr_new_typed_local(position, counted->local), limit_expr)
+    );
+
+    flow_graph_node_list_append(&subroutine->nodes, test);
+
+    struct flow_graph_node * next = test;
+
+    for (size_t i = 0; i < factor; ++i) {
+        next = copy_body(unrolling, counted, next);
+    }
+
+    test->cond.then_next = next;
+    test->cond.else_next = header;
+
+    struct flow_graph_node * entry = test;
+
+    if (limit) {
+        struct flow_graph_expr * const difference = flow_graph_expr_new_binary(
+                position,
+                op,
+                flow_graph_expr_clone(counted->bound),
+                new_word(position, distance)
+        );
+
+        difference->type = ast_type_reference_new_builtin(position, AST_TYPE_REFERENCE_BUILTIN_TYPE_LONG);
+
+        struct flow_graph_expr * const assignment = flow_graph_expr_new_binary(
+                position,
+                FLOW_GRAPH_EXPR_BINARY_OP_ASSIGNMENT,
+                flow_graph_expr_new_typed_local(position, limit),
+                difference
+        );
+
+        assignment->type = ast_type_reference_clone(limit->type);
+
+        struct flow_graph_node * const guard = flow_graph_node_new_cond(
+                position,
+                new_compare(
+                        position,
+                        counted->direction,
+                        flow_graph_expr_new_typed_local(position, limit),
+                        flow_graph_expr_clone(counted->bound)
+                )
+        );
+
+        guard->cond.then_next = test;
+        guard->cond.else_next = header;
+        flow_graph_node_list_append(&subroutine->nodes, guard);
+
+        entry = flow_graph_node_new_expr(position, assignment);
+        entry->expr.next = guard;
+        flow_graph_node_list_append(&subroutine->nodes, entry);
+    }
+
+    flow_graph_loop_insert_preheader(subroutine, counted->loop, unrolling->predecessors, entry);
+}
+
+static void mark_changed(struct unrolling * unrolling, const struct counted_loop * counted) {
+    const struct flow_graph_loop * const loop = counted->loop;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        unrolling->changed[loop->body[i]->index - 1] = true;
+    }
+
+    if (counted->exit && counted->exit->index > 0 && counted->exit->index <= unrolling->nodes_size) {
+        unrolling->changed[counted->exit->index - 1] = true;
+    }
+}
+
+static bool unroll_loop(struct unrolling * unrolling) {
+    const struct flow_graph_loop * const loop = unrolling->loop;
+
+    for (size_t i = 0; i < loop->body_size; ++i) {
+        unrolling->marks[loop->body[i]->index - 1] = unrolling->stamp;
+    }
+
+    struct counted_loop counted = { .loop = loop };
+
+    if (!match_header(&counted) || !match_body(unrolling, &counted)) {
+        return false;
+    }
+
+    // полная развёртка оставляет переход из последней копии на выход, а выход из подпрограммы по вершине
+    // выражения вернул бы её значение
+    uint32_t init;
+    size_t trips;
+
+    if (counted.exit
+        && counted.bound->_type == FLOW_GRAPH_EXPR_TYPE_LITERAL
+        && find_init(unrolling, &counted, &init)
+        && count_trips(&counted, init, unrolling->budget / counted.size, &trips)) {
+        unroll_fully(unrolling, &counted, trips);
+        mark_changed(unrolling, &counted);
+        return true;
+    }
+
+    size_t factor = UNROLL_FACTOR_MAX;
+
+    while (factor > 1 && factor * counted.size > unrolling->budget) {
+        factor /= 2;
+    }
+
+    if (factor < 2) {
+        return false;
+    }
+
+    uint32_t bound;
+
+    // с литеральной границей переполнение видно сразу: такой цикл делает меньше factor проходов
+    if (get_literal(counted.bound, &bound)) {
+        const int64_t limit = (int64_t) (int32_t) bound - counted.direction * (int64_t) (factor - 1);
+
+        if (limit < INT32_MIN || limit > INT32_MAX) {
+            return false;
+        }
+    }
+
+    unroll_with_remainder(unrolling, &counted, factor);
+    mark_changed(unrolling, &counted);
+    return true;
+}
+
+bool flow_graph_optimize_unroll_loops(struct flow_graph_subroutine * subroutine, size_t budget) {
+    const struct flow_graph_node_list * const nodes = &subroutine->nodes;
+
+    if (nodes->size == 0 || budget == 0) {
+        return false;
+    }
+
+    struct flow_graph_dominators dominators = flow_graph_dominators_build(subroutine);
+    struct flow_graph_loops loops = flow_graph_loops_find(subroutine, &dominators);
+
+    if (loops.size == 0) {
+        flow_graph_loops_fini(&loops);
+        flow_graph_dominators_fini(&dominators);
+        return false;
+    }
+
+    struct flow_graph_predecessors predecessors = flow_graph_predecessors_build(nodes);
+    const size_t nodes_size = nodes->size;
+
+    struct unrolling unrolling = {
+        .subroutine = subroutine,
+        .dominators = &dominators,
+        .predecessors = &predecessors,
+        .budget = budget,
+        .nodes_size = nodes_size,
+        .marks = mallocs(sizeof(size_t) * nodes_size),
+        .changed = mallocs(sizeof(bool) * nodes_size),
+        .clones = mallocs(sizeof(struct flow_graph_node *) * nodes_size),
+        .stack = stack_init(),
+    };
+
+    memset(unrolling.marks, 0, sizeof(size_t) * nodes_size);
+    memset(unrolling.changed, 0, sizeof(bool) * nodes_size);
+
+    bool result = false;
+
+    // вложенные циклы развёртываются первыми: обычно они горячее, а объемлющий цикл после развёртки
+    // вложенного пропускается, потому что его тело, найденное заранее, уже не совпадает с графом
+    for (size_t i = loops.size; i > 0; --i) {
+        unrolling.loop = &loops.values[i - 1];
+        unrolling.stamp = i;
+
+        result = unroll_loop(&unrolling) || result;
+    }
+
+    stack_fini(&unrolling.stack);
+    free(unrolling.clones);
+    free(unrolling.changed);
+    free(unrolling.marks);
+
+    flow_graph_predecessors_fini(&predecessors);
+    flow_graph_loops_fini(&loops);
+    flow_graph_dominators_fini(&dominators);
+
+    if (result) {
+        flow_graph_subroutine_renumber(subroutine);
+    }
+
+    return result;
+}
@@ -1,5 +1,6 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "parser/lexer.h"
 #include "parser/parser.h"
@@ -9,13 +10,18 @@
 #include "ast_analyze/analyze.h"
 #include "codegen/generate.h"
 #include "flow_graph_display.h"
+#include "flow_graph_optimize/optimize.h"
 #include "utils/mallocs.h"
+#include "utils/stack.h"
 
 
 static const char ** input_filenames;
 static size_t input_filenames_count;
 static const char * output_filename;
 static bool graphs = false;
+static bool dataflow = false;
+static struct flow_graph_optimize_options optimize_options;
+static struct codegen_options codegen_options;
 
 static bool parse_args(int argc, char * argv[]) {
     if (argc < 3) {
@@ -23,10 +29,42 @@ static bool parse_args(int argc, char * argv[]) {
         return false;
     }
 
+    optimize_options = flow_graph_optimize_options_init();
+    codegen_options = codegen_options_init();
+
     int offset = 1;
-    if (strcmp(argv[1], "-a") == 0) {
-        graphs = true;
-        ++offset;
+    for (; offset < argc - 1 && argv[offset][0] == '-'; ++offset) {
+        if (strcmp(argv[offset], "-a") == 0) {
+            graphs = true;
+        } else if (strcmp(argv[offset], "-d") == 0) {
+            graphs = true;
+            dataflow = true;
+        } else if (strcmp(argv[offset], "-s") == 0) {
+            graphs = true;
+            optimize_options.keep_ssa = true;
+        } else if (strcmp(argv[offset], "-O0") == 0) {
+            optimize_options.enabled = false;
+        } else if (strcmp(argv[offset], "-f0") == 0) {
+            codegen_options.static_frames = false;
+        } else if (strncmp(argv[offset], "-u", 2) == 0) {
+            char * end;
+            const unsigned long budget = strtoul(argv[offset] + 2, &end, 10);
+
+            if (argv[offset][2] == '\0' || *end != '\0') {
+                fprintf(stderr, "Invalid unroll budget \"%s\".\n", argv[offset] + 2);
+                return false;
+            }
+
+            optimize_options.unroll_budget = budget;
+        } else {
+            fprintf(stderr, "Unknown option \"%s\".\n", argv[offset]);
+            return false;
+        }
+    }
+
+    if (offset >= argc - 1) {
+        fputs("Invalid number of arguments.\n", stderr);
+        return false;
     }
 
     input_filenames_count = argc - offset - 1;
@@ -36,7 +74,7 @@ static bool parse_args(int argc, char * argv[]) {
         input_filenames[i] = argv[i + offset];
     }
 
-    output_filename = argv[input_filenames_count + 1];
+    output_filename = argv[argc - 1];
     return true;
 }
 
@@ -86,43 +124,52 @@ end:
     return result;
 }
 
-static void print_depgraph_expr(const struct flow_graph_expr * expr, FILE * output) {
-    if (!expr) {
-        return;
-    }
+static void print_depgraph_expr(const struct flow_graph_expr * root, FILE * output) {
+    struct stack stack = stack_init();
+    stack_push(&stack, (void *) root);
 
-    switch (expr->_type) {
-        case FLOW_GRAPH_EXPR_TYPE_BINARY:
-            print_depgraph_expr(expr->binary.lhs, output);
-            print_depgraph_expr(expr->binary.rhs, output);
-            break;
+    // операнды кладутся в обратном порядке, чтобы вызовы печатались в порядке записи
+    while (stack.size > 0) {
+        const struct flow_graph_expr * const expr = stack_pop(&stack);
 
-        case FLOW_GRAPH_EXPR_TYPE_UNARY:
-            print_depgraph_expr(expr->unary.value, output);
-            break;
+        if (!expr) {
+            continue;
+        }
 
-        case FLOW_GRAPH_EXPR_TYPE_CALL:
-            fprintf(output, "- %s from file %s\n", expr->call.subroutine->id, expr->call.subroutine->filename);
+        switch (expr->_type) {
+            case FLOW_GRAPH_EXPR_TYPE_BINARY:
+                stack_push(&stack, expr->binary.rhs);
+                stack_push(&stack, expr->binary.lhs);
+                break;
 
-            for (size_t i = 0; i < expr->call.args.size; ++i) {
-                print_depgraph_expr(expr->call.args.values[i], output);
-            }
+            case FLOW_GRAPH_EXPR_TYPE_UNARY:
+                stack_push(&stack, expr->unary.value);
+                break;
 
-            break;
+            case FLOW_GRAPH_EXPR_TYPE_CALL:
+                fprintf(output, "- %s from file %s\n", expr->call.subroutine->id, expr->call.subroutine->filename);
 
-        case FLOW_GRAPH_EXPR_TYPE_INDEXER:
-            print_depgraph_expr(expr->indexer.value, output);
+                for (size_t i = expr->call.args.size; i > 0; --i) {
+                    stack_push(&stack, expr->call.args.values[i - 1]);
+                }
 
-            for (size_t i = 0; i < expr->indexer.indices.size; ++i) {
-                print_depgraph_expr(expr->indexer.indices.values[i], output);
-            }
+                break;
 
-            break;
+            case FLOW_GRAPH_EXPR_TYPE_INDEXER:
+                for (size_t i = expr->indexer.indices.size; i > 0; --i) {
+                    stack_push(&stack, expr->indexer.indices.values[i - 1]);
+                }
 
-        case FLOW_GRAPH_EXPR_TYPE_LOCAL:
-        case FLOW_GRAPH_EXPR_TYPE_LITERAL:
-            break;
+                stack_push(&stack, expr->indexer.value);
+                break;
+
+            case FLOW_GRAPH_EXPR_TYPE_LOCAL:
+            case FLOW_GRAPH_EXPR_TYPE_LITERAL:
+                break;
+        }
     }
+
+    stack_fini(&stack);
 }
 
 static void print_depgraph(const struct flow_graph_subroutine_list * subroutines) {
@@ -186,8 +233,8 @@ int main(int argc, char * argv[]) {
     int result = 0;
 
     if (!parse_args(argc, argv)) {
-        fprintf(stderr, "Usage: %s -a <input filename...> <output directory path>\n", argv[0]);
-        fprintf(stderr, "       %s <input filename...> <output filename>\n", argv[0]);
+        fprintf(stderr, "Usage: %s [-O0] [-u<budget>] -a|-d|-s <input filename...> <output directory path>\n", argv[0]);
+        fprintf(stderr, "       %s [-O0] [-u<budget>] [-f0] <input filename...> <output filename>\n", argv[0]);
         return 1;
     }
 
@@ -214,6 +261,8 @@ int main(int argc, char * argv[]) {
         }
 
         result = 4;
+    } else {
+        flow_graph_optimize(&subroutines, &optimize_options);
     }
 
     if (graphs) {
@@ -231,12 +280,16 @@ int main(int argc, char * argv[]) {
 
             flow_graph_display(subroutine, output_file);
 
+            if (dataflow && errors.size == 0) {
+                flow_graph_display_dataflow(subroutine, output_file);
+            }
+
             fclose(output_file);
         }
 
         print_depgraph(&subroutines);
     } else if (errors.size == 0) {
-        struct codegen_asm_list code = codegen_generate(subroutines);
+        struct codegen_asm_list code = codegen_generate(subroutines, &codegen_options);
 
         FILE *const output_file = fopen(output_filename, "w");
         if (!output_file) {
@@ -0,0 +1,322 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parser/lexer.h"
+#include "parser/parser.h"
+#include "flow_graph.h"
+#include "ast_analyze/source.h"
+#include "ast_analyze/error.h"
+#include "ast_analyze/analyze.h"
+#include "bench/generate.h"
+#include "codegen/generate.h"
+#include "flow_graph_optimize/optimize.h"
+
+
+struct measurement {
+
+    size_t source_bytes;
+    size_t tokens;
+    size_t subroutines;
+    size_t nodes;
+    size_t asm_items;
+
+    double lexer_ms;
+    double parser_ms;
+    double analyze_ms;
+    double optimize_ms;
+    double codegen_ms;
+};
+
+static const char * output_filename = NULL;
+static size_t repeat = 3;
+static size_t steps = 4;
+static bool scenarios[BENCH_SCENARIOS_COUNT];
+
+static bool generate_only = false;
+static enum bench_scenario generate_scenario;
+static size_t generate_size;
+
+static bool parse_scenario(const char * name, enum bench_scenario * scenario) {
+    for (size_t i = 0; i < BENCH_SCENARIOS_COUNT; ++i) {
+        if (strcmp(BENCH_SCENARIO_NAME[i], name) == 0) {
+            *scenario = (enum bench_scenario) i;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Unknown scenario \"%s\".\n", name);
+    return false;
+}
+
+static bool parse_args(int argc, char * argv[]) {
+    bool any_scenario = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_filename = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeat = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            steps = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 2 < argc) {
+            generate_only = true;
+
+            if (!parse_scenario(argv[++i], &generate_scenario)) {
+                return false;
+            }
+
+            generate_size = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-') {
+            enum bench_scenario scenario;
+
+            if (!parse_scenario(argv[i], &scenario)) {
+                return false;
+            }
+
+            scenarios[scenario] = true;
+            any_scenario = true;
+        } else {
+            fprintf(stderr, "Unknown option \"%s\".\n", argv[i]);
+            return false;
+        }
+    }
+
+    if (repeat == 0 || steps == 0) {
+        fputs("Repeat count and number of steps must be positive.\n", stderr);
+        return false;
+    }
+
+    if (!any_scenario) {
+        for (size_t i = 0; i < BENCH_SCENARIOS_COUNT; ++i) {
+            scenarios[i] = true;
+        }
+    }
+
+    return true;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1000000.0;
+}
+
+static double min_ms(double lhs, double rhs) {
+    return lhs < rhs ? lhs : rhs;
+}
+
+static size_t run_lexer(FILE * input) {
+    size_t tokens = 0;
+
+    rewind(input);
+
+    const YY_BUFFER_STATE buffer_state = yy_create_buffer(input, 4096);
+    yy_switch_to_buffer(buffer_state);
+
+    int token;
+    while ((token = yylex()) != 0) {
+        switch (token) {
+            case T_IDENTIFIER:
+            case T_STR:
+            case T_CHAR:
+            case T_HEX:
+            case T_BITS:
+            case T_DEC:
+            case T_BOOL:
+                free(yylval.token);
+                break;
+
+            default:
+                break;
+        }
+
+        ++tokens;
+    }
+
+    yy_delete_buffer(buffer_state);
+    return tokens;
+}
+
+static struct ast_source * run_parser(FILE * input) {
+    rewind(input);
+
+    const YY_BUFFER_STATE buffer_state = yy_create_buffer(input, 4096);
+    yy_switch_to_buffer(buffer_state);
+
+    struct ast_source * ast = NULL;
+    char * error = NULL;
+
+    switch (yyparse(&ast, &error)) {
+        case 1:
+            fprintf(stderr, "Parsing failed: %s.\n", error);
+            break;
+
+        case 2:
+            fputs("Memory exhausted.\n", stderr);
+            break;
+    }
+
+    free(error);
+    yy_delete_buffer(buffer_state);
+
+    return ast;
+}
+
+static bool measure(enum bench_scenario scenario, size_t size, struct measurement * result) {
+    FILE * const input = tmpfile();
+    if (!input) {
+        perror("Cannot create temporary file");
+        return false;
+    }
+
+    bench_generate(scenario, size, input);
+    fflush(input);
+
+    *result = (struct measurement) {
+        .source_bytes = (size_t) ftell(input),
+        .lexer_ms = 1e300,
+        .parser_ms = 1e300,
+        .analyze_ms = 1e300,
+        .optimize_ms = 1e300,
+        .codegen_ms = 1e300,
+    };
+
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < repeat; ++i) {
+        double start = now_ms();
+        result->tokens = run_lexer(input);
+        result->lexer_ms = min_ms(result->lexer_ms, now_ms() - start);
+
+        start = now_ms();
+        struct ast_source * const ast = run_parser(input);
+        result->parser_ms = min_ms(result->parser_ms, now_ms() - start);
+
+        if (!ast) {
+            ok = false;
+            break;
+        }
+
+        struct ast_analyze_source_list sources = ast_analyze_source_list_init();
+        ast_analyze_source_list_append(&sources, ast_analyze_source_init(BENCH_SCENARIO_NAME[scenario], ast));
+
+        struct flow_graph_subroutine_list subroutines;
+        struct ast_analyze_error_list errors;
+
+        start = now_ms();
+        ast_analyze(&sources, &subroutines, &errors);
+        result->analyze_ms = min_ms(result->analyze_ms, now_ms() - start);
+
+        if (errors.size > 0) {
+            const struct ast_analyze_error * const err = &errors.values[0];
+
+            fprintf(stderr, "Generated program is invalid: %s at %zu:%zu\n",
+                    err->message, err->position.row, err->position.column);
+
+            ok = false;
+        } else {
+            const struct flow_graph_optimize_options options = flow_graph_optimize_options_init();
+
+            start = now_ms();
+            flow_graph_optimize(&subroutines, &options);
+            result->optimize_ms = min_ms(result->optimize_ms, now_ms() - start);
+
+            result->subroutines = subroutines.size;
+            result->nodes = 0;
+
+            for (size_t j = 0; j < subroutines.size; ++j) {
+                result->nodes += subroutines.values[j]->nodes.size;
+            }
+
+            const struct codegen_options codegen_options = codegen_options_init();
+
+            start = now_ms();
+            struct codegen_asm_list code = codegen_generate(subroutines, &codegen_options);
+            result->codegen_ms = min_ms(result->codegen_ms, now_ms() - start);
+
+            result->asm_items = code.size;
+            codegen_asm_list_fini(&code);
+        }
+
+        ast_analyze_error_list_fini(&errors);
+        flow_graph_subroutine_list_fini(&subroutines);
+
+        ast_source_delete(ast);
+        ast_analyze_source_list_fini(&sources);
+    }
+
+    fclose(input);
+    return ok;
+}
+
+static void print_measurement(
+        enum bench_scenario scenario,
+        size_t size,
+        const struct measurement * m,
+        bool first,
+        FILE * output
+) {
+    fprintf(output, "%s\n    {", first ? "" : ",");
+    fprintf(output, "\"scenario\": \"%s\", \"size\": %zu, ", BENCH_SCENARIO_NAME[scenario], size);
+    fprintf(output, "\"source_bytes\": %zu, \"tokens\": %zu, ", m->source_bytes, m->tokens);
+    fprintf(output, "\"subroutines\": %zu, \"nodes\": %zu, \"asm_items\": %zu, ", m->subroutines, m->nodes, m->asm_items);
+    fprintf(output, "\"lexer_ms\": %.3f, \"parser_ms\": %.3f, ", m->lexer_ms, m->parser_ms);
+    fprintf(output, "\"analyze_ms\": %.3f, \"optimize_ms\": %.3f, ", m->analyze_ms, m->optimize_ms);
+    fprintf(output, "\"codegen_ms\": %.3f}", m->codegen_ms);
+}
+
+int main(int argc, char * argv[]) {
+    if (!parse_args(argc, argv)) {
+        fprintf(stderr, "Usage: %s [-r <repeat>] [-s <steps>] [-o <output json>] [scenario...]\n", argv[0]);
+        fprintf(stderr, "       %s -g <scenario> <size>\n", argv[0]);
+        return 1;
+    }
+
+    if (generate_only) {
+        bench_generate(generate_scenario, generate_size, stdout);
+        return 0;
+    }
+
+    FILE * const output = output_filename ? fopen(output_filename, "w") : stdout;
+    if (!output) {
+        perror("Bad output file");
+        return 2;
+    }
+
+    int result = 0;
+    bool first = true;
+
+    fprintf(output, "{\n  \"repeat\": %zu,\n  \"results\": [", repeat);
+
+    for (size_t i = 0; result == 0 && i < BENCH_SCENARIOS_COUNT; ++i) {
+        if (!scenarios[i]) {
+            continue;
+        }
+
+        for (size_t j = 0; j < steps; ++j) {
+            const size_t size = BENCH_SCENARIO_BASE_SIZE[i] << j;
+
+            struct measurement m;
+            if (!measure((enum bench_scenario) i, size, &m)) {
+                result = 3;
+                break;
+            }
+
+            print_measurement((enum bench_scenario) i, size, &m, first, output);
+            fflush(output);
+            first = false;
+        }
+    }
+
+    fprintf(output, "\n  ]\n}\n");
+
+    if (output != stdout) {
+        fclose(output);
+    }
+
+    return result;
+}
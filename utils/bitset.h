@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mallocs.h"
+
+
+#define BITSET_WORD_BITS 64
+
+// множество номеров от 0 до size - 1 фиксированного размера
+struct bitset {
+
+    size_t size;
+    size_t words_size;
+    uint64_t * words;
+};
+
+static inline struct bitset bitset_init(size_t size) {
+    const size_t words_size = (size + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+
+    struct bitset result = {
+        .size = size,
+        .words_size = words_size,
+        .words = mallocs(sizeof(uint64_t) * (words_size ? words_size : 1)),
+    };
+
+    memset(result.words, 0, sizeof(uint64_t) * words_size);
+    return result;
+}
+
+static inline void bitset_fini(struct bitset * bitset) {
+    free(bitset->words);
+    *bitset = (struct bitset) { 0 };
+}
+
+static inline bool bitset_test(const struct bitset * bitset, size_t i) {
+    return (bitset->words[i / BITSET_WORD_BITS] >> (i % BITSET_WORD_BITS)) & 1;
+}
+
+static inline void bitset_set(struct bitset * bitset, size_t i) {
+    bitset->words[i / BITSET_WORD_BITS] |= (uint64_t) 1 << (i % BITSET_WORD_BITS);
+}
+
+static inline void bitset_reset(struct bitset * bitset, size_t i) {
+    bitset->words[i / BITSET_WORD_BITS] &= ~((uint64_t) 1 << (i % BITSET_WORD_BITS));
+}
+
+static inline void bitset_clear(struct bitset * bitset) {
+    memset(bitset->words, 0, sizeof(uint64_t) * bitset->words_size);
+}
+
+// все номера от 0 до size - 1, биты за пределами размера остаются нулевыми
+static inline void bitset_fill(struct bitset * bitset) {
+    memset(bitset->words, 0xff, sizeof(uint64_t) * bitset->words_size);
+
+    if (bitset->size % BITSET_WORD_BITS) {
+        bitset->words[bitset->words_size - 1] = ((uint64_t) 1 << (bitset->size % BITSET_WORD_BITS)) - 1;
+    }
+}
+
+// множества должны быть одного размера
+static inline void bitset_copy(struct bitset * dst, const struct bitset * src) {
+    memcpy(dst->words, src->words, sizeof(uint64_t) * dst->words_size);
+}
+
+static inline bool bitset_equals(const struct bitset * lhs, const struct bitset * rhs) {
+    return memcmp(lhs->words, rhs->words, sizeof(uint64_t) * lhs->words_size) == 0;
+}
+
+static inline void bitset_union(struct bitset * dst, const struct bitset * src) {
+    for (size_t i = 0; i < dst->words_size; ++i) {
+        dst->words[i] |= src->words[i];
+    }
+}
+
+static inline void bitset_intersect(struct bitset * dst, const struct bitset * src) {
+    for (size_t i = 0; i < dst->words_size; ++i) {
+        dst->words[i] &= src->words[i];
+    }
+}
+
+static inline void bitset_subtract(struct bitset * dst, const struct bitset * src) {
+    for (size_t i = 0; i < dst->words_size; ++i) {
+        dst->words[i] &= ~src->words[i];
+    }
+}
+
+static inline bool bitset_intersects(const struct bitset * lhs, const struct bitset * rhs) {
+    for (size_t i = 0; i < lhs->words_size; ++i) {
+        if (lhs->words[i] & rhs->words[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "mallocs.h"
+
+
+// стек указателей для обходов графа и деревьев без рекурсии, элементами не владеет
+struct stack {
+
+    size_t size;
+    size_t capacity;
+    void ** values;
+};
+
+static inline struct stack stack_init(void) {
+    return (struct stack) {
+        .size = 0,
+        .capacity = 16,
+        .values = mallocs(sizeof(void *) * 16),
+    };
+}
+
+static inline void stack_push(struct stack * stack, void * value) {
+    if (stack->size >= stack->capacity) {
+        const size_t new_capacity = stack->capacity * 2;
+
+        stack->values = reallocs(stack->values, sizeof(void *) * new_capacity);
+        stack->capacity = new_capacity;
+    }
+
+    stack->values[stack->size] = value;
+    ++stack->size;
+}
+
+static inline void * stack_pop(struct stack * stack) {
+    return stack->values[--stack->size];
+}
+
+static inline void stack_fini(struct stack * stack) {
+    free(stack->values);
+    *stack = (struct stack) { 0 };
+}